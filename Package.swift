@@ -1,5 +1,12 @@
 // swift-tools-version: 5.9
 import PackageDescription
+import Foundation
+
+// NDI|HX passthrough needs the NDI Advanced SDK: build with NDI_ADVANCED_SDK=1
+// (or point NDI_SDK_DIR at a custom install)
+let ndiAdvanced = ProcessInfo.processInfo.environment["NDI_ADVANCED_SDK"] == "1"
+let ndiSDKDir = ProcessInfo.processInfo.environment["NDI_SDK_DIR"]
+    ?? (ndiAdvanced ? "/Library/NDI Advanced SDK for Apple" : "/Library/NDI SDK for Apple")
 
 let package = Package(
     name: "NDIBridge",
@@ -21,18 +28,24 @@ let package = Package(
             name: "CNDIWrapper",
             dependencies: [],
             cSettings: [
-                .unsafeFlags(["-I/Library/NDI SDK for Apple/include"])
-            ],
+                .unsafeFlags(["-I\(ndiSDKDir)/include"])
+            ] + (ndiAdvanced ? [.define("NDIBRIDGE_NDI_ADVANCED")] : []),
             linkerSettings: [
-                .linkedLibrary("ndi"),
-                .unsafeFlags(["-L/Library/NDI SDK for Apple/lib/macOS"])
+                .linkedLibrary(ndiAdvanced ? "ndi_advanced" : "ndi"),
+                .unsafeFlags(["-L\(ndiSDKDir)/lib/macOS"])
             ]
         ),
         
+        // Atomics for the lock-free capture → encode handoff
+        .target(
+            name: "CAtomics",
+            dependencies: []
+        ),
+
         // Main executable
         .executableTarget(
             name: "NDIBridge",
-            dependencies: ["CNDIWrapper"],
+            dependencies: ["CNDIWrapper", "CAtomics"],
             swiftSettings: [
                 .define("DEBUG", .when(configuration: .debug))
             ]
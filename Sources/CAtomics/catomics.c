@@ -0,0 +1,6 @@
+//
+//  catomics.c
+//  Everything is inline in catomics.h; SwiftPM needs one source file per C target
+//
+
+#include "catomics.h"
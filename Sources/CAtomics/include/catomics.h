@@ -0,0 +1,57 @@
+//
+//  catomics.h
+//  Acquire/release atomics for the lock-free queues and metric counters
+//
+//  Swift 5.9 has no standard atomics without a package dependency; these wrap
+//  the Clang builtins on plain 64-bit words and pointers owned by the caller.
+//
+
+#ifndef catomics_h
+#define catomics_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ============================================================================
+// 64-bit counters / indices
+// ============================================================================
+
+static inline uint64_t catomic_load_acquire(const uint64_t* value) {
+    return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+}
+
+static inline uint64_t catomic_load_relaxed(const uint64_t* value) {
+    return __atomic_load_n(value, __ATOMIC_RELAXED);
+}
+
+static inline void catomic_store_release(uint64_t* value, uint64_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELEASE);
+}
+
+static inline void catomic_store_relaxed(uint64_t* value, uint64_t desired) {
+    __atomic_store_n(value, desired, __ATOMIC_RELAXED);
+}
+
+static inline uint64_t catomic_fetch_add_relaxed(uint64_t* value, uint64_t delta) {
+    return __atomic_fetch_add(value, delta, __ATOMIC_RELAXED);
+}
+
+// Replace *value by desired if it still holds expected; acq_rel on success
+static inline bool catomic_compare_exchange(uint64_t* value, uint64_t expected, uint64_t desired) {
+    return __atomic_compare_exchange_n(value, &expected, desired, false,
+                                       __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+}
+
+// ============================================================================
+// Pointer slots
+// ============================================================================
+
+static inline void* catomic_pointer_load_acquire(void* const* slot) {
+    return __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+}
+
+static inline void catomic_pointer_store_release(void** slot, void* desired) {
+    __atomic_store_n(slot, desired, __ATOMIC_RELEASE);
+}
+
+#endif /* catomics_h */
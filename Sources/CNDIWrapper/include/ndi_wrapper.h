@@ -43,6 +43,28 @@ typedef struct {
     int64_t timestamp;               // Timestamp in 100ns intervals
 } NDIBridgeAudioFrame;
 
+// ============================================================================
+// Compressed Video Packet (NDI|HX elementary stream, Advanced SDK only)
+// ============================================================================
+typedef struct {
+    int32_t codec;                   // 0 = H.264, 1 = HEVC (matches VideoCodec)
+    bool is_keyframe;                // Packet starts a GOP
+    int64_t pts;                     // Presentation time in 100ns intervals
+    const uint8_t* p_data;           // Elementary stream (Annex-B)
+    uint32_t data_size;              // Size of p_data
+    const uint8_t* p_extra_data;     // Parameter sets, Annex-B or avcC/hvcC (keyframes only, can be NULL)
+    uint32_t extra_data_size;        // Size of p_extra_data
+} NDIBridgeCompressedPacket;
+
+// ============================================================================
+// Receive Color Format (subset of NDIlib_recv_color_format_e)
+// ============================================================================
+typedef enum {
+    NDIBRIDGE_COLOR_BGRA = 0,        // BGRX/BGRA: the SDK converts from its native YUV
+    NDIBRIDGE_COLOR_UYVY = 1,        // UYVY, BGRA when the source has alpha
+    NDIBRIDGE_COLOR_FASTEST = 2      // Whatever costs the SDK least (UYVY/UYVA in practice)
+} NDIBridgeColorFormat;
+
 // ============================================================================
 // NDI Source Structure (matches NDIlib_source_t)
 // ============================================================================
@@ -77,6 +99,14 @@ const char* ndi_source_get_name(void* sources, int index);
 // ============================================================================
 
 void* ndi_receiver_create(void);
+
+// Create a receiver delivering uncompressed video in color_format;
+// compressed = true asks for NDI|HX frames as-is (Advanced SDK only), full-bandwidth
+// sources still arriving in color_format
+void* ndi_receiver_create_ex(NDIBridgeColorFormat color_format, bool compressed);
+
+// True when built against the NDI Advanced SDK (compressed receive available)
+bool ndi_supports_compressed_receive(void);
 void ndi_receiver_destroy(void* receiver);
 bool ndi_receiver_connect(void* receiver, void* source);
 
@@ -94,8 +124,18 @@ void ndi_receiver_free_audio(void* receiver, void* audio_frame);
 // ============================================================================
 
 void* ndi_sender_create(const char* name);
+
+// clock_video = true makes video sends block to pace output at the frame rate
+void* ndi_sender_create_ex(const char* name, bool clock_video);
 void ndi_sender_destroy(void* sender);
 void ndi_sender_send_video(void* sender, void* video_frame);
+
+// Returns once the SDK has queued the frame. Its data (and the frame struct) stay in
+// use until the next async or sync video send returns, or until flushed
+void ndi_sender_send_video_async(void* sender, void* video_frame);
+
+// Wait until the SDK no longer uses the last async frame
+void ndi_sender_flush_video_async(void* sender);
 void ndi_sender_send_audio(void* sender, void* audio_frame);
 
 // ============================================================================
@@ -121,6 +161,11 @@ void ndi_video_frame_init(NDIBridgeVideoFrame* frame,
 // Get size of video frame structure (for allocation)
 size_t ndi_video_frame_size(void);
 
+// Extract the H.264/HEVC packet from a captured compressed frame.
+// Returns false for uncompressed frames. Pointers stay valid until the frame is freed.
+bool ndi_video_frame_get_compressed(const NDIBridgeVideoFrame* frame,
+                                    NDIBridgeCompressedPacket* packet);
+
 // ============================================================================
 // Audio Frame Helper Functions
 // ============================================================================
@@ -5,6 +5,9 @@
 
 #include "ndi_wrapper.h"
 #include <Processing.NDI.Lib.h>
+#ifdef NDIBRIDGE_NDI_ADVANCED
+#include <Processing.NDI.Advanced.h>
+#endif
 #include <stdlib.h>
 #include <string.h>
 
@@ -64,11 +67,41 @@ const char* ndi_source_get_name(void* sources, int index) {
 }
 
 void* ndi_receiver_create(void) {
+    return ndi_receiver_create_ex(NDIBRIDGE_COLOR_BGRA, false);
+}
+
+bool ndi_supports_compressed_receive(void) {
+#ifdef NDIBRIDGE_NDI_ADVANCED
+    return true;
+#else
+    return false;
+#endif
+}
+
+void* ndi_receiver_create_ex(NDIBridgeColorFormat color_format, bool compressed) {
     NDIlib_recv_create_v3_t recv_settings;
     memset(&recv_settings, 0, sizeof(recv_settings));
 
     recv_settings.source_to_connect_to.p_ndi_name = NULL;
-    recv_settings.color_format = NDIlib_recv_color_format_BGRX_BGRA;
+    switch (color_format) {
+    case NDIBRIDGE_COLOR_UYVY:
+        recv_settings.color_format = NDIlib_recv_color_format_UYVY_BGRA;
+        break;
+    case NDIBRIDGE_COLOR_FASTEST:
+        recv_settings.color_format = NDIlib_recv_color_format_fastest;
+        break;
+    default:
+        recv_settings.color_format = NDIlib_recv_color_format_BGRX_BGRA;
+        break;
+    }
+#ifdef NDIBRIDGE_NDI_ADVANCED
+    // HX sources arrive untouched; full-bandwidth sources are still decoded by the SDK
+    if (compressed) {
+        recv_settings.color_format = (NDIlib_recv_color_format_e)NDIlib_recv_color_format_compressed_v5;
+    }
+#else
+    (void)compressed;
+#endif
     recv_settings.bandwidth = NDIlib_recv_bandwidth_highest;
     recv_settings.allow_video_fields = false;
     recv_settings.p_ndi_recv_name = "NDI Bridge Receiver";
@@ -120,11 +153,15 @@ void ndi_receiver_free_audio(void* receiver, void* audio_frame) {
 }
 
 void* ndi_sender_create(const char* name) {
+    return ndi_sender_create_ex(name, true);
+}
+
+void* ndi_sender_create_ex(const char* name, bool clock_video) {
     NDIlib_send_create_t send_settings;
     memset(&send_settings, 0, sizeof(send_settings));
 
     send_settings.p_ndi_name = name;
-    send_settings.clock_video = true;
+    send_settings.clock_video = clock_video;
     send_settings.clock_audio = false;
 
     return NDIlib_send_create(&send_settings);
@@ -145,6 +182,22 @@ void ndi_sender_send_video(void* sender, void* video_frame) {
     }
 }
 
+void ndi_sender_send_video_async(void* sender, void* video_frame) {
+    if (sender && video_frame) {
+        NDIlib_send_send_video_async_v2(
+            (NDIlib_send_instance_t)sender,
+            (const NDIlib_video_frame_v2_t*)video_frame
+        );
+    }
+}
+
+void ndi_sender_flush_video_async(void* sender) {
+    if (sender) {
+        // A NULL frame waits for the SDK to release the previous one
+        NDIlib_send_send_video_async_v2((NDIlib_send_instance_t)sender, NULL);
+    }
+}
+
 void ndi_sender_send_audio(void* sender, void* audio_frame) {
     if (sender && audio_frame) {
         NDIlib_send_send_audio_v3(
@@ -197,6 +250,48 @@ size_t ndi_video_frame_size(void) {
     return sizeof(NDIBridgeVideoFrame);
 }
 
+bool ndi_video_frame_get_compressed(const NDIBridgeVideoFrame* frame,
+                                    NDIBridgeCompressedPacket* packet) {
+    if (!frame || !packet || !frame->p_data) return false;
+
+#ifdef NDIBRIDGE_NDI_ADVANCED
+    switch (frame->FourCC) {
+        case NDIlib_FourCC_video_type_ex_H264_highest_bandwidth:
+        case NDIlib_FourCC_video_type_ex_H264_lowest_bandwidth:
+        case NDIlib_FourCC_video_type_ex_HEVC_highest_bandwidth:
+        case NDIlib_FourCC_video_type_ex_HEVC_lowest_bandwidth:
+            break;
+        default:
+            return false;
+    }
+
+    // Compressed frames carry an NDIlib_compressed_packet_t followed by the
+    // stream data and then the extra (parameter set) data. The header is
+    // `version` bytes long: a newer SDK may append fields to the struct
+    const NDIlib_compressed_packet_t* src = (const NDIlib_compressed_packet_t*)frame->p_data;
+    if (src->version < sizeof(NDIlib_compressed_packet_t)) return false;
+    const uint8_t* payload = (const uint8_t*)src + src->version;
+
+    if (src->fourCC == NDIlib_compressed_FourCC_type_H264) {
+        packet->codec = 0;
+    } else if (src->fourCC == NDIlib_compressed_FourCC_type_HEVC) {
+        packet->codec = 1;
+    } else {
+        return false;
+    }
+
+    packet->is_keyframe = (src->flags & NDIlib_compressed_packet_flags_keyframe) != 0;
+    packet->pts = src->pts;
+    packet->p_data = payload;
+    packet->data_size = src->data_size;
+    packet->p_extra_data = src->extra_data_size > 0 ? payload + src->data_size : NULL;
+    packet->extra_data_size = src->extra_data_size;
+    return true;
+#else
+    return false;
+#endif
+}
+
 // ============================================================================
 // Audio Frame Helper Functions
 // ============================================================================
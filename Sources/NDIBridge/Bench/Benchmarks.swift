@@ -0,0 +1,322 @@
+//
+//  Benchmarks.swift
+//  NDI Bridge Mac
+//
+//  Microbenchmarks for hot paths (`ndi-bridge bench [name...]`)
+//
+
+import Foundation
+import QuartzCore
+import CoreVideo
+
+/// Microbenchmark runner
+/// Each benchmark builds its own synthetic input, checks the optimized path against
+/// a reference implementation, then prints throughput for both.
+/// `loopback` is a timed soak run rather than a microbenchmark: it only runs when named
+enum Benchmarks {
+    private static let all: [(name: String, summary: String, run: () -> Void)] = [
+        ("annexb", "Annex-B NAL scanning: SIMD scanner vs byte-by-byte copy", annexB),
+        ("header", "NDIB header serialization: toData vs write(to:) in place", header),
+        ("reassembly", "FrameReassembler.addFragment: 1 MB frame in MTU fragments", reassembly),
+        ("avcc", "EncodedVideoFrame.annexB: AVCC → Annex-B for legacy Joins", avccToAnnexB),
+        ("framecopy", "FrameBuffer.copyPixelBuffer: 1080p NV12 into the pool", frameCopy)
+    ]
+
+    /// Options main.swift already applied to every mode, with their value
+    private static let globalOptions: Set<String> = ["--log-level"]
+
+    private static let loopbackSummary = "Synthetic source → encode → UDP with loss/reorder/jitter → decode (\(LoopbackConfig.usage))"
+
+    static func run(arguments: [String]) {
+        // Names, then `--option value` pairs for the loopback run
+        var requested: [String] = []
+        var options: [String: String] = [:]
+        var remaining = arguments.dropFirst(2).makeIterator()
+        while let argument = remaining.next() {
+            if argument.hasPrefix("--") && argument != "--list" {
+                guard let value = remaining.next() else {
+                    print("❌ Missing value for \(argument)")
+                    exit(1)
+                }
+                if !globalOptions.contains(argument) {
+                    options[argument] = value
+                }
+            } else {
+                requested.append(argument)
+            }
+        }
+
+        if requested.contains("--list") {
+            for benchmark in all {
+                print("  \(benchmark.name.padding(toLength: 12, withPad: " ", startingAt: 0)) \(benchmark.summary)")
+            }
+            print("  \("loopback".padding(toLength: 12, withPad: " ", startingAt: 0)) \(loopbackSummary)")
+            return
+        }
+
+        let selected = requested.isEmpty ? all : all.filter { requested.contains($0.name) }
+        let runsLoopback = requested.contains("loopback")
+        guard !selected.isEmpty || runsLoopback else {
+            print("❌ Unknown benchmark: \(requested.joined(separator: " ")) (use --list)")
+            exit(1)
+        }
+
+        for benchmark in selected {
+            print("▶ \(benchmark.name): \(benchmark.summary)")
+            benchmark.run()
+            print("")
+        }
+
+        if runsLoopback {
+            print("▶ loopback: \(loopbackSummary)")
+            LoopbackSoak.run(options: options)
+            print("")
+        }
+    }
+
+    // MARK: - Harness
+
+    /// Run `body` for `iterations` after a warm-up pass and print time per iteration and throughput
+    private static func measure(_ label: String, iterations: Int, bytesPerIteration: Int, _ body: () -> Int) {
+        var sink = body()  // Warm-up
+
+        let start = CACurrentMediaTime()
+        for _ in 0..<iterations {
+            sink &+= body()
+        }
+        let elapsed = CACurrentMediaTime() - start
+
+        let perIteration = elapsed / Double(iterations) * 1_000_000
+        let throughput = Double(bytesPerIteration * iterations) / elapsed / (1024 * 1024)
+        print("  \(label.padding(toLength: 28, withPad: " ", startingAt: 0)) \(String(format: "%9.1f µs/iter  %8.0f MB/s", perIteration, throughput))  [\(sink % 10)]")
+    }
+
+    // MARK: - Annex-B
+
+    private static func annexB() {
+        let keyframe = syntheticAccessUnit(sliceSizes: [256_000, 256_000, 256_000, 256_000], idr: true)
+        let pFrame = syntheticAccessUnit(sliceSizes: [40_000], idr: false)
+
+        for (label, unit, iterations) in [("IDR 1 MB", keyframe, 200), ("P 40 KB", pFrame, 5000)] {
+            let reference = legacyNALUnits(from: unit).map { $0.count }
+            let scanned = AnnexB.nalUnitRanges(in: unit).map { $0.count }
+            guard reference == scanned else {
+                print("  ❌ \(label): scanner disagrees with reference (\(scanned) vs \(reference))")
+                continue
+            }
+
+            print("  \(label) - \(reference.count) NAL units")
+            measure("legacy [UInt8] + subdata", iterations: iterations, bytesPerIteration: unit.count) {
+                legacyNALUnits(from: unit).count
+            }
+            measure("SIMD16 ranges + slices", iterations: iterations, bytesPerIteration: unit.count) {
+                AnnexB.nalUnitRanges(in: unit).reduce(0) { $0 + unit[$1].count }
+            }
+        }
+    }
+
+    // MARK: - Header
+
+    private static func header() {
+        var packet = MediaPacketHeader()
+        packet.timestamp = 123_456_789
+        packet.totalSize = 1_000_000
+        packet.fragmentCount = 735
+        packet.payloadSize = 1362
+
+        let buffer = UnsafeMutableRawPointer.allocate(byteCount: 1400, alignment: 16)
+        defer { buffer.deallocate() }
+        packet.write(to: buffer)
+        guard packet.toData().elementsEqual(UnsafeRawBufferPointer(start: buffer, count: MediaPacketHeader.size)) else {
+            print("  ❌ toData and write(to:) disagree")
+            return
+        }
+
+        let iterations = 200_000
+        measure("toData (Data per packet)", iterations: iterations, bytesPerIteration: MediaPacketHeader.size) {
+            packet.fragmentIndex &+= 1
+            return packet.toData().count
+        }
+        measure("write(to:) into arena", iterations: iterations, bytesPerIteration: MediaPacketHeader.size) {
+            packet.fragmentIndex &+= 1
+            packet.write(to: buffer)
+            return Int(buffer.load(fromByteOffset: 25, as: UInt8.self))
+        }
+    }
+
+    // MARK: - Reassembly
+
+    private static func reassembly() {
+        let frameSize = 1_000_000
+        let payloadSize = 1400 - MediaPacketHeader.size  // Default sender MTU
+        let frame = Data((0..<frameSize).map { UInt8(truncatingIfNeeded: $0 &* 31) })
+        let fragments = stride(from: 0, to: frameSize, by: payloadSize).map {
+            frame[$0..<min($0 + payloadSize, frameSize)]
+        }
+
+        var header = ParsedMediaHeader()
+        header.version = 2
+        header.totalSize = UInt32(frameSize)
+        header.fragmentCount = UInt16(fragments.count)
+        header.flags = 0x01
+
+        let reassembler = FrameReassembler()
+        func reassemble(now: CFTimeInterval) -> [ReassembledFrame] {
+            header.sequenceNumber &+= 1
+            header.timestamp &+= 166_666
+            var output: [ReassembledFrame] = []
+            for (index, payload) in fragments.enumerated() {
+                header.fragmentIndex = UInt16(index)
+                header.payloadSize = UInt16(payload.count)
+                output += reassembler.addFragment(header: header, payload: payload, now: now)
+            }
+            return output
+        }
+
+        guard let first = reassemble(now: CACurrentMediaTime()).first, first.data == frame else {
+            print("  ❌ Reassembled frame differs from the one sent")
+            return
+        }
+
+        print("  1 MB keyframe - \(fragments.count) fragments of \(payloadSize) bytes")
+        measure("in-order fragments", iterations: 500, bytesPerIteration: frameSize) {
+            reassemble(now: CACurrentMediaTime()).reduce(0) { $0 + $1.data.count }
+        }
+    }
+
+    // MARK: - AVCC
+
+    private static func avccToAnnexB() {
+        let unit = syntheticAccessUnit(sliceSizes: [256_000, 256_000, 256_000, 256_000], idr: true)
+        let nalUnits = AnnexB.nalUnitRanges(in: unit).map { unit[$0] }
+
+        // What VideoToolbox hands the encoder callback: parameter sets apart, slices length-prefixed
+        let parameterSets = Array(nalUnits.prefix(2)).map { Data($0) }
+        var avcc = Data()
+        for slice in nalUnits.dropFirst(2) {
+            withUnsafeBytes(of: UInt32(slice.count).bigEndian) { avcc.append(contentsOf: $0) }
+            avcc.append(slice)
+        }
+        let encoded = EncodedVideoFrame(avcc: avcc, parameterSets: parameterSets, codec: .h264,
+                                        isKeyframe: true, timestamp: 0, duration: 0)
+
+        let roundTrip = AnnexB.nalUnitRanges(in: encoded.annexB()).map { $0.count }
+        guard roundTrip == nalUnits.map({ $0.count }) else {
+            print("  ❌ annexB() does not scan back to the encoded NAL units")
+            return
+        }
+
+        print("  IDR 1 MB - \(nalUnits.count) NAL units")
+        measure("annexB() single copy", iterations: 500, bytesPerIteration: avcc.count) {
+            encoded.annexB().count
+        }
+    }
+
+    // MARK: - Frame copy
+
+    private static func frameCopy() {
+        var created: CVPixelBuffer?
+        let attributes: [String: Any] = [kCVPixelBufferIOSurfacePropertiesKey as String: [String: Any]()]
+        CVPixelBufferCreate(kCFAllocatorDefault, 1920, 1080, kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange,
+                            attributes as CFDictionary, &created)
+        guard let source = created else {
+            print("  ❌ Could not create the NV12 source buffer")
+            return
+        }
+
+        CVPixelBufferLockBaseAddress(source, [])
+        for plane in 0..<CVPixelBufferGetPlaneCount(source) {
+            if let base = CVPixelBufferGetBaseAddressOfPlane(source, plane) {
+                let size = CVPixelBufferGetBytesPerRowOfPlane(source, plane) * CVPixelBufferGetHeightOfPlane(source, plane)
+                memset(base, plane == 0 ? 0x60 : 0x80, size)
+            }
+        }
+        CVPixelBufferUnlockBaseAddress(source, [])
+
+        let buffer = FrameBuffer(bufferMs: 100)
+        guard let copy = buffer.copyPixelBuffer(source),
+              CVPixelBufferGetWidth(copy) == 1920, CVPixelBufferGetPlaneCount(copy) == 2 else {
+            print("  ❌ copyPixelBuffer failed")
+            return
+        }
+
+        let frameBytes = 1920 * 1080 * 3 / 2
+        measure("NV12 1080p plane copy", iterations: 500, bytesPerIteration: frameBytes) {
+            buffer.copyPixelBuffer(source).map { CVPixelBufferGetDataSize($0) } ?? 0
+        }
+    }
+
+    /// SPS + PPS + slices of random payload with emulation prevention applied,
+    /// so the only 00 00 01 patterns are real start codes
+    private static func syntheticAccessUnit(sliceSizes: [Int], idr: Bool) -> Data {
+        var generator = SystemRandomNumberGenerator()
+        var unit = Data()
+
+        func appendNAL(header: UInt8, size: Int) {
+            unit.append(contentsOf: [0, 0, 0, 1, header])
+            var zeros = 0
+            for _ in 0..<size {
+                var byte = UInt8.random(in: 0...255, using: &generator)
+                if byte < 16 { byte = 0 }  // Coded data has plenty of zero runs
+                if zeros >= 2 && byte <= 3 {
+                    unit.append(3)
+                    zeros = 0
+                }
+                unit.append(byte)
+                zeros = byte == 0 ? zeros + 1 : 0
+            }
+            if zeros > 0 { unit.append(0x80) }  // rbsp_stop_one_bit
+        }
+
+        if idr {
+            appendNAL(header: 0x67, size: 20)  // SPS
+            appendNAL(header: 0x68, size: 4)   // PPS
+        }
+        for size in sliceSizes {
+            appendNAL(header: idr ? 0x65 : 0x41, size: size)
+        }
+        return unit
+    }
+
+    /// Previous `VideoDecoder.parseNALUnits`, kept as the reference implementation
+    private static func legacyNALUnits(from data: Data) -> [Data] {
+        var nalUnits: [Data] = []
+        var startIndex = 0
+        let bytes = [UInt8](data)
+
+        var i = 0
+        while i < bytes.count - 3 {
+            if bytes[i] == 0x00 && bytes[i + 1] == 0x00 {
+                var startCodeLength = 0
+
+                if bytes[i + 2] == 0x01 {
+                    startCodeLength = 3
+                } else if i < bytes.count - 3 && bytes[i + 2] == 0x00 && bytes[i + 3] == 0x01 {
+                    startCodeLength = 4
+                }
+
+                if startCodeLength > 0 {
+                    if startIndex < i {
+                        let nalData = data.subdata(in: startIndex..<i)
+                        if !nalData.isEmpty {
+                            nalUnits.append(nalData)
+                        }
+                    }
+                    i += startCodeLength
+                    startIndex = i
+                    continue
+                }
+            }
+            i += 1
+        }
+
+        if startIndex < data.count {
+            let nalData = data.subdata(in: startIndex..<data.count)
+            if !nalData.isEmpty {
+                nalUnits.append(nalData)
+            }
+        }
+
+        return nalUnits
+    }
+}
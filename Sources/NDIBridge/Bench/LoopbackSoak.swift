@@ -0,0 +1,506 @@
+//
+//  LoopbackSoak.swift
+//  NDI Bridge Mac
+//
+//  End-to-end soak run on one machine (`ndi-bridge bench loopback`)
+//
+
+import Foundation
+import Network
+import CoreVideo
+import QuartzCore
+import Darwin
+
+/// Loopback run settings, from `bench loopback` options
+struct LoopbackConfig {
+    var seconds: Double = 10
+    var width = 1920
+    var height = 1080
+    var frameRate = 60
+    var bitrate = 8_000_000
+    var codec: VideoCodec = .h264
+    var loss: Double = 0       // Probability of dropping a Host → Join datagram
+    var reorder: Double = 0    // Probability of holding a datagram back behind the next one
+    var jitterMs: Double = 0   // Extra delay per datagram, uniform in 0...jitterMs
+    var nackMs = 0             // Join retransmission hold (0 = off)
+    var fecGroupSize = 0       // Video FEC: 1 parity per N fragments (0 = off)
+    var port: UInt16 = 15990   // Join port; the impairment relay listens on port + 1
+
+    static let usage = "--seconds <s> --size <WxH> --fps <n> --bitrate <mbps> --codec <h264|hevc> --loss <0-1> --reorder <0-1> --jitter <ms> --nack <ms> --fec <n> --port <port>"
+
+    /// nil (after printing why) on a malformed option
+    init?(options: [String: String]) {
+        for (key, value) in options {
+            switch key {
+            case "--seconds": seconds = Double(value).map { max(1, $0) } ?? seconds
+            case "--size":
+                let parts = value.lowercased().split(separator: "x")
+                guard parts.count == 2, let w = Int(parts[0]), let h = Int(parts[1]), w >= 64, h >= 64 else {
+                    print("❌ Invalid size: \(value) (use WxH)")
+                    return nil
+                }
+                width = w & ~1
+                height = h & ~1
+            case "--fps": frameRate = Int(value).map { min(max(1, $0), 240) } ?? frameRate
+            case "--bitrate": bitrate = Double(value).map { Int($0 * 1_000_000) } ?? bitrate
+            case "--codec":
+                guard let parsed = VideoCodec(name: value) else {
+                    print("❌ Unknown codec: \(value) (use h264 or hevc)")
+                    return nil
+                }
+                codec = parsed
+            case "--loss": loss = Double(value).map { min(max(0, $0), 1) } ?? loss
+            case "--reorder": reorder = Double(value).map { min(max(0, $0), 1) } ?? reorder
+            case "--jitter": jitterMs = Double(value).map { max(0, $0) } ?? jitterMs
+            case "--nack": nackMs = Int(value).map { max(0, $0) } ?? nackMs
+            case "--fec": fecGroupSize = Int(value).map { max(0, $0) } ?? fecGroupSize
+            case "--port": port = UInt16(value) ?? port
+            default:
+                print("❌ Unknown loopback option: \(key) (\(LoopbackConfig.usage))")
+                return nil
+            }
+        }
+    }
+
+    var isImpaired: Bool { loss > 0 || reorder > 0 || jitterMs > 0 }
+}
+
+/// Synthetic BGRA pattern → `VideoEncoder` → `NetworkSender` → impairment relay →
+/// `NetworkReceiver` → `VideoDecoder`, in one process over 127.0.0.1.
+/// The same encode/transport/decode chain as Host and Join mode, without the NDI SDK
+/// on either end, so it runs on any Mac with VideoToolbox. Prints fps, CPU, memory and
+/// capture → decoded latency percentiles every second, then a summary; exits non-zero
+/// when an unimpaired run delivers under 95% of the frames
+final class LoopbackSoak: VideoEncoderDelegate, NetworkSenderDelegate, NetworkReceiverDelegate, VideoDecoderDelegate {
+    private let config: LoopbackConfig
+    private let pattern: PatternGenerator
+    private let encoder = VideoEncoder()
+    private let decoder = VideoDecoder()
+    private let sender: NetworkSender
+    private let receiver: NetworkReceiver
+    private let relay: ImpairmentRelay
+    private let sourceQueue = DispatchQueue(label: "com.ndibridge.bench.source", qos: .userInteractive)
+    private var timer: DispatchSourceTimer?
+
+    // Capture time by timestamp until the frame comes out of the decoder
+    private let lock = NSLock()
+    private var capturedAt: [UInt64: CFTimeInterval] = [:]
+    private var latenciesMs: [Double] = []     // Current second
+    private var allLatenciesMs: [Double] = []
+    private var framesGenerated = 0
+    private var framesDecoded = 0
+    private var decodeErrors = 0
+
+    init(config: LoopbackConfig) {
+        self.config = config
+        self.pattern = PatternGenerator(width: config.width, height: config.height)
+        self.sender = NetworkSender(config: NetworkSenderConfig(
+            host: "127.0.0.1",
+            port: config.port + 1,
+            fecGroupSize: config.fecGroupSize,
+            retransmitWindowMs: config.nackMs > 0 ? 200 : 0,
+            pacingFraction: 0.5,
+            frameRate: Double(config.frameRate)
+        ))
+        self.receiver = NetworkReceiver(port: config.port, nackHoldMs: config.nackMs, capabilities: [.avcc])
+        self.relay = ImpairmentRelay(config: config)
+    }
+
+    static func run(options: [String: String]) {
+        guard let config = LoopbackConfig(options: options) else { exit(1) }
+        let soak = LoopbackSoak(config: config)
+        guard soak.start() else { exit(1) }
+        let passed = soak.monitor()
+        soak.stop()
+        if !passed { exit(1) }
+    }
+
+    // MARK: - Run
+
+    private func start() -> Bool {
+        print(String(format: "  %dx%d@%d %@ %.1f Mbps, loss %.1f%%, reorder %.1f%%, jitter %.0f ms, NACK %d ms, FEC 1/%d, %.0f s",
+                     config.width, config.height, config.frameRate, config.codec.name, Double(config.bitrate) / 1_000_000,
+                     config.loss * 100, config.reorder * 100, config.jitterMs, config.nackMs, config.fecGroupSize, config.seconds))
+
+        var encoderConfig = VideoEncoderConfig()
+        encoderConfig.width = Int32(config.width)
+        encoderConfig.height = Int32(config.height)
+        encoderConfig.frameRate = Float64(config.frameRate)
+        encoderConfig.bitrate = config.bitrate
+        encoderConfig.keyframeInterval = config.frameRate * 2
+        encoderConfig.codec = config.codec
+
+        encoder.delegate = self
+        decoder.delegate = self
+        sender.delegate = self
+        receiver.delegate = self
+        do {
+            try encoder.configure(config: encoderConfig)
+            try receiver.startListening()
+            try relay.start()
+        } catch {
+            print("  ❌ Loopback setup failed: \(error.localizedDescription)")
+            return false
+        }
+        sender.setPacingBitrate(config.bitrate)
+        sender.connect()
+
+        let interval = 1.0 / Double(config.frameRate)
+        let timer = DispatchSource.makeTimerSource(flags: .strict, queue: sourceQueue)
+        timer.schedule(deadline: .now() + 0.5, repeating: interval, leeway: .microseconds(200))
+        timer.setEventHandler { [weak self] in self?.produceFrame() }
+        timer.resume()
+        self.timer = timer
+        return true
+    }
+
+    private func stop() {
+        timer?.cancel()
+        timer = nil
+        sourceQueue.sync {}
+        encoder.flush()
+        Thread.sleep(forTimeInterval: 0.5)  // Let the last frames drain through the relay
+        sender.disconnect()
+        relay.stop()
+        receiver.stop()
+        encoder.invalidate()
+        decoder.invalidate()
+    }
+
+    /// Per-second report, then the summary; false when an unimpaired run lost frames
+    private func monitor() -> Bool {
+        let start = CACurrentMediaTime()
+        let startCPU = LoopbackSoak.cpuSeconds()
+        var lastCPU = startCPU
+        var lastDecoded = 0
+        var peakFootprint: UInt64 = 0
+
+        print("    time     fps    cpu    memory    p50 ms   p95 ms   p99 ms")
+        while CACurrentMediaTime() - start < config.seconds + 0.5 {
+            Thread.sleep(forTimeInterval: 1.0)
+
+            lock.lock()
+            let decoded = framesDecoded
+            let second = latenciesMs
+            allLatenciesMs.append(contentsOf: latenciesMs)
+            latenciesMs.removeAll(keepingCapacity: true)
+            lock.unlock()
+
+            let cpu = LoopbackSoak.cpuSeconds()
+            let footprint = LoopbackSoak.footprintBytes()
+            peakFootprint = max(peakFootprint, footprint)
+            print(String(format: "  %5.0fs  %6d  %4.0f%%  %6.1f MB  %7.1f  %7.1f  %7.1f",
+                         CACurrentMediaTime() - start, decoded - lastDecoded, (cpu - lastCPU) * 100,
+                         Double(footprint) / (1024 * 1024),
+                         LoopbackSoak.percentile(second, 0.5), LoopbackSoak.percentile(second, 0.95),
+                         LoopbackSoak.percentile(second, 0.99)))
+            lastDecoded = decoded
+            lastCPU = cpu
+        }
+
+        let elapsed = CACurrentMediaTime() - start
+        lock.lock()
+        let generated = framesGenerated
+        let decoded = framesDecoded
+        let errors = decodeErrors
+        let latencies = allLatenciesMs
+        lock.unlock()
+
+        let delivered = generated > 0 ? Double(decoded) / Double(generated) : 0
+        print(String(format: "  Frames: %d generated, %d decoded (%.1f%%), %d decode errors", generated, decoded, delivered * 100, errors))
+        print(String(format: "  Relay: %d forwarded, %d dropped, %d reordered", relay.forwarded, relay.dropped, relay.reordered))
+        print(String(format: "  Average: %.1f fps, %.0f%% CPU, peak %.1f MB",
+                     Double(decoded) / elapsed, (LoopbackSoak.cpuSeconds() - startCPU) / elapsed * 100,
+                     Double(peakFootprint) / (1024 * 1024)))
+        print(String(format: "  Latency capture → decoded: p50 %.1f ms, p95 %.1f ms, p99 %.1f ms, max %.1f ms",
+                     LoopbackSoak.percentile(latencies, 0.5), LoopbackSoak.percentile(latencies, 0.95),
+                     LoopbackSoak.percentile(latencies, 0.99), latencies.max() ?? 0))
+
+        guard config.isImpaired || delivered >= 0.95 else {
+            print("  ❌ Unimpaired link delivered under 95% of the frames")
+            return false
+        }
+        return true
+    }
+
+    private func produceFrame() {
+        guard let pixelBuffer = pattern.frame() else { return }
+        let timestamp = UInt64(pattern.frameIndex) * 10_000_000 / UInt64(config.frameRate)
+
+        lock.lock()
+        framesGenerated += 1
+        capturedAt[timestamp] = CACurrentMediaTime()
+        if capturedAt.count > 4 * config.frameRate {
+            // Frames lost for good never come out of the decoder
+            let horizon = CACurrentMediaTime() - 2
+            capturedAt = capturedAt.filter { $0.value > horizon }
+        }
+        lock.unlock()
+
+        do {
+            try encoder.encode(pixelBuffer: pixelBuffer, timestamp: timestamp)
+        } catch {
+            print("  ❌ Encode failed: \(error.localizedDescription)")
+        }
+    }
+
+    // MARK: - Measurements
+
+    private static func cpuSeconds() -> Double {
+        var usage = rusage()
+        getrusage(RUSAGE_SELF, &usage)
+        func seconds(_ time: timeval) -> Double { Double(time.tv_sec) + Double(time.tv_usec) / 1_000_000 }
+        return seconds(usage.ru_utime) + seconds(usage.ru_stime)
+    }
+
+    /// Physical footprint, as Activity Monitor's "Memory" column
+    private static func footprintBytes() -> UInt64 {
+        var info = task_vm_info_data_t()
+        var count = mach_msg_type_number_t(MemoryLayout<task_vm_info_data_t>.size / MemoryLayout<integer_t>.size)
+        let result = withUnsafeMutablePointer(to: &info) {
+            $0.withMemoryRebound(to: integer_t.self, capacity: Int(count)) {
+                task_info(mach_task_self_, task_flavor_t(TASK_VM_INFO), $0, &count)
+            }
+        }
+        return result == KERN_SUCCESS ? info.phys_footprint : 0
+    }
+
+    private static func percentile(_ values: [Double], _ fraction: Double) -> Double {
+        guard !values.isEmpty else { return 0 }
+        let sorted = values.sorted()
+        return sorted[min(sorted.count - 1, Int(Double(sorted.count - 1) * fraction + 0.5))]
+    }
+
+    // MARK: - VideoEncoderDelegate
+
+    func videoEncoder(_ encoder: VideoEncoder, didEncodeFrame frame: EncodedVideoFrame) {
+        sender.send(frame: frame)
+    }
+
+    func videoEncoder(_ encoder: VideoEncoder, didFailWithError error: Error) {
+        print("  ❌ Encoder error: \(error.localizedDescription)")
+    }
+
+    // MARK: - NetworkSenderDelegate
+
+    func networkSender(_ sender: NetworkSender, didConnect endpoint: NWEndpoint) {}
+
+    func networkSender(_ sender: NetworkSender, didDisconnect error: Error?) {}
+
+    func networkSender(_ sender: NetworkSender, didUpdateStats bytesSent: UInt64, packetsent: UInt64) {}
+
+    func networkSender(_ sender: NetworkSender, didReceiveKeyframeRequest sourceId: UInt8, layer: UInt8) {
+        encoder.forceKeyframe()
+    }
+
+    // MARK: - NetworkReceiverDelegate
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveVideoFrame frame: ReassembledFrame) {
+        do {
+            if frame.isAVCC {
+                try decoder.decode(avcc: frame.data, timestamp: frame.timestamp, codec: frame.codec)
+            } else {
+                try decoder.decode(data: frame.data, timestamp: frame.timestamp, codec: frame.codec)
+            }
+        } catch VideoDecoderError.noParameterSets {
+            receiver.requestKeyframe(sourceId: frame.sourceId)
+        } catch {
+            lock.lock()
+            decodeErrors += 1
+            lock.unlock()
+        }
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveParameterSets parameterSets: [Data], codec: VideoCodec, sourceId: UInt8) {
+        try? decoder.setParameterSets(parameterSets, codec: codec)
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didDisconnect error: Error?) {}
+
+    // MARK: - VideoDecoderDelegate
+
+    func videoDecoder(_ decoder: VideoDecoder, didDecodeFrame pixelBuffer: CVPixelBuffer, timestamp: UInt64) {
+        let now = CACurrentMediaTime()
+        lock.lock()
+        framesDecoded += 1
+        if let captured = capturedAt.removeValue(forKey: timestamp) {
+            latenciesMs.append((now - captured) * 1000)
+        }
+        lock.unlock()
+    }
+
+    func videoDecoder(_ decoder: VideoDecoder, didFailWithError error: Error) {
+        lock.lock()
+        decodeErrors += 1
+        lock.unlock()
+    }
+}
+
+/// Scrolling BGRA colour bars plus a moving block, so every frame carries motion.
+/// Rows are copied from one wide template row, which keeps 4K60 generation cheap
+private final class PatternGenerator {
+    let width: Int
+    let height: Int
+    private(set) var frameIndex = 0
+    private var pool: CVPixelBufferPool?
+    private var template: [UInt32]
+
+    private static let barWidth = 64
+    private static let palette: [UInt32] = [  // BGRA little-endian: 0xAARRGGBB
+        0xFFC0C0C0, 0xFFC0C000, 0xFF00C0C0, 0xFF00C000, 0xFFC000C0, 0xFFC00000, 0xFF0000C0, 0xFF101010
+    ]
+    private static var period: Int { barWidth * palette.count }
+
+    init(width: Int, height: Int) {
+        self.width = width
+        self.height = height
+        template = (0..<(width + PatternGenerator.period)).map {
+            PatternGenerator.palette[($0 / PatternGenerator.barWidth) % PatternGenerator.palette.count]
+        }
+
+        let attributes: [String: Any] = [
+            kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_32BGRA,
+            kCVPixelBufferWidthKey as String: width,
+            kCVPixelBufferHeightKey as String: height,
+            kCVPixelBufferIOSurfacePropertiesKey as String: [String: Any]()
+        ]
+        CVPixelBufferPoolCreate(kCFAllocatorDefault, nil, attributes as CFDictionary, &pool)
+    }
+
+    func frame() -> CVPixelBuffer? {
+        var created: CVPixelBuffer?
+        guard let pool = pool,
+              CVPixelBufferPoolCreatePixelBuffer(kCFAllocatorDefault, pool, &created) == kCVReturnSuccess,
+              let pixelBuffer = created else {
+            return nil
+        }
+        frameIndex += 1
+
+        CVPixelBufferLockBaseAddress(pixelBuffer, [])
+        defer { CVPixelBufferUnlockBaseAddress(pixelBuffer, []) }
+        guard let base = CVPixelBufferGetBaseAddress(pixelBuffer) else { return nil }
+        let bytesPerRow = CVPixelBufferGetBytesPerRow(pixelBuffer)
+
+        let shift = (frameIndex * 8) % PatternGenerator.period
+        let block = min(128, width / 4, height / 4)
+        let blockX = (frameIndex * 16) % (width - block)
+        let blockY = (height - block) / 2
+        var white: UInt32 = 0xFFFFFFFF
+
+        template.withUnsafeBytes { (row: UnsafeRawBufferPointer) in
+            for y in 0..<height {
+                let line = base.advanced(by: y * bytesPerRow)
+                line.copyMemory(from: row.baseAddress!.advanced(by: shift * 4), byteCount: width * 4)
+                if y >= blockY && y < blockY + block {
+                    memset_pattern4(line.advanced(by: blockX * 4), &white, block * 4)
+                }
+            }
+        }
+        return pixelBuffer
+    }
+}
+
+/// UDP relay between `NetworkSender` and `NetworkReceiver` that impairs the media
+/// direction: random loss, one-packet reordering and uniform jitter. Control messages
+/// (NACKs, hellos, clock exchanges) pass untouched both ways
+private final class ImpairmentRelay {
+    private let config: LoopbackConfig
+    private let queue = DispatchQueue(label: "com.ndibridge.bench.relay", qos: .userInteractive)
+    private var listener: NWListener?
+    private var upstream: NWConnection?    // From the Host side
+    private var downstream: NWConnection?  // To the Join side
+    private var held: Data?
+
+    // Updated on `queue`; read once the run is over
+    private(set) var forwarded = 0
+    private(set) var dropped = 0
+    private(set) var reordered = 0
+
+    init(config: LoopbackConfig) {
+        self.config = config
+    }
+
+    func start() throws {
+        guard let listenPort = NWEndpoint.Port(rawValue: config.port + 1),
+              let joinPort = NWEndpoint.Port(rawValue: config.port) else {
+            throw NSError(domain: "LoopbackSoak", code: -1, userInfo: [NSLocalizedDescriptionKey: "Invalid port"])
+        }
+
+        let listener = try NWListener(using: .udp, on: listenPort)
+        listener.newConnectionHandler = { [weak self] connection in
+            self?.accept(connection)
+        }
+        listener.start(queue: queue)
+        self.listener = listener
+
+        let downstream = NWConnection(host: "127.0.0.1", port: joinPort, using: .udp)
+        downstream.start(queue: queue)
+        self.downstream = downstream
+        receive(on: downstream) { [weak self] packet in
+            self?.upstream?.send(content: packet, completion: .idempotent)
+        }
+    }
+
+    func stop() {
+        queue.sync {
+            listener?.cancel()
+            upstream?.cancel()
+            downstream?.cancel()
+            listener = nil
+            upstream = nil
+            downstream = nil
+        }
+    }
+
+    private func accept(_ connection: NWConnection) {
+        upstream?.cancel()
+        upstream = connection
+        connection.start(queue: queue)
+        receive(on: connection) { [weak self] packet in
+            self?.impair(packet)
+        }
+    }
+
+    private func receive(on connection: NWConnection, handler: @escaping (Data) -> Void) {
+        connection.receiveMessage { [weak self] content, _, _, error in
+            if let packet = content {
+                handler(packet)
+            }
+            guard error == nil else { return }
+            self?.receive(on: connection, handler: handler)
+        }
+    }
+
+    private func impair(_ packet: Data) {
+        guard !ControlMessage.isControlPacket(packet) else {
+            downstream?.send(content: packet, completion: .idempotent)
+            return
+        }
+        if Double.random(in: 0..<1) < config.loss {
+            dropped += 1
+            return
+        }
+        if held == nil && Double.random(in: 0..<1) < config.reorder {
+            held = packet
+            reordered += 1
+            return
+        }
+        deliver(packet)
+        if let late = held {
+            held = nil
+            deliver(late)
+        }
+    }
+
+    private func deliver(_ packet: Data) {
+        forwarded += 1
+        guard config.jitterMs > 0 else {
+            downstream?.send(content: packet, completion: .idempotent)
+            return
+        }
+        let delay = Double.random(in: 0...config.jitterMs) / 1000
+        queue.asyncAfter(deadline: .now() + delay) { [weak self] in
+            self?.downstream?.send(content: packet, completion: .idempotent)
+        }
+    }
+}
@@ -0,0 +1,123 @@
+//
+//  AnnexB.swift
+//  NDI Bridge Mac
+//
+//  Vectorized Annex-B start code scanner
+//
+
+import Foundation
+
+/// H.264/HEVC Annex-B byte stream helpers
+enum AnnexB {
+    /// Ranges of the NAL units in `data`, start codes excluded, expressed in `data`'s
+    /// own index space so `data[range]` is a slice sharing the original storage
+    static func nalUnitRanges(in data: Data) -> [Range<Data.Index>] {
+        let base = data.startIndex
+        return data.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) in
+            nalUnitRanges(in: bytes).map { (base + $0.lowerBound)..<(base + $0.upperBound) }
+        }
+    }
+
+    /// Ranges of the NAL units in `bytes`, start codes (00 00 01 or 00 00 00 01) excluded.
+    /// Bytes before the first start code, if any, are returned as a NAL unit
+    ///
+    /// The scan runs 16 bytes at a time looking for 0x01 bytes; only chunks that contain
+    /// one are inspected lane by lane for the two preceding zero bytes. In coded slice
+    /// data 0x01 shows up in roughly one chunk out of sixteen, and the emulation
+    /// prevention rule guarantees the 00 00 01 pattern never appears inside a NAL
+    static func nalUnitRanges(in bytes: UnsafeRawBufferPointer) -> [Range<Int>] {
+        var ranges: [Range<Int>] = []
+        let count = bytes.count
+        guard count > 0 else { return ranges }
+
+        var nalStart = 0
+
+        func startCode(endingAt position: Int) {
+            // 0x01 at `position` preceded by 00 00 (and possibly a third 00)
+            var codeStart = position - 2
+            if codeStart > nalStart && bytes[codeStart - 1] == 0 {
+                codeStart -= 1
+            }
+            if codeStart > nalStart {
+                ranges.append(nalStart..<codeStart)
+            }
+            nalStart = position + 1
+        }
+
+        func isStartCode(at position: Int) -> Bool {
+            return position >= 2 && bytes[position - 1] == 0 && bytes[position - 2] == 0
+        }
+
+        let ones = SIMD16<UInt8>(repeating: 1)
+        var i = 0
+        while i + 16 <= count {
+            let chunk = bytes.loadUnaligned(fromByteOffset: i, as: SIMD16<UInt8>.self)
+            if any(chunk .== ones) {
+                for lane in 0..<16 where chunk[lane] == 1 && isStartCode(at: i + lane) {
+                    startCode(endingAt: i + lane)
+                }
+            }
+            i += 16
+        }
+        while i < count {
+            if bytes[i] == 1 && isStartCode(at: i) {
+                startCode(endingAt: i)
+            }
+            i += 1
+        }
+
+        if nalStart < count {
+            ranges.append(nalStart..<count)
+        }
+        return ranges
+    }
+
+    /// Parameter sets of an ISO/IEC 14496-15 decoder configuration record (avcC for
+    /// H.264, hvcC for HEVC), in record order. nil when `bytes` is not a well-formed record
+    static func parameterSets(fromConfigurationRecord bytes: UnsafeRawBufferPointer, codec: VideoCodec) -> [Range<Int>]? {
+        var offset = 0
+        var sets: [Range<Int>] = []
+
+        func readByte() -> Int? {
+            guard offset < bytes.count else { return nil }
+            defer { offset += 1 }
+            return Int(bytes[offset])
+        }
+        func readLength() -> Int? {
+            guard let high = readByte(), let low = readByte() else { return nil }
+            return high << 8 | low
+        }
+        func readNAL() -> Bool {
+            guard let length = readLength(), length > 0, offset + length <= bytes.count else { return false }
+            sets.append(offset..<(offset + length))
+            offset += length
+            return true
+        }
+
+        // configurationVersion is 1 in both records; Annex-B starts with 0
+        guard bytes.count > 6, bytes[0] == 1 else { return nil }
+
+        switch codec {
+        case .h264:
+            offset = 5
+            guard let spsCount = readByte().map({ $0 & 0x1F }) else { return nil }
+            for _ in 0..<spsCount {
+                guard readNAL() else { return nil }
+            }
+            guard let ppsCount = readByte() else { return nil }
+            for _ in 0..<ppsCount {
+                guard readNAL() else { return nil }
+            }
+        case .hevc:
+            offset = 22
+            guard let arrayCount = readByte() else { return nil }
+            for _ in 0..<arrayCount {
+                guard readByte() != nil, let nalCount = readLength() else { return nil }
+                for _ in 0..<nalCount {
+                    guard readNAL() else { return nil }
+                }
+            }
+        }
+        return sets.isEmpty ? nil : sets
+    }
+}
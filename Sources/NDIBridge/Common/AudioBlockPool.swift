@@ -0,0 +1,71 @@
+//
+//  AudioBlockPool.swift
+//  NDI Bridge Mac
+//
+//  Recycled PCM blocks shared by every audio stage, handed out as Data
+//
+
+import Foundation
+
+/// Free lists of audio blocks in power-of-two size classes.
+/// A block is wrapped in a `Data` whose deallocator puts it back on its free list, so
+/// it travels through the pipeline (sender, retransmit history, reassembler, delay
+/// buffer, NDI output) like any other payload and returns to the pool when the last
+/// stage drops it. Steady-state audio thus reuses the same few blocks per stream
+final class AudioBlockPool {
+    static let shared = AudioBlockPool()
+
+    private static let minClass = 10          // 1 KB
+    private static let maxClass = 20          // 1 MB: larger requests are not pooled
+    private static let maxPooledPerClass = 16 // ~ a delay buffer's worth of one stream
+
+    private var free: [[UnsafeMutableRawPointer]]
+    private let lock = NSLock()
+
+    private init() {
+        free = Array(repeating: [], count: AudioBlockPool.maxClass - AudioBlockPool.minClass + 1)
+    }
+
+    /// Block of at least `count` bytes, contents undefined, exposed as a `count`-byte Data.
+    /// `fill` writes the block before it is wrapped
+    func data(count: Int, fill: (UnsafeMutableRawPointer) -> Void) -> Data {
+        guard count > 0 else { return Data() }
+        guard let sizeClass = AudioBlockPool.sizeClass(of: count) else {
+            var data = Data(count: count)
+            data.withUnsafeMutableBytes { fill($0.baseAddress!) }
+            return data
+        }
+
+        let block = acquire(sizeClass)
+        fill(block)
+        return Data(bytesNoCopy: block, count: count, deallocator: .custom { [self] pointer, _ in
+            recycle(pointer, sizeClass: sizeClass)
+        })
+    }
+
+    // MARK: - Private Helpers
+
+    private func acquire(_ sizeClass: Int) -> UnsafeMutableRawPointer {
+        lock.lock()
+        let block = free[sizeClass - AudioBlockPool.minClass].popLast()
+        lock.unlock()
+        return block ?? .allocate(byteCount: 1 << sizeClass, alignment: 16)
+    }
+
+    private func recycle(_ block: UnsafeMutableRawPointer, sizeClass: Int) {
+        lock.lock()
+        let index = sizeClass - AudioBlockPool.minClass
+        if free[index].count < AudioBlockPool.maxPooledPerClass {
+            free[index].append(block)
+            lock.unlock()
+        } else {
+            lock.unlock()
+            block.deallocate()
+        }
+    }
+
+    private static func sizeClass(of count: Int) -> Int? {
+        let needed = max(minClass, Int.bitWidth - (count - 1).leadingZeroBitCount)
+        return needed <= maxClass ? needed : nil
+    }
+}
@@ -0,0 +1,111 @@
+//
+//  AudioCodec.swift
+//  NDI Bridge Mac
+//
+//  Audio codecs carried in the NDIB header (byte 36 of audio packets)
+//
+
+import Foundation
+import AudioToolbox
+
+/// Codec of an audio frame. PCM frames carry samples (planar float or, with
+/// `pcm16Flag`, interleaved int16); compressed frames carry `AudioPacketGroup`
+enum AudioCodec: UInt8 {
+    case pcm = 0
+    case aacELD = 1
+
+    init?(name: String) {
+        switch name.lowercased() {
+        case "pcm", "none": self = .pcm
+        case "aac-eld", "aaceld", "eld": self = .aacELD
+        default: return nil
+        }
+    }
+
+    var name: String {
+        switch self {
+        case .pcm: return "PCM"
+        case .aacELD: return "AAC-ELD"
+        }
+    }
+
+    var formatID: AudioFormatID {
+        switch self {
+        case .pcm: return kAudioFormatLinearPCM
+        case .aacELD: return kAudioFormatMPEG4AAC_ELD
+        }
+    }
+
+    /// Samples per channel in one compressed packet
+    var framesPerPacket: Int {
+        switch self {
+        case .pcm: return 1
+        case .aacELD: return 512
+        }
+    }
+
+    /// Capability a receiver must advertise to be sent this codec
+    var capability: ReceiverCapabilities {
+        switch self {
+        case .pcm: return []
+        case .aacELD: return .aacELD
+        }
+    }
+}
+
+/// Payload of a compressed audio frame: u8 cookie length + magic cookie (empty except
+/// on the first frame and about once a second, so a late Join can start decoding),
+/// u16 packet count, u16 size per packet, then the packets back to back
+enum AudioPacketGroup {
+    /// Size of the payload for `packetBytes` bytes of `packetCount` packets
+    static func size(cookie: Int, packetCount: Int, packetBytes: Int) -> Int {
+        return 1 + cookie + 2 + 2 * packetCount + packetBytes
+    }
+
+    /// Write the header part; the packets go at the returned offset
+    static func writeHeader(to base: UnsafeMutableRawPointer, cookie: Data, packetSizes: [UInt32]) -> Int {
+        var offset = 0
+        base.storeBytes(of: UInt8(cookie.count), toByteOffset: offset, as: UInt8.self)
+        offset += 1
+        cookie.withUnsafeBytes { bytes in
+            if let source = bytes.baseAddress {
+                base.advanced(by: offset).copyMemory(from: source, byteCount: bytes.count)
+            }
+        }
+        offset += cookie.count
+        base.storeBytes(of: UInt16(packetSizes.count).bigEndian, toByteOffset: offset, as: UInt16.self)
+        offset += 2
+        for size in packetSizes {
+            base.storeBytes(of: UInt16(size).bigEndian, toByteOffset: offset, as: UInt16.self)
+            offset += 2
+        }
+        return offset
+    }
+
+    /// Cookie and packet descriptions of `payload`, offsets relative to `packetsOffset`.
+    /// `descriptions` is cleared and refilled so the caller can reuse its storage
+    static func parse(_ payload: UnsafeRawBufferPointer,
+                      descriptions: inout [AudioStreamPacketDescription]) -> (cookie: UnsafeRawBufferPointer, packetsOffset: Int)? {
+        descriptions.removeAll(keepingCapacity: true)
+        guard payload.count >= 3 else { return nil }
+
+        let cookieLength = Int(payload[0])
+        var offset = 1 + cookieLength
+        guard offset + 2 <= payload.count else { return nil }
+        let cookie = UnsafeRawBufferPointer(rebasing: payload[1..<offset])
+        let count = Int(payload[offset]) << 8 | Int(payload[offset + 1])
+        offset += 2
+
+        let packetsOffset = offset + 2 * count
+        guard packetsOffset <= payload.count else { return nil }
+        var start = 0
+        for index in 0..<count {
+            let size = Int(payload[offset + 2 * index]) << 8 | Int(payload[offset + 2 * index + 1])
+            descriptions.append(AudioStreamPacketDescription(mStartOffset: Int64(start), mVariableFramesInPacket: 0,
+                                                             mDataByteSize: UInt32(size)))
+            start += size
+        }
+        guard packetsOffset + start <= payload.count else { return nil }
+        return (cookie, packetsOffset)
+    }
+}
@@ -6,79 +6,218 @@
 //
 
 import Foundation
-import os.log
+import os
+import CAtomics
 
 /// Logging subsystems for different components
-enum LogSubsystem: String {
+enum LogSubsystem: String, CaseIterable {
     case host = "com.ndibridge.host"
     case join = "com.ndibridge.join"
     case ndi = "com.ndibridge.ndi"
     case video = "com.ndibridge.video"
     case network = "com.ndibridge.network"
+
+    /// Short name shown on the console and accepted by `--log-level`
+    var name: String {
+        switch self {
+        case .host: return "host"
+        case .join: return "join"
+        case .ndi: return "ndi"
+        case .video: return "video"
+        case .network: return "network"
+        }
+    }
+
+    fileprivate var index: Int {
+        switch self {
+        case .host: return 0
+        case .join: return 1
+        case .ndi: return 2
+        case .video: return 3
+        case .network: return 4
+        }
+    }
 }
 
-/// Log levels with emoji prefixes for terminal visibility
-enum LogLevel: String {
+/// Log levels with emoji prefixes for terminal visibility, by increasing severity
+enum LogLevel: String, CaseIterable {
     case debug = "🔍"
     case info = "ℹ️"
     case success = "✅"
     case warning = "⚠️"
     case error = "❌"
     case fatal = "💀"
+
+    var severity: UInt64 {
+        switch self {
+        case .debug: return 0
+        case .info: return 1
+        case .success: return 2
+        case .warning: return 3
+        case .error: return 4
+        case .fatal: return 5
+        }
+    }
+
+    var name: String {
+        switch self {
+        case .debug: return "debug"
+        case .info: return "info"
+        case .success: return "success"
+        case .warning: return "warning"
+        case .error: return "error"
+        case .fatal: return "fatal"
+        }
+    }
+
+    init?(name: String) {
+        guard let level = LogLevel.allCases.first(where: { $0.name == name.lowercased() }) else { return nil }
+        self = level
+    }
+
+    fileprivate var osLogType: OSLogType {
+        switch self {
+        case .debug: return .debug
+        case .info, .success: return .info
+        case .warning: return .default
+        case .error: return .error
+        case .fatal: return .fault
+        }
+    }
 }
 
-/// Thread-safe logger with timestamps and component identification
+/// Thread-safe logger with timestamps and component identification.
+/// Cheap on hot paths: the level check is one relaxed atomic load, messages are
+/// `@autoclosure`s built only once a line is actually emitted, and each call site is
+/// rate limited so a per-packet warning under loss cannot flood the process.
+/// Lines go to os_log (Console.app, `log stream`) and to stdout from a utility queue
 final class BridgeLogger {
     static let shared = BridgeLogger()
 
-    private let dateFormatter: DateFormatter
+    /// Per call site: at most `rateLimitBurst` lines per `rateLimitWindow`, the rest is
+    /// counted and reported on the next line of that site
+    static let rateLimitBurst = 20
+    static let rateLimitWindow: TimeInterval = 1.0
+
+    private struct Site: Hashable {
+        let file: UInt
+        let line: Int
+    }
+
+    private struct SiteState {
+        let filename: String
+        var windowStart: TimeInterval
+        var emitted: Int
+        var suppressed: Int
+    }
+
     private let queue = DispatchQueue(label: "com.ndibridge.logger", qos: .utility)
+    private let levels: UnsafeMutablePointer<UInt64>  // Minimum severity per subsystem
+    private let osLoggers: [os.Logger]
+    private var sites: [Site: SiteState] = [:]
+    private let sitesLock = NSLock()
+
+    var consoleOutput = true  // Also print to stdout (os_log always receives the line)
 
-    var isVerbose = true
+    /// Debug lines enabled on any subsystem; setting it applies debug/info everywhere
+    var isVerbose: Bool {
+        get { LogSubsystem.allCases.contains { minimumLevel(for: $0) == .debug } }
+        set { setLevel(newValue ? .debug : .info) }
+    }
 
     private init() {
-        dateFormatter = DateFormatter()
-        dateFormatter.dateFormat = "HH:mm:ss.SSS"
+        levels = .allocate(capacity: LogSubsystem.allCases.count)
+        levels.initialize(repeating: LogLevel.debug.severity, count: LogSubsystem.allCases.count)
+        osLoggers = LogSubsystem.allCases.map { os.Logger(subsystem: $0.rawValue, category: "bridge") }
+    }
+
+    deinit {
+        levels.deallocate()
+    }
+
+    // MARK: - Levels
+
+    func setLevel(_ level: LogLevel, for subsystem: LogSubsystem? = nil) {
+        for target in subsystem.map({ [$0] }) ?? LogSubsystem.allCases {
+            catomic_store_relaxed(levels + target.index, level.severity)
+        }
+    }
+
+    func minimumLevel(for subsystem: LogSubsystem) -> LogLevel {
+        let severity = catomic_load_relaxed(levels + subsystem.index)
+        return LogLevel.allCases.first { $0.severity == severity } ?? .debug
+    }
+
+    @inline(__always)
+    func isEnabled(_ level: LogLevel, subsystem: LogSubsystem) -> Bool {
+        return level.severity >= catomic_load_relaxed(levels + subsystem.index)
     }
 
-    func log(_ level: LogLevel, subsystem: LogSubsystem, message: String, file: String = #file, function: String = #function, line: Int = #line) {
-        guard isVerbose || level != .debug else { return }
+    /// `--log-level` argument: `info`, or per subsystem `network=warning,video=debug`
+    /// (a bare level applies to every subsystem). Returns false on an unknown name
+    func configureLevels(_ spec: String) -> Bool {
+        var changes: [(LogLevel, LogSubsystem?)] = []
+        for item in spec.split(separator: ",") {
+            let parts = item.split(separator: "=", maxSplits: 1).map { String($0).trimmingCharacters(in: .whitespaces) }
+            if parts.count == 1, let level = LogLevel(name: parts[0]) {
+                changes.append((level, nil))
+            } else if parts.count == 2,
+                      let subsystem = LogSubsystem.allCases.first(where: { $0.name == parts[0].lowercased() }),
+                      let level = LogLevel(name: parts[1]) {
+                changes.append((level, subsystem))
+            } else {
+                return false
+            }
+        }
+        guard !changes.isEmpty else { return false }
+        changes.forEach { setLevel($0.0, for: $0.1) }
+        return true
+    }
 
-        queue.async { [weak self] in
-            guard let self = self else { return }
+    // MARK: - Logging
 
-            let timestamp = self.dateFormatter.string(from: Date())
-            let filename = (file as NSString).lastPathComponent.replacingOccurrences(of: ".swift", with: "")
+    func log(_ level: LogLevel, subsystem: LogSubsystem, message: @autoclosure () -> String,
+             file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        guard isEnabled(level, subsystem: subsystem) else { return }
 
-            let logMessage = "\(timestamp) \(level.rawValue) [\(subsystem.rawValue.split(separator: ".").last ?? "")] \(filename):\(line) - \(message)"
+        let now = Date().timeIntervalSince1970
+        guard let (filename, suppressed) = admit(file: file, line: line, now: now) else { return }
+
+        var text = message()
+        if suppressed > 0 {
+            text += " (\(suppressed) similar suppressed)"
+        }
+        osLoggers[subsystem.index].log(level: level.osLogType, "\(filename, privacy: .public):\(line) - \(text, privacy: .public)")
 
-            print(logMessage)
+        guard consoleOutput else { return }
+        queue.async {
+            print("\(BridgeLogger.timestamp(now)) \(level.rawValue) [\(subsystem.name)] \(filename):\(line) - \(text)")
         }
     }
 
     // Convenience methods
-    func debug(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.debug, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func debug(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.debug, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
-    func info(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.info, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func info(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.info, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
-    func success(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.success, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func success(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.success, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
-    func warning(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.warning, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func warning(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.warning, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
-    func error(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.error, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func error(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.error, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
-    func fatal(_ message: String, subsystem: LogSubsystem = .host, file: String = #file, function: String = #function, line: Int = #line) {
-        log(.fatal, subsystem: subsystem, message: message, file: file, function: function, line: line)
+    func fatal(_ message: @autoclosure () -> String, subsystem: LogSubsystem = .host, file: StaticString = #fileID, function: StaticString = #function, line: Int = #line) {
+        log(.fatal, subsystem: subsystem, message: message(), file: file, function: function, line: line)
     }
 
     /// Log video frame statistics
@@ -91,10 +230,63 @@ final class BridgeLogger {
         debug("Network: TX=\(formatBytes(bytesSent)) RX=\(formatBytes(bytesReceived)) RTT=\(String(format: "%.1f", rtt * 1000))ms", subsystem: subsystem)
     }
 
+    /// Log a congestion control decision
+    func logNetwork(bitrate: Int, previousBitrate: Int, loss: Double, jitter: Double, reason: String, subsystem: LogSubsystem = .network) {
+        info("Bitrate: \(String(format: "%.2f → %.2f Mbps", Double(previousBitrate) / 1_000_000, Double(bitrate) / 1_000_000)) (\(reason), loss=\(String(format: "%.1f", loss * 100))%, jitter=\(String(format: "%.1f", jitter * 1000))ms)", subsystem: subsystem)
+    }
+
     /// Log encoding statistics
     func logEncoding(bitrate: Double, qp: Int, keyframe: Bool, subsystem: LogSubsystem = .video) {
-        let bitrateStr = String(format: "%.2f", bitrate / 1_000_000)
-        debug("Encode: \(bitrateStr) Mbps, QP=\(qp), KF=\(keyframe)", subsystem: subsystem)
+        debug("Encode: \(String(format: "%.2f", bitrate / 1_000_000)) Mbps, QP=\(qp), KF=\(keyframe)", subsystem: subsystem)
+    }
+
+    // MARK: - Private Helpers
+
+    /// Rate limit of one call site: nil when the line must be dropped, otherwise the
+    /// site's file name and the lines suppressed since its last emitted one
+    private func admit(file: StaticString, line: Int, now: TimeInterval) -> (String, Int)? {
+        let site = Site(file: file.hasPointerRepresentation ? UInt(bitPattern: file.utf8Start) : 0, line: line)
+
+        sitesLock.lock()
+        defer { sitesLock.unlock() }
+
+        var state = sites[site] ?? SiteState(filename: BridgeLogger.filename(file), windowStart: now, emitted: 0, suppressed: 0)
+        if now - state.windowStart >= BridgeLogger.rateLimitWindow {
+            state.windowStart = now
+            state.emitted = 0
+        }
+        guard state.emitted < BridgeLogger.rateLimitBurst else {
+            state.suppressed += 1
+            sites[site] = state
+            return nil
+        }
+
+        let suppressed = state.suppressed
+        state.emitted += 1
+        state.suppressed = 0
+        sites[site] = state
+        return (state.filename, suppressed)
+    }
+
+    /// `NDIBridge/NetworkSender.swift` → `NetworkSender`, once per call site
+    private static func filename(_ file: StaticString) -> String {
+        var name = "\(file)"
+        if let slash = name.lastIndex(of: "/") {
+            name = String(name[name.index(after: slash)...])
+        }
+        if name.hasSuffix(".swift") {
+            name.removeLast(".swift".count)
+        }
+        return name
+    }
+
+    /// `HH:mm:ss.SSS` local time, without a DateFormatter
+    private static func timestamp(_ time: TimeInterval) -> String {
+        var seconds = time_t(time)
+        var parts = tm()
+        localtime_r(&seconds, &parts)
+        let millis = Int32((time - floor(time)) * 1000)
+        return String(format: "%02d:%02d:%02d.%03d", parts.tm_hour, parts.tm_min, parts.tm_sec, millis)
     }
 
     private func formatBytes(_ bytes: UInt64) -> String {
@@ -0,0 +1,242 @@
+//
+//  ControlMessage.swift
+//  NDI Bridge Mac
+//
+//  Join ↔ Host control messages sent over the media UDP flow
+//
+
+import Foundation
+
+/// Range of lost fragments within one frame
+struct NackRange {
+    var sequenceNumber: UInt32
+    var firstFragment: UInt16
+    var fragmentCount: UInt16
+}
+
+/// Stream features a Join receiver can handle, advertised to the Host
+struct ReceiverCapabilities: OptionSet {
+    let rawValue: UInt8
+
+    /// Video as 4-byte length-prefixed NAL units with out-of-band parameter sets
+    static let avcc = ReceiverCapabilities(rawValue: 1 << 0)
+
+    /// Per-frame Host stage timestamps (`MediaType.timing`) and clock probe replies
+    static let timing = ReceiverCapabilities(rawValue: 1 << 1)
+
+    /// Audio as interleaved int16 (`MediaPacketHeader.pcm16Flag`), converted back to float on receipt
+    static let pcm16 = ReceiverCapabilities(rawValue: 1 << 2)
+
+    /// Compressed audio frames (`AudioCodec.aacELD`), decoded on receipt
+    static let aacELD = ReceiverCapabilities(rawValue: 1 << 3)
+}
+
+/// Join reception statistics for one source over the last report interval
+struct ReceiverReport {
+    var sourceId: UInt8 = 0
+    var intervalMs: UInt16 = 0
+    var packetsExpected: UInt32 = 0  // Data + parity packets the Host sent for frames seen
+    var packetsLost: UInt32 = 0      // Before FEC/NACK recovery
+    var framesDropped: UInt16 = 0    // Frames abandoned despite recovery
+    var jitterMicros: UInt32 = 0     // RFC 3550 inter-arrival jitter of video frames
+    var bytesReceived: UInt32 = 0
+
+    static let size = 21
+
+    /// Fraction of packets lost on the path, 0...1
+    var lossFraction: Double {
+        guard packetsExpected > 0 else { return 0 }
+        return min(1, Double(packetsLost) / Double(packetsExpected))
+    }
+
+    /// Throughput actually delivered to Join, in bits per second
+    var receivedBitrate: Double {
+        guard intervalMs > 0 else { return 0 }
+        return Double(bytesReceived) * 8 * 1000 / Double(intervalMs)
+    }
+}
+
+/// Control packets flowing from Join back to Host on the same UDP flow as the media,
+/// plus the Host's clock probe replies going the other way.
+/// They use their own magic so neither side can mistake them for media packets
+///
+/// Layout (big-endian): magic u32 "NDIC" | version u8 | type u8 | payload length u16 | payload
+enum ControlMessage {
+    /// Fragments missing from recent frames of one stream
+    case nack(mediaType: UInt8, sourceId: UInt8, ranges: [NackRange])
+    /// Reassembly could not recover - ask the encoder for an IDR now
+    case keyframeRequest(sourceId: UInt8)
+    /// Periodic receiver hello - the Host only uses optional stream features while these keep arriving
+    case capabilities(ReceiverCapabilities)
+    /// Periodic loss/jitter statistics driving the Host bitrate controller
+    case receiverReport(ReceiverReport)
+    /// Join clock reading (StageClock µs), echoed by the Host to estimate the clock offset
+    case clockProbe(origin: UInt64)
+    /// Host answer: the probe's origin, Host receive and transmit times
+    case clockReply(origin: UInt64, received: UInt64, transmitted: UInt64)
+    /// Simulcast: the video rendition this Join wants, sent with each hello (absent = layer 0)
+    case subscribe(layer: UInt8)
+
+    static let magic: UInt32 = 0x4E444943  // "NDIC"
+    static let version: UInt8 = 1
+    static let headerSize = 8
+
+    /// Upper bound keeping a NACK well inside one datagram
+    static let maxNackRanges = 128
+
+    private enum Kind: UInt8 {
+        case nack = 1
+        case keyframeRequest = 2
+        case capabilities = 3
+        case receiverReport = 4
+        case clockProbe = 5
+        case clockReply = 6
+        case subscribe = 7
+    }
+
+    /// True when `data` starts with the control magic
+    static func isControlPacket(_ data: Data) -> Bool {
+        guard data.count >= headerSize else { return false }
+        return data.withUnsafeBytes { UInt32(bigEndian: $0.loadUnaligned(as: UInt32.self)) } == magic
+    }
+
+    func toData() -> Data {
+        var payload = Data()
+        let kind: Kind
+
+        switch self {
+        case .nack(let mediaType, let sourceId, let ranges):
+            kind = .nack
+            let count = min(ranges.count, ControlMessage.maxNackRanges)
+            payload.reserveCapacity(4 + count * 8)
+            payload.append(mediaType)
+            payload.append(sourceId)
+            payload.appendBigEndian(UInt16(count))
+            for range in ranges.prefix(count) {
+                payload.appendBigEndian(range.sequenceNumber)
+                payload.appendBigEndian(range.firstFragment)
+                payload.appendBigEndian(range.fragmentCount)
+            }
+
+        case .keyframeRequest(let sourceId):
+            kind = .keyframeRequest
+            payload.append(sourceId)
+
+        case .capabilities(let capabilities):
+            kind = .capabilities
+            payload.append(capabilities.rawValue)
+
+        case .receiverReport(let report):
+            kind = .receiverReport
+            payload.reserveCapacity(ReceiverReport.size)
+            payload.append(report.sourceId)
+            payload.appendBigEndian(report.intervalMs)
+            payload.appendBigEndian(report.packetsExpected)
+            payload.appendBigEndian(report.packetsLost)
+            payload.appendBigEndian(report.framesDropped)
+            payload.appendBigEndian(report.jitterMicros)
+            payload.appendBigEndian(report.bytesReceived)
+
+        case .clockProbe(let origin):
+            kind = .clockProbe
+            payload.appendBigEndian(origin)
+
+        case .clockReply(let origin, let received, let transmitted):
+            kind = .clockReply
+            payload.reserveCapacity(24)
+            payload.appendBigEndian(origin)
+            payload.appendBigEndian(received)
+            payload.appendBigEndian(transmitted)
+
+        case .subscribe(let layer):
+            kind = .subscribe
+            payload.append(layer)
+        }
+
+        var data = Data(capacity: ControlMessage.headerSize + payload.count)
+        data.appendBigEndian(ControlMessage.magic)
+        data.append(ControlMessage.version)
+        data.append(kind.rawValue)
+        data.appendBigEndian(UInt16(payload.count))
+        data.append(payload)
+        return data
+    }
+
+    init?(data: Data) {
+        guard ControlMessage.isControlPacket(data) else { return nil }
+
+        let bytes = [UInt8](data)
+        guard let kind = Kind(rawValue: bytes[5]) else { return nil }
+
+        let length = Int(bytes.readBigEndian(UInt16.self, at: 6))
+        guard bytes.count >= ControlMessage.headerSize + length else { return nil }
+        let p = ControlMessage.headerSize
+
+        switch kind {
+        case .nack:
+            guard length >= 4 else { return nil }
+            let count = Int(bytes.readBigEndian(UInt16.self, at: p + 2))
+            guard length >= 4 + count * 8 else { return nil }
+
+            var ranges: [NackRange] = []
+            ranges.reserveCapacity(count)
+            for i in 0..<count {
+                let offset = p + 4 + i * 8
+                ranges.append(NackRange(
+                    sequenceNumber: bytes.readBigEndian(UInt32.self, at: offset),
+                    firstFragment: bytes.readBigEndian(UInt16.self, at: offset + 4),
+                    fragmentCount: bytes.readBigEndian(UInt16.self, at: offset + 6)
+                ))
+            }
+            self = .nack(mediaType: bytes[p], sourceId: bytes[p + 1], ranges: ranges)
+
+        case .keyframeRequest:
+            guard length >= 1 else { return nil }
+            self = .keyframeRequest(sourceId: bytes[p])
+
+        case .capabilities:
+            guard length >= 1 else { return nil }
+            self = .capabilities(ReceiverCapabilities(rawValue: bytes[p]))
+
+        case .receiverReport:
+            guard length >= ReceiverReport.size else { return nil }
+            self = .receiverReport(ReceiverReport(
+                sourceId: bytes[p],
+                intervalMs: bytes.readBigEndian(UInt16.self, at: p + 1),
+                packetsExpected: bytes.readBigEndian(UInt32.self, at: p + 3),
+                packetsLost: bytes.readBigEndian(UInt32.self, at: p + 7),
+                framesDropped: bytes.readBigEndian(UInt16.self, at: p + 11),
+                jitterMicros: bytes.readBigEndian(UInt32.self, at: p + 13),
+                bytesReceived: bytes.readBigEndian(UInt32.self, at: p + 17)
+            ))
+
+        case .clockProbe:
+            guard length >= 8 else { return nil }
+            self = .clockProbe(origin: bytes.readBigEndian(UInt64.self, at: p))
+
+        case .clockReply:
+            guard length >= 24 else { return nil }
+            self = .clockReply(
+                origin: bytes.readBigEndian(UInt64.self, at: p),
+                received: bytes.readBigEndian(UInt64.self, at: p + 8),
+                transmitted: bytes.readBigEndian(UInt64.self, at: p + 16)
+            )
+
+        case .subscribe:
+            guard length >= 1 else { return nil }
+            self = .subscribe(layer: bytes[p])
+        }
+    }
+}
+
+private extension Data {
+    mutating func appendBigEndian<T: FixedWidthInteger>(_ value: T) {
+        withUnsafeBytes(of: value.bigEndian) { append(contentsOf: $0) }
+    }
+}
+
+private extension Array where Element == UInt8 {
+    func readBigEndian<T: FixedWidthInteger>(_ type: T.Type, at offset: Int) -> T {
+        return withUnsafeBytes { T(bigEndian: $0.loadUnaligned(fromByteOffset: offset, as: T.self)) }
+    }
+}
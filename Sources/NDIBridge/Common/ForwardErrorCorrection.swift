@@ -0,0 +1,45 @@
+//
+//  ForwardErrorCorrection.swift
+//  NDI Bridge Mac
+//
+//  XOR parity shared by the sender (parity generation) and the reassembler (recovery)
+//
+
+import Foundation
+
+/// Single-parity XOR forward error correction over groups of fragments.
+/// Every `groupSize` consecutive data fragments of a frame are protected by one parity
+/// packet, so one lost fragment per group is rebuilt without a retransmit round-trip
+enum XORParity {
+    /// `MediaPacketHeader.flags` bit marking a parity packet
+    static let parityFlag: UInt8 = 0x02
+
+    /// Number of parity packets for a frame of `fragmentCount` fragments
+    static func groupCount(fragmentCount: Int, groupSize: Int) -> Int {
+        guard groupSize > 0 else { return 0 }
+        return (fragmentCount + groupSize - 1) / groupSize
+    }
+
+    /// Fragment indices protected by parity group `group`
+    static func members(ofGroup group: Int, fragmentCount: Int, groupSize: Int) -> Range<Int> {
+        let start = group * groupSize
+        return start..<min(start + groupSize, fragmentCount)
+    }
+
+    /// XOR `count` bytes of `src` into `dst`, eight bytes at a time
+    static func accumulate(_ dst: UnsafeMutableRawPointer, _ src: UnsafeRawPointer, count: Int) {
+        var i = 0
+        while i + 8 <= count {
+            let a = dst.loadUnaligned(fromByteOffset: i, as: UInt64.self)
+            let b = src.loadUnaligned(fromByteOffset: i, as: UInt64.self)
+            dst.storeBytes(of: a ^ b, toByteOffset: i, as: UInt64.self)
+            i += 8
+        }
+        while i < count {
+            let a = dst.load(fromByteOffset: i, as: UInt8.self)
+            let b = src.load(fromByteOffset: i, as: UInt8.self)
+            dst.storeBytes(of: a ^ b, toByteOffset: i, as: UInt8.self)
+            i += 1
+        }
+    }
+}
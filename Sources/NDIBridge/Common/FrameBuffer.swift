@@ -7,6 +7,7 @@ struct BufferedVideoFrame {
     let pixelBuffer: CVPixelBuffer
     let timestamp: UInt64
     let presentationTime: CFTimeInterval  // Quand émettre cette frame
+    let isDecoderBuffer: Bool             // Buffer amont (décodeur ou convertisseur UYVY) retenu tel quel
 }
 
 /// Frame audio avec timestamp
@@ -15,18 +16,41 @@ struct BufferedAudioFrame {
     let timestamp: UInt64
     let sampleRate: Int32
     let channels: Int32
+    let samplesPerChannel: Int32
     let presentationTime: CFTimeInterval
 }
 
 /// Ring buffer thread-safe pour frames vidéo et audio
-/// Utilisé pour ajouter un délai configurable à la sortie NDI
+/// Buffer de gigue de la sortie NDI : les frames sont émises à l'heure que `PlayoutClock`
+/// déduit de leur timestamp émetteur, à profondeur fixe ou adaptative
 final class FrameBuffer {
-    private var videoFrames: [BufferedVideoFrame] = []
-    private var audioFrames: [BufferedAudioFrame] = []
+    private var videoFrames = RingQueue<BufferedVideoFrame>()
+    private var audioFrames = RingQueue<BufferedAudioFrame>(capacity: 64)
     private let lock = NSLock()
-    private let bufferDuration: CFTimeInterval  // en secondes
+    private let playout: PlayoutClock
     private var startTime: CFTimeInterval = 0
     private var isStarted = false
+    private var loggedTargetMs = -1
+
+    /// Frames arrivées après leur heure d'émission (émises aussitôt)
+    private(set) var lateFrames: UInt64 = 0
+
+    // Pool de copies : une frame par intervalle de buffer, plus une marge pour celles en cours d'émission
+    private static let poolHeadroom = 4
+    private let poolCapacity: Int
+
+    // Buffers amont retenus sans copie : au plus `retainBudget` en attente. Ils viennent du
+    // pool qui alimente le buffer, celui du convertisseur UYVY s'il y en a un, sinon du décodeur
+    private let retainBudget: Int
+    private var retainedDecoderBuffers = 0
+    private var pixelBufferPool: CVPixelBufferPool?
+    private var poolFormat: (width: Int, height: Int, pixelFormat: OSType) = (0, 0, 0)
+
+    /// Frames vidéo ignorées parce que le pool était plein
+    private(set) var poolExhaustedDrops: UInt64 = 0
+
+    /// Frames copiées faute de buffer décodeur disponible (budget de rétention atteint)
+    private(set) var copyFallbacks: UInt64 = 0
 
     /// Nombre de frames vidéo actuellement dans le buffer
     var videoCount: Int {
@@ -43,32 +67,139 @@ final class FrameBuffer {
     }
 
     /// Initialise le buffer avec un délai en millisecondes
-    /// - Parameter bufferMs: Délai en millisecondes (0 = pas de buffer)
-    init(bufferMs: Int) {
-        self.bufferDuration = CFTimeInterval(bufferMs) / 1000.0
+    /// - Parameters:
+    ///   - bufferMs: Profondeur en millisecondes (minimale en mode adaptatif)
+    ///   - maxBufferMs: Profondeur maximale ; au-dessus de `bufferMs` la profondeur s'adapte
+    ///     à la gigue mesurée (0 = profondeur fixe)
+    ///   - frameRate: Cadence maximale attendue, pour dimensionner le pool de copies
+    ///   - retainBudget: Nombre de buffers amont qu'on peut garder en attente sans copie
+    ///     (0 = toujours copier) ; leur pool doit en prévoir autant en plus de ceux en cours
+    init(bufferMs: Int, maxBufferMs: Int = 0, frameRate: Int = 60, retainBudget: Int = 0) {
+        self.playout = PlayoutClock(minDelay: CFTimeInterval(bufferMs) / 1000.0,
+                                    maxDelay: CFTimeInterval(max(bufferMs, maxBufferMs)) / 1000.0)
+        self.poolCapacity = FrameBuffer.frameCapacity(bufferMs: max(bufferMs, maxBufferMs), frameRate: frameRate)
+            + FrameBuffer.poolHeadroom
+        self.retainBudget = retainBudget
+        self.videoFrames = RingQueue(capacity: poolCapacity)
+    }
+
+    /// Heure d'émission de la prochaine frame (audio ou vidéo), nil si le buffer est vide
+    var nextPresentationTime: CFTimeInterval? {
+        lock.lock()
+        defer { lock.unlock() }
+        switch (videoFrames.first?.presentationTime, audioFrames.first?.presentationTime) {
+        case let (video?, audio?): return min(video, audio)
+        case let (video?, nil): return video
+        case let (nil, audio?): return audio
+        case (nil, nil): return nil
+        }
+    }
+
+    /// Nombre de frames présentes dans le buffer en régime établi
+    static func frameCapacity(bufferMs: Int, frameRate: Int = 60) -> Int {
+        return (bufferMs * frameRate + 999) / 1000
     }
 
     // MARK: - Private Helpers
 
-    /// Copier un CVPixelBuffer pour le stocker indépendamment du pool source
-    /// Le décodeur VideoToolbox recycle ses buffers, donc on doit faire une copie
-    /// pour que les frames bufferisées restent valides pendant la durée du buffer
-    private func copyPixelBuffer(_ source: CVPixelBuffer) -> CVPixelBuffer? {
+    /// Heure d'émission d'une frame qui arrive maintenant (verrou tenu)
+    private func schedule(_ timestamp: UInt64, media: PlayoutClock.Media) -> CFTimeInterval {
+        let now = CACurrentMediaTime()
+        let resets = playout.resets
+        let presentationTime = playout.presentationTime(timestamp: timestamp, arrival: now, media: media)
+        if presentationTime < now {
+            lateFrames += 1
+        }
+        if playout.resets != resets {
+            logger.info("Buffer : discontinuité de timestamps, horloge de lecture réancrée", subsystem: .join)
+        }
+
+        // Changements de profondeur adaptative, par paliers de 10 ms
+        let targetMs = Int(playout.targetDelay * 1000)
+        if playout.isAdaptive && abs(targetMs - loggedTargetMs) >= 10 {
+            loggedTargetMs = targetMs
+            logger.debug(String(format: "Buffer adaptatif : profondeur %d ms (gigue %.1f ms)", targetMs, playout.jitter * 1000),
+                         subsystem: .join)
+        }
+        return presentationTime
+    }
+
+    /// Pool IOSurface pour le format de `source`, recréé si la résolution ou le format change
+    /// Le seuil d'allocation borne la mémoire à `poolCapacity` buffers
+    private func pool(for source: CVPixelBuffer) -> CVPixelBufferPool? {
         let width = CVPixelBufferGetWidth(source)
         let height = CVPixelBufferGetHeight(source)
         let pixelFormat = CVPixelBufferGetPixelFormatType(source)
 
+        if let pool = pixelBufferPool,
+           poolFormat.width == width, poolFormat.height == height, poolFormat.pixelFormat == pixelFormat {
+            return pool
+        }
+
+        let poolAttributes: [CFString: Any] = [
+            kCVPixelBufferPoolMinimumBufferCountKey: poolCapacity
+        ]
+        let bufferAttributes: [CFString: Any] = [
+            kCVPixelBufferWidthKey: width,
+            kCVPixelBufferHeightKey: height,
+            kCVPixelBufferPixelFormatTypeKey: pixelFormat,
+            kCVPixelBufferIOSurfacePropertiesKey: [:] as CFDictionary
+        ]
+
+        var newPool: CVPixelBufferPool?
+        let status = CVPixelBufferPoolCreate(
+            kCFAllocatorDefault,
+            poolAttributes as CFDictionary,
+            bufferAttributes as CFDictionary,
+            &newPool
+        )
+        guard status == kCVReturnSuccess, let created = newPool else {
+            logger.error("CVPixelBufferPoolCreate failed: \(status)", subsystem: .join)
+            return nil
+        }
+
+        pixelBufferPool = created
+        poolFormat = (width, height, pixelFormat)
+        logger.debug("Frame buffer pool: \(poolCapacity) x \(width)x\(height)", subsystem: .join)
+        return created
+    }
+
+    /// Copier `rows` lignes d'un plan, en une seule copie si les pas sont identiques
+    private func copyPlane(from src: UnsafeRawPointer, srcBytesPerRow: Int,
+                           to dst: UnsafeMutableRawPointer, dstBytesPerRow: Int, rows: Int) {
+        if srcBytesPerRow == dstBytesPerRow {
+            memcpy(dst, src, srcBytesPerRow * rows)
+            return
+        }
+        let rowBytes = min(srcBytesPerRow, dstBytesPerRow)
+        for row in 0..<rows {
+            memcpy(dst.advanced(by: row * dstBytesPerRow), src.advanced(by: row * srcBytesPerRow), rowBytes)
+        }
+    }
+
+    /// Copier un CVPixelBuffer pour le stocker indépendamment du pool source
+    /// Le décodeur VideoToolbox recycle ses buffers, donc on doit faire une copie
+    /// pour que les frames bufferisées restent valides pendant la durée du buffer.
+    /// La destination vient du pool : elle y retourne quand la frame émise est libérée.
+    /// Interne plutôt que privée pour `ndi-bridge bench framecopy`
+    func copyPixelBuffer(_ source: CVPixelBuffer) -> CVPixelBuffer? {
+        guard let pool = pool(for: source) else { return nil }
+
         var destPixelBuffer: CVPixelBuffer?
-        let status = CVPixelBufferCreate(
+        let auxAttributes: [CFString: Any] = [
+            kCVPixelBufferPoolAllocationThresholdKey: poolCapacity
+        ]
+        let status = CVPixelBufferPoolCreatePixelBufferWithAuxAttributes(
             kCFAllocatorDefault,
-            width,
-            height,
-            pixelFormat,
-            nil,
+            pool,
+            auxAttributes as CFDictionary,
             &destPixelBuffer
         )
 
         guard status == kCVReturnSuccess, let dest = destPixelBuffer else {
+            if status == kCVReturnWouldExceedAllocationThreshold {
+                poolExhaustedDrops += 1
+            }
             return nil
         }
 
@@ -85,33 +216,19 @@ final class FrameBuffer {
         if planeCount > 0 {
             // Format planaire (NV12, etc.)
             for plane in 0..<planeCount {
-                let srcBase = CVPixelBufferGetBaseAddressOfPlane(source, plane)
-                let destBase = CVPixelBufferGetBaseAddressOfPlane(dest, plane)
-                let srcBytesPerRow = CVPixelBufferGetBytesPerRowOfPlane(source, plane)
-                let destBytesPerRow = CVPixelBufferGetBytesPerRowOfPlane(dest, plane)
-                let planeHeight = CVPixelBufferGetHeightOfPlane(source, plane)
-
-                if let src = srcBase, let dst = destBase {
-                    for row in 0..<planeHeight {
-                        let srcRow = src.advanced(by: row * srcBytesPerRow)
-                        let dstRow = dst.advanced(by: row * destBytesPerRow)
-                        memcpy(dstRow, srcRow, min(srcBytesPerRow, destBytesPerRow))
-                    }
+                if let src = CVPixelBufferGetBaseAddressOfPlane(source, plane),
+                   let dst = CVPixelBufferGetBaseAddressOfPlane(dest, plane) {
+                    copyPlane(from: src, srcBytesPerRow: CVPixelBufferGetBytesPerRowOfPlane(source, plane),
+                              to: dst, dstBytesPerRow: CVPixelBufferGetBytesPerRowOfPlane(dest, plane),
+                              rows: CVPixelBufferGetHeightOfPlane(source, plane))
                 }
             }
         } else {
             // Format non-planaire (BGRA, etc.)
-            let srcBase = CVPixelBufferGetBaseAddress(source)
-            let destBase = CVPixelBufferGetBaseAddress(dest)
-            let srcBytesPerRow = CVPixelBufferGetBytesPerRow(source)
-            let destBytesPerRow = CVPixelBufferGetBytesPerRow(dest)
-
-            if let src = srcBase, let dst = destBase {
-                for row in 0..<height {
-                    let srcRow = src.advanced(by: row * srcBytesPerRow)
-                    let dstRow = dst.advanced(by: row * destBytesPerRow)
-                    memcpy(dstRow, srcRow, min(srcBytesPerRow, destBytesPerRow))
-                }
+            if let src = CVPixelBufferGetBaseAddress(source), let dst = CVPixelBufferGetBaseAddress(dest) {
+                copyPlane(from: src, srcBytesPerRow: CVPixelBufferGetBytesPerRow(source),
+                          to: dst, dstBytesPerRow: CVPixelBufferGetBytesPerRow(dest),
+                          rows: CVPixelBufferGetHeight(source))
             }
         }
 
@@ -121,16 +238,35 @@ final class FrameBuffer {
     // MARK: - Public API
 
     /// Ajouter une frame vidéo au buffer
-    /// Une copie profonde du pixelBuffer est faite pour éviter que le décodeur
-    /// ne recycle le buffer avant l'émission
+    /// Tant que le budget de rétention le permet, le buffer du décodeur est gardé tel quel :
+    /// son pool est dimensionné pour couvrir le délai. Au-delà, une copie profonde est faite
+    /// pour éviter que le décodeur ne recycle le buffer avant l'émission
     /// - Parameters:
     ///   - pixelBuffer: Le CVPixelBuffer décodé
     ///   - timestamp: Timestamp original de la frame
-    func enqueueVideo(_ pixelBuffer: CVPixelBuffer, timestamp: UInt64) {
-        // Deep copy pour éviter que le décodeur recycle le buffer
-        guard let copiedBuffer = copyPixelBuffer(pixelBuffer) else {
-            // Silently skip if copy fails - don't crash
-            return
+    /// - Returns: true si le buffer était vide (l'horloge de sortie doit être réarmée)
+    @discardableResult
+    func enqueueVideo(_ pixelBuffer: CVPixelBuffer, timestamp: UInt64) -> Bool {
+        lock.lock()
+        let retain = retainedDecoderBuffers < retainBudget
+        if retain {
+            retainedDecoderBuffers += 1
+        } else if retainBudget > 0 {
+            copyFallbacks += 1
+        }
+        lock.unlock()
+
+        let storedBuffer: CVPixelBuffer
+        if retain {
+            storedBuffer = pixelBuffer
+        } else {
+            // Deep copy pour éviter que le décodeur recycle le buffer
+            // (hors verrou : seul le thread du décodeur touche au pool)
+            guard let copiedBuffer = copyPixelBuffer(pixelBuffer) else {
+                // Silently skip if copy fails - don't crash
+                return false
+            }
+            storedBuffer = copiedBuffer
         }
 
         lock.lock()
@@ -141,22 +277,28 @@ final class FrameBuffer {
             isStarted = true
         }
 
-        let presentationTime = CACurrentMediaTime() + bufferDuration
+        let presentationTime = schedule(timestamp, media: .video)
         let frame = BufferedVideoFrame(
-            pixelBuffer: copiedBuffer,  // Buffer copié, indépendant du pool décodeur
+            pixelBuffer: storedBuffer,
             timestamp: timestamp,
-            presentationTime: presentationTime
+            presentationTime: presentationTime,
+            isDecoderBuffer: retain
         )
+        let wasEmpty = videoFrames.isEmpty && audioFrames.isEmpty
         videoFrames.append(frame)
+        return wasEmpty
     }
 
     /// Ajouter une frame audio au buffer
     /// - Parameters:
-    ///   - data: Les données audio PCM
+    ///   - data: Les données audio PCM (float planaire contigu, bloc du pool audio)
     ///   - timestamp: Timestamp original
     ///   - sampleRate: Taux d'échantillonnage (ex: 48000)
     ///   - channels: Nombre de canaux (ex: 2)
-    func enqueueAudio(_ data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32) {
+    ///   - samplesPerChannel: Échantillons par canal
+    /// - Returns: true si le buffer était vide (l'horloge de sortie doit être réarmée)
+    @discardableResult
+    func enqueueAudio(_ data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32) -> Bool {
         lock.lock()
         defer { lock.unlock() }
 
@@ -165,15 +307,18 @@ final class FrameBuffer {
             isStarted = true
         }
 
-        let presentationTime = CACurrentMediaTime() + bufferDuration
+        let presentationTime = schedule(timestamp, media: .audio)
         let frame = BufferedAudioFrame(
             data: data,
             timestamp: timestamp,
             sampleRate: sampleRate,
             channels: channels,
+            samplesPerChannel: samplesPerChannel,
             presentationTime: presentationTime
         )
+        let wasEmpty = videoFrames.isEmpty && audioFrames.isEmpty
         audioFrames.append(frame)
+        return wasEmpty
     }
 
     /// Récupérer les frames vidéo prêtes à être émises
@@ -185,8 +330,12 @@ final class FrameBuffer {
         let now = CACurrentMediaTime()
         var ready: [BufferedVideoFrame] = []
 
-        while let first = videoFrames.first, first.presentationTime <= now {
-            ready.append(videoFrames.removeFirst())
+        while let first = videoFrames.first, first.presentationTime <= now,
+              let frame = videoFrames.popFirst() {
+            if frame.isDecoderBuffer {
+                retainedDecoderBuffers -= 1
+            }
+            ready.append(frame)
         }
 
         return ready
@@ -201,8 +350,9 @@ final class FrameBuffer {
         let now = CACurrentMediaTime()
         var ready: [BufferedAudioFrame] = []
 
-        while let first = audioFrames.first, first.presentationTime <= now {
-            ready.append(audioFrames.removeFirst())
+        while let first = audioFrames.first, first.presentationTime <= now,
+              let frame = audioFrames.popFirst() {
+            ready.append(frame)
         }
 
         return ready
@@ -214,11 +364,26 @@ final class FrameBuffer {
         defer { lock.unlock() }
         videoFrames.removeAll()
         audioFrames.removeAll()
+        retainedDecoderBuffers = 0
         isStarted = false
     }
 
-    /// Durée du buffer en millisecondes
+    /// Profondeur minimale du buffer en millisecondes
     var bufferMs: Int {
-        return Int(bufferDuration * 1000)
+        return Int(playout.minDelay * 1000)
+    }
+
+    /// Profondeur visée actuellement en millisecondes
+    var targetDelayMs: Double {
+        lock.lock()
+        defer { lock.unlock() }
+        return playout.targetDelay * 1000
+    }
+
+    /// Gigue d'arrivée lissée en millisecondes
+    var jitterMs: Double {
+        lock.lock()
+        defer { lock.unlock() }
+        return playout.jitter * 1000
     }
 }
@@ -0,0 +1,60 @@
+//
+//  FrameTiming.swift
+//  NDI Bridge Mac
+//
+//  Host-side stage timestamps of one video frame, for latency measurement
+//
+
+import Foundation
+import QuartzCore
+
+/// Monotonic clock shared by every latency stage of a process, in microseconds.
+/// Host and Join clocks are unrelated; Join estimates their offset with clock probes
+enum StageClock {
+    static func now() -> UInt64 {
+        return micros(CACurrentMediaTime())
+    }
+
+    static func micros(_ time: CFTimeInterval) -> UInt64 {
+        return UInt64(max(0, time) * 1_000_000)
+    }
+}
+
+/// Payload of a `MediaType.timing` packet, sent after the last packet of the frame it
+/// describes (same source, sequence number and timestamp). Five big-endian u64,
+/// `StageClock` microseconds of the Host. Only sent to receivers advertising `.timing`
+struct HostFrameTiming {
+    var captured: UInt64 = 0        // Frame returned by ndi_receiver_capture
+    var encodeSubmitted: UInt64 = 0 // Handed to VideoToolbox
+    var encoded: UInt64 = 0         // Compression callback
+    var firstSent: UInt64 = 0       // First packet handed to the network stack
+    var lastSent: UInt64 = 0        // Last packet handed to the network stack
+
+    static let size = 40
+
+    func serialize() -> Data {
+        var payload = Data(capacity: HostFrameTiming.size)
+        for value in [captured, encodeSubmitted, encoded, firstSent, lastSent] {
+            withUnsafeBytes(of: value.bigEndian) { payload.append(contentsOf: $0) }
+        }
+        return payload
+    }
+
+    init(captured: UInt64, encodeSubmitted: UInt64, encoded: UInt64) {
+        self.captured = captured
+        self.encodeSubmitted = encodeSubmitted
+        self.encoded = encoded
+    }
+
+    init?(payload: Data) {
+        guard payload.count >= HostFrameTiming.size else { return nil }
+        let values = payload.withUnsafeBytes { bytes in
+            (0..<5).map { UInt64(bigEndian: bytes.loadUnaligned(fromByteOffset: $0 * 8, as: UInt64.self)) }
+        }
+        captured = values[0]
+        encodeSubmitted = values[1]
+        encoded = values[2]
+        firstSent = values[3]
+        lastSent = values[4]
+    }
+}
@@ -0,0 +1,265 @@
+//
+//  Metrics.swift
+//  NDI Bridge Mac
+//
+//  Process-wide counters and gauges, rendered as Prometheus text or JSON
+//
+
+import Foundation
+import QuartzCore
+import CAtomics
+
+/// Monotonic counter: one relaxed atomic add on the hot path, no lock
+final class MetricCounter {
+    private let storage: UnsafeMutablePointer<UInt64>
+
+    fileprivate init() {
+        storage = .allocate(capacity: 1)
+        storage.initialize(to: 0)
+    }
+
+    deinit {
+        storage.deallocate()
+    }
+
+    @inline(__always)
+    func add(_ delta: UInt64 = 1) {
+        catomic_fetch_add_relaxed(storage, delta)
+    }
+
+    var value: UInt64 {
+        return catomic_load_relaxed(storage)
+    }
+}
+
+/// Last-value gauge: one relaxed atomic store of the Double's bit pattern
+final class MetricGauge {
+    private let storage: UnsafeMutablePointer<UInt64>
+
+    fileprivate init() {
+        storage = .allocate(capacity: 1)
+        storage.initialize(to: Double(0).bitPattern)
+    }
+
+    deinit {
+        storage.deallocate()
+    }
+
+    @inline(__always)
+    func set(_ value: Double) {
+        catomic_store_relaxed(storage, value.bitPattern)
+    }
+
+    var value: Double {
+        return Double(bitPattern: catomic_load_relaxed(storage))
+    }
+}
+
+/// Per-second gauge derived from a counter at each scrape (fps, bitrates)
+struct MetricRate {
+    let name: String
+    let help: String
+    var scale: Double = 1  // e.g. 8 turns bytes into bits per second
+}
+
+/// Registry of every metric of the process.
+/// Components create their counters once (at init) and only touch the counter on the
+/// hot path; the registry lock is taken at registration and scrape time only.
+/// Values that already live elsewhere (queue depths, ring drops) are registered as read
+/// closures evaluated at scrape; a closure returning nil (owner gone) is dropped
+final class MetricsRegistry {
+    static let shared = MetricsRegistry()
+
+    enum Kind: String {
+        case counter
+        case gauge
+    }
+
+    private struct Entry {
+        let id: Int
+        let name: String
+        let help: String
+        let kind: Kind
+        let labels: [(String, String)]
+        let read: () -> Double?
+        let rate: MetricRate?
+        var lastValue: Double = 0
+        var lastTime: CFTimeInterval = 0
+    }
+
+    private var entries: [Entry] = []
+    private var nextId = 0
+    private var counters: [String: MetricCounter] = [:]
+    private var gauges: [String: MetricGauge] = [:]
+    private let lock = NSLock()
+
+    private init() {}
+
+    /// Counter `name{labels}`, shared with any earlier registration of the same series
+    func counter(_ name: String, help: String, labels: [String: String] = [:], rate: MetricRate? = nil) -> MetricCounter {
+        let key = MetricsRegistry.seriesKey(name, labels)
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let existing = counters[key] {
+            return existing
+        }
+        let counter = MetricCounter()
+        counters[key] = counter
+        append(name: name, help: help, kind: .counter, labels: labels, read: { Double(counter.value) }, rate: rate)
+        return counter
+    }
+
+    func gauge(_ name: String, help: String, labels: [String: String] = [:]) -> MetricGauge {
+        let key = MetricsRegistry.seriesKey(name, labels)
+        lock.lock()
+        defer { lock.unlock() }
+
+        if let existing = gauges[key] {
+            return existing
+        }
+        let gauge = MetricGauge()
+        gauges[key] = gauge
+        append(name: name, help: help, kind: .gauge, labels: labels, read: { gauge.value }, rate: nil)
+        return gauge
+    }
+
+    /// Series read at scrape time; return nil once the owner is gone.
+    /// Closures run on the scraper's queue without the registry lock, so they may hop
+    /// onto the owner's queue to read state that is not atomic
+    func register(_ name: String, help: String, kind: Kind, labels: [String: String] = [:], read: @escaping () -> Double?) {
+        lock.lock()
+        defer { lock.unlock() }
+        let sortedLabels = MetricsRegistry.sorted(labels)
+        entries.removeAll { entry in
+            entry.name == name && entry.labels.elementsEqual(sortedLabels) { $0 == $1 }
+        }
+        append(name: name, help: help, kind: kind, labels: labels, read: read, rate: nil)
+    }
+
+    /// Prometheus text exposition format 0.0.4
+    func prometheusText() -> String {
+        var output = ""
+        var described = Set<String>()
+        for sample in scrape() {
+            if described.insert(sample.name).inserted {
+                output += "# HELP \(sample.name) \(sample.help)\n"
+                output += "# TYPE \(sample.name) \(sample.kind.rawValue)\n"
+            }
+            output += sample.name
+            if !sample.labels.isEmpty {
+                output += "{" + sample.labels.map { "\($0.0)=\"\(MetricsRegistry.escape($0.1))\"" }.joined(separator: ",") + "}"
+            }
+            output += " \(MetricsRegistry.format(sample.value))\n"
+        }
+        return output
+    }
+
+    /// `{"metrics": [{"name", "labels", "value"}...]}`
+    func json() -> Data {
+        let metrics: [[String: Any]] = scrape().map { sample in
+            [
+                "name": sample.name,
+                "labels": Dictionary(uniqueKeysWithValues: sample.labels),
+                "value": sample.value.isFinite ? sample.value : 0
+            ]
+        }
+        return (try? JSONSerialization.data(withJSONObject: ["metrics": metrics], options: [.sortedKeys])) ?? Data()
+    }
+
+    // MARK: - Private Helpers
+
+    private struct Sample {
+        let name: String
+        let help: String
+        let kind: Kind
+        let labels: [(String, String)]
+        let value: Double
+    }
+
+    /// Must be called with the lock held
+    private func append(name: String, help: String, kind: Kind, labels: [String: String],
+                        read: @escaping () -> Double?, rate: MetricRate?) {
+        entries.append(Entry(id: nextId, name: name, help: help, kind: kind, labels: MetricsRegistry.sorted(labels),
+                             read: read, rate: rate))
+        nextId += 1
+    }
+
+    /// Read every series, derive the rates and group samples by metric name
+    private func scrape() -> [Sample] {
+        lock.lock()
+        let snapshot = entries
+        lock.unlock()
+
+        // Outside the lock: a read closure may wait on a queue that is registering a metric
+        let values = snapshot.map { $0.read() }
+        let now = CACurrentMediaTime()
+
+        lock.lock()
+        defer { lock.unlock() }
+
+        var samples: [Sample] = []
+        var derived: [Sample] = []
+        var gone = Set<Int>()
+        var positions: [Int: Int] = [:]
+        for (position, entry) in entries.enumerated() {
+            positions[entry.id] = position
+        }
+
+        for (entry, value) in zip(snapshot, values) {
+            guard let value = value else {
+                gone.insert(entry.id)
+                continue
+            }
+            samples.append(Sample(name: entry.name, help: entry.help, kind: entry.kind, labels: entry.labels, value: value))
+
+            if let rate = entry.rate, let position = positions[entry.id] {
+                let elapsed = now - entry.lastTime
+                let perSecond = entry.lastTime > 0 && elapsed > 0 ? (value - entry.lastValue) / elapsed * rate.scale : 0
+                derived.append(Sample(name: rate.name, help: rate.help, kind: .gauge, labels: entry.labels, value: perSecond))
+                entries[position].lastValue = value
+                entries[position].lastTime = now
+            }
+        }
+        if !gone.isEmpty {
+            entries.removeAll { gone.contains($0.id) }
+        }
+
+        // Stable grouping: HELP/TYPE must precede all series of a name
+        var order: [String: Int] = [:]
+        for sample in samples + derived where order[sample.name] == nil {
+            order[sample.name] = order.count
+        }
+        return (samples + derived).enumerated().sorted {
+            let lhs = order[$0.element.name]!, rhs = order[$1.element.name]!
+            return lhs != rhs ? lhs < rhs : $0.offset < $1.offset
+        }.map { $0.element }
+    }
+
+    private static func sorted(_ labels: [String: String]) -> [(String, String)] {
+        return labels.sorted { $0.key < $1.key }.map { ($0.key, $0.value) }
+    }
+
+    private static func seriesKey(_ name: String, _ labels: [String: String]) -> String {
+        return name + sorted(labels).map { "|\($0.0)=\($0.1)" }.joined()
+    }
+
+    private static func escape(_ value: String) -> String {
+        return value
+            .replacingOccurrences(of: "\\", with: "\\\\")
+            .replacingOccurrences(of: "\"", with: "\\\"")
+            .replacingOccurrences(of: "\n", with: "\\n")
+    }
+
+    private static func format(_ value: Double) -> String {
+        if value.isNaN { return "NaN" }
+        if value.isInfinite { return value > 0 ? "+Inf" : "-Inf" }
+        if value == value.rounded() && abs(value) < 1e15 {
+            return String(Int64(value))
+        }
+        return String(value)
+    }
+}
+
+/// Global shortcut
+let metrics = MetricsRegistry.shared
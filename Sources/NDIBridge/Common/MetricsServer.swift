@@ -0,0 +1,124 @@
+//
+//  MetricsServer.swift
+//  NDI Bridge Mac
+//
+//  Minimal HTTP endpoint serving the metrics registry to scrapers
+//
+
+import Foundation
+import Network
+
+/// `GET /metrics` (Prometheus text) and `GET /metrics.json` on a TCP port.
+/// One request per connection, answered from the registry and closed: enough for
+/// Prometheus and curl, with nothing running between scrapes
+final class MetricsServer {
+    private var listener: NWListener?
+    private let queue = DispatchQueue(label: "com.ndibridge.metrics", qos: .utility)
+    private let port: UInt16
+    private let registry: MetricsRegistry
+
+    private static let maxRequestSize = 8192
+
+    init(port: UInt16, registry: MetricsRegistry = metrics) {
+        self.port = port
+        self.registry = registry
+    }
+
+    deinit {
+        stop()
+    }
+
+    func start() throws {
+        guard listener == nil else { return }
+        guard let nwPort = NWEndpoint.Port(rawValue: port) else {
+            throw NSError(domain: "MetricsServer", code: -1, userInfo: [NSLocalizedDescriptionKey: "Invalid port"])
+        }
+
+        let parameters = NWParameters.tcp
+        parameters.allowLocalEndpointReuse = true
+        let listener = try NWListener(using: parameters, on: nwPort)
+
+        listener.stateUpdateHandler = { [port] state in
+            switch state {
+            case .ready:
+                logger.success("Metrics on http://0.0.0.0:\(port)/metrics", subsystem: .network)
+            case .failed(let error):
+                logger.error("Metrics listener failed: \(error.localizedDescription)", subsystem: .network)
+            default:
+                break
+            }
+        }
+        listener.newConnectionHandler = { [weak self] connection in
+            self?.serve(connection)
+        }
+        listener.start(queue: queue)
+        self.listener = listener
+    }
+
+    func stop() {
+        listener?.cancel()
+        listener = nil
+    }
+
+    // MARK: - Private Helpers
+
+    private func serve(_ connection: NWConnection) {
+        connection.start(queue: queue)
+        receiveRequest(on: connection, buffer: Data())
+    }
+
+    /// Accumulate until the end of the request head, then answer
+    private func receiveRequest(on connection: NWConnection, buffer: Data) {
+        connection.receive(minimumIncompleteLength: 1, maximumLength: MetricsServer.maxRequestSize) { [weak self] content, _, isComplete, error in
+            guard let self = self else { return }
+            var request = buffer
+            if let content = content {
+                request.append(content)
+            }
+
+            if request.range(of: Data("\r\n\r\n".utf8)) != nil || isComplete || request.count >= MetricsServer.maxRequestSize {
+                self.respond(to: request, on: connection)
+            } else if error == nil {
+                self.receiveRequest(on: connection, buffer: request)
+            } else {
+                connection.cancel()
+            }
+        }
+    }
+
+    private func respond(to request: Data, on connection: NWConnection) {
+        let requestLine = String(decoding: request.prefix { $0 != 0x0D && $0 != 0x0A }, as: UTF8.self)
+        let parts = requestLine.split(separator: " ")
+        let method = parts.first.map(String.init) ?? ""
+        let path = parts.count > 1 ? String(parts[1].split(separator: "?").first ?? "") : ""
+
+        let status: String
+        let contentType: String
+        let body: Data
+
+        switch (method, path) {
+        case ("GET", "/metrics"), ("GET", "/"):
+            status = "200 OK"
+            contentType = "text/plain; version=0.0.4; charset=utf-8"
+            body = Data(registry.prometheusText().utf8)
+        case ("GET", "/metrics.json"):
+            status = "200 OK"
+            contentType = "application/json"
+            body = registry.json()
+        case ("GET", _):
+            status = "404 Not Found"
+            contentType = "text/plain"
+            body = Data("Not found - try /metrics or /metrics.json\n".utf8)
+        default:
+            status = "405 Method Not Allowed"
+            contentType = "text/plain"
+            body = Data("GET only\n".utf8)
+        }
+
+        var response = Data("HTTP/1.1 \(status)\r\nContent-Type: \(contentType)\r\nContent-Length: \(body.count)\r\nConnection: close\r\n\r\n".utf8)
+        response.append(body)
+        connection.send(content: response, completion: .contentProcessed { _ in
+            connection.cancel()
+        })
+    }
+}
@@ -0,0 +1,41 @@
+//
+//  NDIRuntime.swift
+//  NDI Bridge Mac
+//
+//  Process-wide NDI SDK lifetime shared by every receiver and sender
+//
+
+import Foundation
+import CNDIWrapper
+
+/// Reference-counted NDI SDK initialization.
+/// Several receivers/senders live in one process in multi-source mode: the SDK is
+/// initialized by the first `acquire()` and torn down by the last `release()`
+enum NDIRuntime {
+    private static let lock = NSLock()
+    private static var users = 0
+
+    /// Initialize the SDK if this is its first user
+    static func acquire() -> Bool {
+        lock.lock()
+        defer { lock.unlock() }
+
+        if users == 0 {
+            guard ndi_initialize() else { return false }
+        }
+        users += 1
+        return true
+    }
+
+    /// Drop one user; the SDK is destroyed with the last one
+    static func release() {
+        lock.lock()
+        defer { lock.unlock() }
+
+        guard users > 0 else { return }
+        users -= 1
+        if users == 0 {
+            ndi_destroy()
+        }
+    }
+}
@@ -0,0 +1,102 @@
+//
+//  PCMConversion.swift
+//  NDI Bridge Mac
+//
+//  vDSP conversions between NDI planar float audio and the wire formats
+//
+
+import Foundation
+import Accelerate
+
+/// Audio sample layout on the wire, signalled by `MediaPacketHeader.pcm16Flag`
+enum AudioWireFormat {
+    case float32Planar     // NDI FLTP, channels back to back (default, what NDI sends and expects)
+    case int16Interleaved  // Half the bytes; only to receivers advertising `.pcm16`
+
+    var bytesPerSample: Int {
+        switch self {
+        case .float32Planar: return 4
+        case .int16Interleaved: return 2
+        }
+    }
+}
+
+/// Planar float ↔ wire conversions into `AudioBlockPool` blocks.
+/// One converter per thread: it owns the float scratch used by the int16 path
+final class PCMConverter {
+    private var scratch: UnsafeMutablePointer<Float>?
+    private var scratchCapacity = 0
+
+    deinit {
+        scratch?.deallocate()
+    }
+
+    /// Pack NDI planar float (rows of `channelStride` bytes, 0 = interleaved) into a
+    /// contiguous planar block of `channels * samples` floats
+    static func packPlanar(_ source: UnsafeRawPointer, channels: Int, samples: Int, channelStride: Int) -> Data {
+        let count = channels * samples
+        return AudioBlockPool.shared.data(count: count * 4) { block in
+            let src = source.assumingMemoryBound(to: Float.self)
+            let dst = block.assumingMemoryBound(to: Float.self)
+            if channelStride == 0 {
+                // Interleaved (samples × channels) → planar (channels × samples)
+                vDSP_mtrans(src, 1, dst, 1, vDSP_Length(channels), vDSP_Length(samples))
+            } else if channelStride == samples * 4 {
+                dst.update(from: src, count: count)
+            } else {
+                vDSP_mmov(src, dst, vDSP_Length(samples), vDSP_Length(channels),
+                          vDSP_Length(channelStride / 4), vDSP_Length(samples))
+            }
+        }
+    }
+
+    /// Contiguous planar float → interleaved int16, clipped to [-1, 1]
+    func interleavedInt16(fromPlanar planar: Data, channels: Int) -> Data {
+        guard channels > 0 else { return Data() }
+        let samples = planar.count / (channels * 4)
+        reserveScratch(samples)
+        guard samples > 0, let scratch = scratch else { return Data() }
+
+        return planar.withUnsafeBytes { (raw: UnsafeRawBufferPointer) -> Data in
+            let src = raw.bindMemory(to: Float.self).baseAddress!
+            return AudioBlockPool.shared.data(count: channels * samples * 2) { block in
+                let dst = block.assumingMemoryBound(to: Int16.self)
+                var scale = Float(Int16.max)
+                var low = -Float(Int16.max), high = Float(Int16.max)
+                for channel in 0..<channels {
+                    vDSP_vsmul(src + channel * samples, 1, &scale, scratch, 1, vDSP_Length(samples))
+                    vDSP_vclip(scratch, 1, &low, &high, scratch, 1, vDSP_Length(samples))
+                    vDSP_vfixr16(scratch, 1, dst + channel, vDSP_Stride(channels), vDSP_Length(samples))
+                }
+            }
+        }
+    }
+
+    /// Interleaved int16 → contiguous planar float, as NDI expects
+    static func planarFloat(fromInterleavedInt16 interleaved: Data, channels: Int) -> Data {
+        guard channels > 0 else { return Data() }
+        let samples = interleaved.count / (channels * 2)
+        guard samples > 0 else { return Data() }
+        return interleaved.withUnsafeBytes { (raw: UnsafeRawBufferPointer) -> Data in
+            let src = raw.bindMemory(to: Int16.self).baseAddress!
+            return AudioBlockPool.shared.data(count: channels * samples * 4) { block in
+                let dst = block.assumingMemoryBound(to: Float.self)
+                var scale = 1 / Float(Int16.max)
+                for channel in 0..<channels {
+                    let row = dst + channel * samples
+                    vDSP_vflt16(src + channel, vDSP_Stride(channels), row, 1, vDSP_Length(samples))
+                    vDSP_vsmul(row, 1, &scale, row, 1, vDSP_Length(samples))
+                }
+            }
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    private func reserveScratch(_ samples: Int) {
+        guard samples > scratchCapacity else { return }
+        scratch?.deallocate()
+        scratch = .allocate(capacity: samples)
+        scratchCapacity = samples
+    }
+}
@@ -0,0 +1,131 @@
+//
+//  PlayoutClock.swift
+//  NDI Bridge Mac
+//
+//  Adaptive playout schedule of the Join delay buffer, from sender timestamps
+//
+
+import Foundation
+import QuartzCore
+
+/// Horloge de lecture d'une source : convertit les timestamps de l'émetteur (timecode NDI,
+/// unités de 100 ns, communs à l'audio et à la vidéo) en heures d'émission locales.
+///
+/// `émission = timestamp + transit minimal + profondeur cible`. Le transit minimal
+/// (arrivée − timestamp) est le minimum glissant sur `baseWindow` secondes, ce qui suit la
+/// dérive entre les horloges des deux machines. L'excès de transit d'une frame au-dessus de
+/// ce minimum est son retard dû à la gigue : la profondeur cible suit le pic récent de cet
+/// excès plus une marge, bornée à [minDelay, maxDelay]. Elle monte d'un coup (une frame en
+/// retard est déjà trop tard) et ne descend que de `shrinkRate` par seconde, pour que la
+/// sortie accélère sans à-coup visible. Audio et vidéo partagent le même décalage : la
+/// synchronisation ne dépend pas de l'ordre d'arrivée.
+/// Pas thread-safe : utilisée sous le verrou de `FrameBuffer`
+final class PlayoutClock {
+    enum Media: Int {
+        case video = 0
+        case audio = 1
+    }
+
+    let minDelay: CFTimeInterval
+    let maxDelay: CFTimeInterval
+    var isAdaptive: Bool { maxDelay > minDelay }
+
+    /// Profondeur cible au-dessus du transit minimal
+    private(set) var targetDelay: CFTimeInterval
+
+    /// Gigue d'arrivée lissée (RFC 3550, sur l'écart de transit entre frames successives)
+    private(set) var jitter: CFTimeInterval = 0
+
+    private static let ticksPerSecond: Double = 10_000_000       // Timecode NDI
+    private static let baseWindow = 8                             // Secondes de minimum glissant
+    private static let margin: CFTimeInterval = 0.005             // Au-dessus du pic de gigue
+    private static let peakDecay: CFTimeInterval = 0.005          // Par seconde : oubli du pic
+    private static let shrinkRate: CFTimeInterval = 0.02          // Par seconde : 2 % d'accélération
+    private static let resetThreshold: CFTimeInterval = 2.0       // Saut de timecode : réancrage
+
+    // Minimum de transit par seconde d'arrivée, sur `baseWindow` secondes
+    private var bucketMinimums: [CFTimeInterval] = []
+    private var bucketSecond = 0
+    private var base: CFTimeInterval?
+
+    private var peakExcess: CFTimeInterval = 0
+    private var lastTransit: [CFTimeInterval?] = [nil, nil]
+    private var lastUpdate: CFTimeInterval = 0
+
+    /// Nombre de réancrages (source redémarrée, timecode discontinu)
+    private(set) var resets: UInt64 = 0
+
+    /// - Parameters:
+    ///   - minDelay: profondeur minimale (et fixe si `maxDelay` ≤ `minDelay`)
+    ///   - maxDelay: profondeur maximale en mode adaptatif
+    init(minDelay: CFTimeInterval, maxDelay: CFTimeInterval) {
+        self.minDelay = max(0, minDelay)
+        self.maxDelay = max(self.minDelay, maxDelay)
+        self.targetDelay = self.minDelay
+    }
+
+    /// Heure d'émission d'une frame arrivée à `arrival`
+    func presentationTime(timestamp: UInt64, arrival: CFTimeInterval, media: Media) -> CFTimeInterval {
+        // Sans timestamp exploitable (ancien émetteur), délai constant depuis l'arrivée
+        guard timestamp > 0 else { return arrival + targetDelay }
+
+        let sent = Double(timestamp) / PlayoutClock.ticksPerSecond
+        let transit = arrival - sent
+
+        if let current = base, abs(transit - current) > PlayoutClock.resetThreshold {
+            reset()
+            resets += 1
+        }
+        updateBase(transit: transit, arrival: arrival)
+        guard let base = base else { return arrival + targetDelay }
+
+        if let previous = lastTransit[media.rawValue] {
+            jitter += (abs(transit - previous) - jitter) / 16
+        }
+        lastTransit[media.rawValue] = transit
+
+        if isAdaptive {
+            adapt(excess: max(0, transit - base), arrival: arrival)
+        }
+        return sent + base + targetDelay
+    }
+
+    // MARK: - Private Helpers
+
+    private func reset() {
+        bucketMinimums.removeAll(keepingCapacity: true)
+        base = nil
+        peakExcess = 0
+        lastTransit = [nil, nil]
+        lastUpdate = 0
+        targetDelay = minDelay
+    }
+
+    private func updateBase(transit: CFTimeInterval, arrival: CFTimeInterval) {
+        let second = Int(arrival)
+        if bucketMinimums.isEmpty || second != bucketSecond {
+            bucketSecond = second
+            bucketMinimums.append(transit)
+            if bucketMinimums.count > PlayoutClock.baseWindow {
+                bucketMinimums.removeFirst()
+            }
+        } else {
+            bucketMinimums[bucketMinimums.count - 1] = min(bucketMinimums[bucketMinimums.count - 1], transit)
+        }
+        base = bucketMinimums.min()
+    }
+
+    private func adapt(excess: CFTimeInterval, arrival: CFTimeInterval) {
+        let elapsed = lastUpdate > 0 ? max(0, arrival - lastUpdate) : 0
+        lastUpdate = arrival
+
+        peakExcess = max(excess, peakExcess - PlayoutClock.peakDecay * elapsed)
+        let desired = min(max(peakExcess + PlayoutClock.margin, minDelay), maxDelay)
+
+        if desired > targetDelay {
+            targetDelay = desired
+        } else {
+            targetDelay = max(desired, targetDelay - PlayoutClock.shrinkRate * elapsed)
+        }
+    }
+}
@@ -0,0 +1,64 @@
+//
+//  RingQueue.swift
+//  NDI Bridge Mac
+//
+//  Growable FIFO ring buffer with O(1) push and pop
+//
+
+import Foundation
+
+/// FIFO queue backed by a circular buffer. Capacity doubles when full and is kept
+/// across `removeAll`, so a queue that reached its steady-state size stops allocating.
+/// Not thread-safe: callers provide their own locking
+struct RingQueue<Element> {
+    private var storage: [Element?]
+    private var head = 0
+    private(set) var count = 0
+
+    init(capacity: Int = 16) {
+        storage = [Element?](repeating: nil, count: max(1, capacity))
+    }
+
+    var isEmpty: Bool { count == 0 }
+
+    /// Oldest element, if any
+    var first: Element? {
+        return count > 0 ? storage[head] : nil
+    }
+
+    mutating func append(_ element: Element) {
+        if count == storage.count {
+            grow()
+        }
+        storage[(head + count) % storage.count] = element
+        count += 1
+    }
+
+    /// Remove and return the oldest element
+    mutating func popFirst() -> Element? {
+        guard count > 0 else { return nil }
+        let element = storage[head]
+        storage[head] = nil
+        head = (head + 1) % storage.count
+        count -= 1
+        return element
+    }
+
+    mutating func removeAll() {
+        while count > 0 {
+            storage[head] = nil
+            head = (head + 1) % storage.count
+            count -= 1
+        }
+        head = 0
+    }
+
+    private mutating func grow() {
+        var larger = [Element?](repeating: nil, count: storage.count * 2)
+        for i in 0..<count {
+            larger[i] = storage[(head + i) % storage.count]
+        }
+        storage = larger
+        head = 0
+    }
+}
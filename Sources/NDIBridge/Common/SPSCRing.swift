@@ -0,0 +1,112 @@
+//
+//  SPSCRing.swift
+//  NDI Bridge Mac
+//
+//  Bounded lock-free single-producer/single-consumer ring of object references
+//
+
+import Foundation
+import CAtomics
+
+/// What a full ring does with a new element
+enum RingDropPolicy: String {
+    case dropOldest = "oldest"  // Evict the oldest queued element: lowest latency
+    case dropNewest = "newest"  // Refuse the new element: keeps what is already queued
+}
+
+/// Fixed-capacity FIFO handing objects from exactly one producer thread to exactly
+/// one consumer thread without locks.
+/// `tail` is written by the producer only; `head` is advanced with a compare-exchange
+/// so that, under `.dropOldest`, the producer can evict the oldest element while the
+/// consumer may be claiming it - whichever wins the exchange owns the reference.
+/// Elements are stored as retained `Unmanaged` pointers
+final class SPSCRing<Element: AnyObject> {
+    let capacity: Int
+    let policy: RingDropPolicy
+
+    private let mask: UInt64
+    private let slots: UnsafeMutablePointer<UnsafeMutableRawPointer?>
+    private let head: UnsafeMutablePointer<UInt64>     // Next element to pop
+    private let tail: UnsafeMutablePointer<UInt64>     // Next slot to fill
+    private let drops: UnsafeMutablePointer<UInt64>
+
+    /// - Parameter capacity: rounded up to a power of two
+    init(capacity: Int, policy: RingDropPolicy) {
+        var size = 1
+        while size < max(1, capacity) { size <<= 1 }
+        self.capacity = size
+        self.policy = policy
+        self.mask = UInt64(size - 1)
+
+        slots = .allocate(capacity: size)
+        slots.initialize(repeating: nil, count: size)
+        head = .allocate(capacity: 1)
+        head.initialize(to: 0)
+        tail = .allocate(capacity: 1)
+        tail.initialize(to: 0)
+        drops = .allocate(capacity: 1)
+        drops.initialize(to: 0)
+    }
+
+    deinit {
+        while pop() != nil {}
+        slots.deallocate()
+        head.deallocate()
+        tail.deallocate()
+        drops.deallocate()
+    }
+
+    /// Elements dropped by the policy since creation
+    var droppedCount: UInt64 {
+        return catomic_load_relaxed(drops)
+    }
+
+    /// Approximate number of queued elements
+    var count: Int {
+        return Int(catomic_load_acquire(tail) &- catomic_load_acquire(head))
+    }
+
+    /// Producer side. Returns false when the policy dropped an element to make room
+    /// (the new one under `.dropNewest`, the oldest one under `.dropOldest`)
+    @discardableResult
+    func push(_ element: Element) -> Bool {
+        let position = catomic_load_relaxed(tail)
+        var dropped = false
+
+        while true {
+            let oldest = catomic_load_acquire(head)
+            guard position &- oldest >= UInt64(capacity) else { break }
+
+            guard policy == .dropOldest else {
+                catomic_fetch_add_relaxed(drops, 1)
+                return false
+            }
+
+            // Claim the oldest element; losing the exchange means the consumer just took it
+            let raw = catomic_pointer_load_acquire(slots + Int(oldest & mask))
+            if catomic_compare_exchange(head, oldest, oldest &+ 1), let raw = raw {
+                Unmanaged<Element>.fromOpaque(raw).release()
+                catomic_fetch_add_relaxed(drops, 1)
+                dropped = true
+            }
+        }
+
+        catomic_pointer_store_release(slots + Int(position & mask), Unmanaged.passRetained(element).toOpaque())
+        catomic_store_release(tail, position &+ 1)
+        return !dropped
+    }
+
+    /// Consumer side: oldest element, or nil when the ring is empty
+    func pop() -> Element? {
+        while true {
+            let position = catomic_load_acquire(head)
+            guard position != catomic_load_acquire(tail) else { return nil }
+
+            // Read before claiming: once head moves the producer may reuse the slot
+            let raw = catomic_pointer_load_acquire(slots + Int(position & mask))
+            if catomic_compare_exchange(head, position, position &+ 1), let raw = raw {
+                return Unmanaged<Element>.fromOpaque(raw).takeRetainedValue()
+            }
+        }
+    }
+}
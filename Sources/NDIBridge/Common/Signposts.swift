@@ -0,0 +1,64 @@
+//
+//  Signposts.swift
+//  NDI Bridge Mac
+//
+//  os_signpost intervals of the frame pipeline, for Instruments
+//
+
+import Foundation
+import os
+
+/// Pipeline stages as signpost intervals (Instruments → os_signpost, subsystem
+/// `com.ndibridge`, category `pipeline`).
+/// Intervals that span threads - encode, send, reassembly, decode, delay buffer - are
+/// keyed by `frameID`, so each frame's stages line up under one ID; synchronous ones
+/// get a fresh ID and carry the frame timestamp as metadata.
+/// Each call is one flag check while no trace is recording
+enum Signposts {
+    static let log = OSLog(subsystem: "com.ndibridge", category: "pipeline")
+
+    /// One ID per (source, rendition, frame timestamp): the timestamp travels in every
+    /// NDIB header, so a frame keeps its ID from capture on the Host to NDI output on Join.
+    /// Simulcast renditions share their source frame's timestamp, hence the layer
+    static func frameID(timestamp: UInt64, sourceId: UInt8, layer: UInt8 = 0) -> OSSignpostID {
+        let value = (UInt64(sourceId) << 56 | UInt64(layer) << 48) ^ timestamp
+        return OSSignpostID(value == 0 || value == .max ? 1 : value)  // 0 and ~0 are reserved
+    }
+
+    @inline(__always)
+    static func begin(_ name: StaticString, timestamp: UInt64, sourceId: UInt8, layer: UInt8 = 0) {
+        guard log.signpostsEnabled else { return }
+        os_signpost(.begin, log: log, name: name, signpostID: frameID(timestamp: timestamp, sourceId: sourceId, layer: layer),
+                    "source %u layer %u frame %llu", UInt32(sourceId), UInt32(layer), timestamp)
+    }
+
+    @inline(__always)
+    static func begin(_ name: StaticString, timestamp: UInt64, sourceId: UInt8, layer: UInt8 = 0, sequence: UInt32) {
+        guard log.signpostsEnabled else { return }
+        os_signpost(.begin, log: log, name: name, signpostID: frameID(timestamp: timestamp, sourceId: sourceId, layer: layer),
+                    "source %u layer %u frame %llu seq %u", UInt32(sourceId), UInt32(layer), timestamp, sequence)
+    }
+
+    @inline(__always)
+    static func end(_ name: StaticString, timestamp: UInt64, sourceId: UInt8, layer: UInt8 = 0) {
+        guard log.signpostsEnabled else { return }
+        os_signpost(.end, log: log, name: name, signpostID: frameID(timestamp: timestamp, sourceId: sourceId, layer: layer))
+    }
+
+    /// End of an interval whose frame was given up (decode error, incomplete frame)
+    @inline(__always)
+    static func abandon(_ name: StaticString, timestamp: UInt64, sourceId: UInt8, layer: UInt8 = 0) {
+        guard log.signpostsEnabled else { return }
+        os_signpost(.end, log: log, name: name, signpostID: frameID(timestamp: timestamp, sourceId: sourceId, layer: layer), "dropped")
+    }
+
+    /// Synchronous interval around `body` on the calling thread
+    @inline(__always)
+    static func interval<T>(_ name: StaticString, timestamp: UInt64 = 0, _ body: () throws -> T) rethrows -> T {
+        guard log.signpostsEnabled else { return try body() }
+        let id = OSSignpostID(log: log)
+        os_signpost(.begin, log: log, name: name, signpostID: id, "frame %llu", timestamp)
+        defer { os_signpost(.end, log: log, name: name, signpostID: id) }
+        return try body()
+    }
+}
@@ -0,0 +1,82 @@
+//
+//  VideoCodec.swift
+//  NDI Bridge Mac
+//
+//  Video codecs carried in the NDIB header (byte 36)
+//
+
+import Foundation
+import CoreMedia
+import VideoToolbox
+
+/// Codec of the video elementary stream
+enum VideoCodec: UInt8 {
+    case h264 = 0
+    case hevc = 1
+
+    init?(name: String) {
+        switch name.lowercased() {
+        case "h264", "avc": self = .h264
+        case "hevc", "h265": self = .hevc
+        default: return nil
+        }
+    }
+
+    var name: String {
+        switch self {
+        case .h264: return "H.264"
+        case .hevc: return "HEVC"
+        }
+    }
+
+    var codecType: CMVideoCodecType {
+        switch self {
+        case .h264: return kCMVideoCodecType_H264
+        case .hevc: return kCMVideoCodecType_HEVC
+        }
+    }
+
+    /// Profile used when the encoder config does not name one
+    var defaultProfile: CFString {
+        switch self {
+        case .h264: return kVTProfileLevel_H264_High_AutoLevel
+        case .hevc: return kVTProfileLevel_HEVC_Main_AutoLevel
+        }
+    }
+
+    /// NAL unit type from the first byte of the NAL header
+    func nalType(_ headerByte: UInt8) -> UInt8 {
+        switch self {
+        case .h264: return headerByte & 0x1F
+        case .hevc: return (headerByte >> 1) & 0x3F
+        }
+    }
+
+    /// Kind of a NAL unit, as far as the bridge cares
+    enum NALKind {
+        case vps, sps, pps
+        case slice
+        case other
+    }
+
+    func nalKind(_ headerByte: UInt8) -> NALKind {
+        let type = nalType(headerByte)
+        switch self {
+        case .h264:
+            switch type {
+            case 7: return .sps
+            case 8: return .pps
+            case 1, 5: return .slice
+            default: return .other
+            }
+        case .hevc:
+            switch type {
+            case 32: return .vps
+            case 33: return .sps
+            case 34: return .pps
+            case 0...31: return .slice
+            default: return .other
+            }
+        }
+    }
+}
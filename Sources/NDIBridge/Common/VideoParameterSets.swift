@@ -0,0 +1,39 @@
+//
+//  VideoParameterSets.swift
+//  NDI Bridge Mac
+//
+//  Out-of-band parameter set packets for AVCC video streams
+//
+
+import Foundation
+
+/// Payload of a `MediaType.parameterSets` packet: u8 count, then per set u16 length + bytes.
+/// Sent just before each AVCC keyframe, which carries no SPS/PPS of its own
+enum VideoParameterSets {
+    static func serialize(_ parameterSets: [Data]) -> Data {
+        var payload = Data(capacity: 1 + parameterSets.reduce(0) { $0 + 2 + $1.count })
+        payload.append(UInt8(min(parameterSets.count, Int(UInt8.max))))
+        for set in parameterSets.prefix(Int(UInt8.max)) {
+            withUnsafeBytes(of: UInt16(set.count).bigEndian) { payload.append(contentsOf: $0) }
+            payload.append(set)
+        }
+        return payload
+    }
+
+    static func parse(_ payload: Data) -> [Data]? {
+        let bytes = [UInt8](payload)
+        guard let count = bytes.first else { return nil }
+
+        var sets: [Data] = []
+        var offset = 1
+        for _ in 0..<count {
+            guard offset + 2 <= bytes.count else { return nil }
+            let length = Int(bytes[offset]) << 8 | Int(bytes[offset + 1])
+            offset += 2
+            guard offset + length <= bytes.count else { return nil }
+            sets.append(Data(bytes[offset..<(offset + length)]))
+            offset += length
+        }
+        return sets
+    }
+}
@@ -0,0 +1,213 @@
+//
+//  AudioEncoder.swift
+//  NDI Bridge Mac
+//
+//  Low-delay AAC-ELD audio encoding using AudioToolbox
+//
+
+import Foundation
+import AudioToolbox
+import Accelerate
+
+/// Compresses the planar float audio of one Host pipeline into `AudioPacketGroup` payloads.
+/// The converter is (re)created whenever the source's rate or channel count changes.
+/// Runs on the NDI capture thread; not thread-safe
+final class AudioEncoder {
+    let codec: AudioCodec
+    private let bitratePerChannel: Int
+
+    private var converter: AudioConverterRef?
+    private var sampleRate: Int32 = 0
+    private var channels: Int32 = 0
+    private var cookie = Data()
+    private var maxPacketSize = 0
+    private var framesSinceCookie = 0
+    private var isUnsupported = false  // Converter creation failed for the current format
+    private static let cookieInterval = 50  // Frames between cookies, ~1 s of NDI audio
+
+    // Interleaved input of the current call, handed whole to the converter's input proc
+    private var input: UnsafeMutablePointer<Float>?
+    private var inputCapacity = 0
+    private var inputFrames = 0
+
+    // Packets produced by the current call
+    private var output: UnsafeMutableRawPointer?
+    private var outputCapacity = 0
+    private var packetSizes: [UInt32] = []
+
+    /// Input proc status meaning "nothing more this call" (not an error)
+    private static let inputExhausted: OSStatus = 0x6E6F6D6F  // 'nomo'
+
+    init(codec: AudioCodec, bitratePerChannel: Int = 64_000) {
+        self.codec = codec
+        self.bitratePerChannel = bitratePerChannel
+    }
+
+    deinit {
+        if let converter = converter {
+            AudioConverterDispose(converter)
+        }
+        input?.deallocate()
+        output?.deallocate()
+    }
+
+    /// Whether frames of this format can be encoded (creating the converter on a format
+    /// change); the caller sends PCM otherwise
+    func canEncode(sampleRate: Int32, channels: Int32) -> Bool {
+        guard channels > 0, sampleRate > 0 else { return false }
+        if sampleRate != self.sampleRate || channels != self.channels {
+            isUnsupported = !configure(sampleRate: sampleRate, channels: channels)
+        }
+        return !isUnsupported
+    }
+
+    /// Encode one NDI audio frame (contiguous planar float).
+    /// Returns nil while the encoder is still filling its first packet, or on error
+    func encode(planar: Data, sampleRate: Int32, channels: Int32) -> Data? {
+        guard canEncode(sampleRate: sampleRate, channels: channels), let converter = converter else { return nil }
+
+        // NDI is planar, the encoder takes interleaved float
+        let channelCount = Int(channels)
+        let frames = planar.count / (channelCount * 4)
+        guard frames > 0 else { return nil }
+        reserveInput(frames * channelCount)
+        guard let input = input else { return nil }
+        planar.withUnsafeBytes { (raw: UnsafeRawBufferPointer) in
+            let src = raw.bindMemory(to: Float.self).baseAddress!
+            vDSP_mtrans(src, 1, input, 1, vDSP_Length(frames), vDSP_Length(channelCount))
+        }
+        inputFrames = frames
+
+        // Drain every packet the new samples complete
+        reserveOutput(maxPacketSize * (frames / codec.framesPerPacket + 2))
+        guard let output = output else { return nil }
+        packetSizes.removeAll(keepingCapacity: true)
+        var written = 0
+        while written + maxPacketSize <= outputCapacity {
+            var packetCount: UInt32 = 1
+            var packet = AudioStreamPacketDescription()
+            var buffers = AudioBufferList(
+                mNumberBuffers: 1,
+                mBuffers: AudioBuffer(mNumberChannels: UInt32(channels), mDataByteSize: UInt32(maxPacketSize),
+                                      mData: output.advanced(by: written))
+            )
+            let status = AudioConverterFillComplexBuffer(converter, AudioEncoder.inputProc,
+                                                         Unmanaged.passUnretained(self).toOpaque(),
+                                                         &packetCount, &buffers, &packet)
+            if packetCount > 0 {
+                let size = buffers.mBuffers.mDataByteSize
+                packetSizes.append(size)
+                written += Int(size)
+            }
+            if packetCount == 0 || status != noErr {
+                if status != noErr && status != AudioEncoder.inputExhausted {
+                    logger.warning("\(codec.name) encode error: \(status)", subsystem: .host)
+                }
+                break
+            }
+        }
+        guard !packetSizes.isEmpty else { return nil }
+
+        // Cookie on the first frame and then periodically, for receivers joining late
+        let frameCookie = framesSinceCookie == 0 ? cookie : Data()
+        framesSinceCookie = (framesSinceCookie + 1) % AudioEncoder.cookieInterval
+
+        let size = AudioPacketGroup.size(cookie: frameCookie.count, packetCount: packetSizes.count, packetBytes: written)
+        return AudioBlockPool.shared.data(count: size) { block in
+            let offset = AudioPacketGroup.writeHeader(to: block, cookie: frameCookie, packetSizes: packetSizes)
+            block.advanced(by: offset).copyMemory(from: output, byteCount: written)
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    private static let inputProc: AudioConverterComplexInputDataProc = { _, ioPacketCount, ioData, _, userData in
+        guard let userData = userData else { return AudioEncoder.inputExhausted }
+        let encoder = Unmanaged<AudioEncoder>.fromOpaque(userData).takeUnretainedValue()
+        guard encoder.inputFrames > 0, let input = encoder.input else {
+            ioPacketCount.pointee = 0
+            return AudioEncoder.inputExhausted
+        }
+
+        // Linear PCM: one packet per frame
+        ioPacketCount.pointee = UInt32(encoder.inputFrames)
+        let buffers = UnsafeMutableAudioBufferListPointer(ioData)
+        buffers[0].mData = UnsafeMutableRawPointer(input)
+        buffers[0].mDataByteSize = UInt32(encoder.inputFrames * Int(encoder.channels) * 4)
+        buffers[0].mNumberChannels = UInt32(encoder.channels)
+        encoder.inputFrames = 0
+        return noErr
+    }
+
+    private func configure(sampleRate: Int32, channels: Int32) -> Bool {
+        if let converter = converter {
+            AudioConverterDispose(converter)
+            self.converter = nil
+        }
+        self.sampleRate = sampleRate
+        self.channels = channels
+
+        var inputFormat = AudioStreamBasicDescription(
+            mSampleRate: Float64(sampleRate),
+            mFormatID: kAudioFormatLinearPCM,
+            mFormatFlags: kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked,
+            mBytesPerPacket: UInt32(4 * channels),
+            mFramesPerPacket: 1,
+            mBytesPerFrame: UInt32(4 * channels),
+            mChannelsPerFrame: UInt32(channels),
+            mBitsPerChannel: 32,
+            mReserved: 0
+        )
+        var outputFormat = AudioStreamBasicDescription()
+        outputFormat.mSampleRate = Float64(sampleRate)
+        outputFormat.mFormatID = codec.formatID
+        outputFormat.mFramesPerPacket = UInt32(codec.framesPerPacket)
+        outputFormat.mChannelsPerFrame = UInt32(channels)
+
+        var newConverter: AudioConverterRef?
+        let status = AudioConverterNew(&inputFormat, &outputFormat, &newConverter)
+        guard status == noErr, let created = newConverter else {
+            logger.warning("\(codec.name) encoder unavailable for \(sampleRate)Hz \(channels)ch (status \(status)) - sending PCM", subsystem: .host)
+            return false
+        }
+
+        var bitrate = UInt32(bitratePerChannel * Int(channels))
+        if AudioConverterSetProperty(created, kAudioConverterEncodeBitRate, UInt32(MemoryLayout<UInt32>.size), &bitrate) != noErr {
+            logger.warning("\(codec.name) encoder rejected \(bitrate / 1000) kbps, using its default", subsystem: .host)
+        }
+
+        var packetSize: UInt32 = 0
+        var propertySize = UInt32(MemoryLayout<UInt32>.size)
+        AudioConverterGetProperty(created, kAudioConverterPropertyMaximumOutputPacketSize, &propertySize, &packetSize)
+        maxPacketSize = max(Int(packetSize), 1)
+
+        var cookieSize: UInt32 = 0
+        cookie = Data()
+        if AudioConverterGetPropertyInfo(created, kAudioConverterCompressionMagicCookie, &cookieSize, nil) == noErr,
+           cookieSize > 0, cookieSize <= UInt32(UInt8.max) {
+            var bytes = [UInt8](repeating: 0, count: Int(cookieSize))
+            if AudioConverterGetProperty(created, kAudioConverterCompressionMagicCookie, &cookieSize, &bytes) == noErr {
+                cookie = Data(bytes.prefix(Int(cookieSize)))
+            }
+        }
+
+        converter = created
+        framesSinceCookie = 0
+        logger.info("\(codec.name) encoder: \(sampleRate)Hz \(channels)ch, \(bitrate / 1000) kbps", subsystem: .host)
+        return true
+    }
+
+    private func reserveInput(_ count: Int) {
+        guard count > inputCapacity else { return }
+        input?.deallocate()
+        input = .allocate(capacity: count)
+        inputCapacity = count
+    }
+
+    private func reserveOutput(_ count: Int) {
+        guard count > outputCapacity else { return }
+        output?.deallocate()
+        output = .allocate(byteCount: count, alignment: 16)
+        outputCapacity = count
+    }
+}
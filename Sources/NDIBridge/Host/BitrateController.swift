@@ -0,0 +1,128 @@
+//
+//  BitrateController.swift
+//  NDI Bridge Mac
+//
+//  Loss/jitter driven encoder bitrate adaptation
+//
+
+import Foundation
+import QuartzCore
+
+/// Adaptive bitrate bounds and tuning
+struct BitrateControllerConfig {
+    var minBitrate: Int = 2_000_000              // Never go below (bps)
+    var maxBitrate: Int = 8_000_000              // Never go above (bps)
+    var lossBackoffThreshold: Double = 0.05      // Loss above this cuts the rate
+    var lossProbeThreshold: Double = 0.01        // Loss below this allows probing upward
+    var probeFactor: Double = 1.05               // Increase per clean report
+    var jitterBackoffFactor: Double = 0.9        // Cut when jitter says the queue is building
+    var jitterThreshold: CFTimeInterval = 0.010  // Jitter ignored below this (10 ms)
+    var holdAfterBackoff: CFTimeInterval = 2.0   // No probing this long after a cut
+}
+
+/// AIMD controller fed by Join receiver reports.
+/// Loss above the backoff threshold (or any frame Join had to drop) cuts the rate in
+/// proportion to the loss; a jitter surge well above its running baseline is read as a
+/// building queue and cuts by a fixed step; clean reports probe upward by a few percent
+/// once the link has been stable for `holdAfterBackoff`.
+/// Every Join watching the source reports on its own; `add` merges one round of them
+/// into a single update so the shared encoder is retuned once per report interval
+final class BitrateController {
+    let config: BitrateControllerConfig
+    private(set) var bitrate: Int
+
+    private var jitterBaseline: CFTimeInterval?
+    private var lastBackoff: CFTimeInterval = 0
+
+    // Report round in progress: merged reports per Join, and when each Join last reported
+    private var pending: [ObjectIdentifier: ReceiverReport] = [:]
+    private var lastSeen: [ObjectIdentifier: CFTimeInterval] = [:]
+    private var roundStart: CFTimeInterval = 0
+    private static let silentIntervals = 3.0  // A Join quiet this many intervals no longer holds a round open
+
+    init(initialBitrate: Int, config: BitrateControllerConfig) {
+        self.config = config
+        self.bitrate = min(max(initialBitrate, config.minBitrate), config.maxBitrate)
+    }
+
+    /// Collect one Join's report. The round closes once every Join heard from recently
+    /// has reported, or a report interval after it opened (a Join stopped reporting);
+    /// its merged report - summed packet counts, worst jitter - then goes to `update`.
+    /// Returns the new target when it changed
+    func add(_ report: ReceiverReport, from peer: ObjectIdentifier, now: CFTimeInterval = CACurrentMediaTime()) -> Int? {
+        let interval = CFTimeInterval(max(report.intervalMs, 1)) / 1000
+        lastSeen[peer] = now
+        lastSeen = lastSeen.filter { now - $0.value <= interval * BitrateController.silentIntervals }
+
+        if pending.isEmpty {
+            roundStart = now
+        }
+        pending[peer] = pending[peer].map { $0.merged(with: report) } ?? report
+
+        let complete = lastSeen.keys.allSatisfy { pending[$0] != nil }
+        guard complete || now - roundStart >= interval else { return nil }
+
+        let round = pending.values.reduce(ReceiverReport(sourceId: report.sourceId)) { $0.merged(with: $1) }
+        pending.removeAll(keepingCapacity: true)
+        return update(with: round, now: now)
+    }
+
+    /// Fold in one report; returns the new target when it changed
+    func update(with report: ReceiverReport, now: CFTimeInterval = CACurrentMediaTime()) -> Int? {
+        guard report.packetsExpected > 0 else { return nil }  // Nothing sent in the interval
+
+        let loss = report.lossFraction
+        let jitter = CFTimeInterval(report.jitterMicros) / 1_000_000
+        let baseline = jitterBaseline ?? jitter
+        let jitterSurge = jitter > config.jitterThreshold && jitter > baseline * 2
+
+        var target = Double(bitrate)
+        let reason: String
+
+        if loss > config.lossBackoffThreshold || report.framesDropped > 0 {
+            target *= min(0.9, 1 - loss / 2)
+            reason = report.framesDropped > 0 ? "\(report.framesDropped) frame(s) dropped" : "loss"
+            lastBackoff = now
+        } else if jitterSurge {
+            target *= config.jitterBackoffFactor
+            reason = "jitter"
+            lastBackoff = now
+        } else if loss < config.lossProbeThreshold && now - lastBackoff >= config.holdAfterBackoff {
+            target *= config.probeFactor
+            reason = "probe"
+        } else {
+            reason = "hold"
+        }
+
+        // The baseline only learns from uncongested intervals
+        if !jitterSurge {
+            jitterBaseline = baseline + (jitter - baseline) * 0.05
+        }
+
+        let clamped = min(max(Int(target), config.minBitrate), config.maxBitrate)
+        guard abs(clamped - bitrate) * 100 >= bitrate else { return nil }  // Under 1%: not worth a reconfigure
+
+        logger.logNetwork(bitrate: clamped, previousBitrate: bitrate, loss: loss, jitter: jitter, reason: reason)
+        bitrate = clamped
+        return clamped
+    }
+}
+
+private extension ReceiverReport {
+    /// Both reports as one: packet and byte counts add up, jitter keeps the worst
+    func merged(with other: ReceiverReport) -> ReceiverReport {
+        var result = self
+        result.intervalMs = max(intervalMs, other.intervalMs)
+        result.packetsExpected = ReceiverReport.saturatingSum(packetsExpected, other.packetsExpected)
+        result.packetsLost = ReceiverReport.saturatingSum(packetsLost, other.packetsLost)
+        result.framesDropped = ReceiverReport.saturatingSum(framesDropped, other.framesDropped)
+        result.jitterMicros = max(jitterMicros, other.jitterMicros)
+        result.bytesReceived = ReceiverReport.saturatingSum(bytesReceived, other.bytesReceived)
+        return result
+    }
+
+    static func saturatingSum<T: FixedWidthInteger>(_ a: T, _ b: T) -> T {
+        let (sum, overflow) = a.addingReportingOverflow(b)
+        return overflow ? .max : sum
+    }
+}
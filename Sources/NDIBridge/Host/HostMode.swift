@@ -2,7 +2,7 @@
 //  HostMode.swift
 //  NDI Bridge Mac
 //
-//  Orchestrates NDI capture → H.264 encoding → network transmission
+//  Orchestrates NDI capture → H.264 encoding → network transmission, for one or more sources
 //
 
 import Foundation
@@ -13,11 +13,29 @@ import Network
 struct HostModeConfig {
     var targetHost: String = "127.0.0.1"
     var targetPort: UInt16 = 5990
+    var extraTargets: [NetworkTarget] = []             // Fan-out: more Joins or multicast groups, same packets
+    var multicastTTL: Int = 8                          // Hop limit of multicast targets
+    var controlPort: UInt16 = 5991                     // Local port multicast Joins send NACKs/reports to
+    var renditions: [VideoRenditionConfig] = []        // Simulcast: scaled layers 1, 2... Joins can subscribe to
     var encoder: VideoEncoderConfig = .auto  // Auto-detect from source
     var autoSelectFirstSource: Bool = false
     var sourceDiscoveryTimeout: TimeInterval = 5.0
-    var sourceName: String? = nil                      // Specific source name to use
+    var sourceNames: [String] = []                     // Specific source names to use (one pipeline each)
+    var bridgeAllSources: Bool = false                 // Bridge every source left after exclusion
     var excludePatterns: [String] = ["Bridge"]         // Patterns to exclude from auto-selection
+    var batchTransmit: Bool = true                     // Send each frame's fragments in one batch
+    var fecGroupSize: Int = 0                          // Video FEC: 1 parity per N fragments (0 = off)
+    var retransmitWindowMs: Int = 200                  // Keep sent frames this long for Join NACKs (0 = off)
+    var pacingFraction: Double = 0.5                   // Spread each video frame over this part of the frame interval (0 = off)
+    var passthrough: Bool = false                      // Forward NDI|HX streams without re-encoding (Advanced SDK)
+    var adaptiveBitrate: BitrateControllerConfig? = nil // Retune the encoder from Join reports (nil = fixed bitrate)
+    var captureQueueDepth: Int = 4                     // Captured frames waiting for the encoder
+    var captureDropPolicy: RingDropPolicy = .dropOldest // What a full capture queue drops
+    var colorFormat: NDIColorFormat = .uyvy            // Uncompressed NDI receive format
+    var audioInt16: Bool = false                       // Audio as int16 on the wire (half of float) to Join that supports it
+    var audioCodec: AudioCodec = .pcm                  // Compressed audio to Join that supports it (PCM otherwise)
+    var audioBitratePerChannel: Int = 64_000           // Compressed audio bitrate per channel
+    var metricsPort: UInt16 = 0                        // HTTP port of the Prometheus/JSON metrics (0 = off)
 }
 
 /// Error types for host mode
@@ -26,10 +44,12 @@ enum HostModeError: Error, LocalizedError {
     case encoderConfigFailed
     case networkFailed
     case alreadyRunning
+    case tooManySources
 
     var errorDescription: String? {
         switch self {
         case .noSourceSelected: return "No NDI source selected"
+        case .tooManySources: return "Too many NDI sources (max \(HostMode.maxSources))"
         case .encoderConfigFailed: return "Failed to configure encoder"
         case .networkFailed: return "Network connection failed"
         case .alreadyRunning: return "Host mode is already running"
@@ -39,25 +59,40 @@ enum HostModeError: Error, LocalizedError {
 
 /// Main host mode controller
 /// Captures NDI → Encodes H.264 → Sends over network
-final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDelegate {
+/// Each selected source gets its own `HostPipeline`; the pipelines share the NDI
+/// runtime, the finder and one `NetworkSender` (one socket per target, same packets to all)
+final class HostMode: NetworkSenderDelegate {
 
-    private let ndiReceiver = NDIReceiver()
-    private let encoder = VideoEncoder()
+    /// Source ids 0...254 - 0xFF addresses all sources in keyframe requests
+    static let maxSources = Int(NetworkSender.allSources)
+
+    private let ndiReceiver = NDIReceiver()  // Discovery; reused by the first pipeline
     private let networkSender: NetworkSender
+    private var pipelines: [HostPipeline] = []
 
     private var config: HostModeConfig
     private var isRunning = false
-    private var selectedSource: NDISource?
+    private var selectedSources: [NDISource] = []
+    private var metricsServer: MetricsServer?
 
     // Statistics
     private var startTime: Date?
-    private var framesProcessed: UInt64 = 0
 
     init(config: HostModeConfig = HostModeConfig()) {
         self.config = config
         self.networkSender = NetworkSender(config: NetworkSenderConfig(
             host: config.targetHost,
-            port: config.targetPort
+            port: config.targetPort,
+            batchTransmit: config.batchTransmit,
+            fecGroupSize: config.fecGroupSize,
+            retransmitWindowMs: config.retransmitWindowMs,
+            pacingFraction: config.pacingFraction,
+            frameRate: config.encoder.frameRate > 0 ? config.encoder.frameRate : 60,
+            audioInt16: config.audioInt16,
+            extraTargets: config.extraTargets,
+            multicastTTL: config.multicastTTL,
+            controlPort: config.controlPort,
+            layers: 1 + config.renditions.count
         ))
 
         logger.info("HostMode initialized", subsystem: .host)
@@ -76,13 +111,12 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
 
         logger.info("═══════════════════════════════════════════════════════", subsystem: .host)
         logger.info("Starting HOST MODE (Sender)", subsystem: .host)
-        logger.info("Target: \(config.targetHost):\(config.targetPort)", subsystem: .host)
+        logger.info("Target: \(targetList)", subsystem: .host)
         logger.info("═══════════════════════════════════════════════════════", subsystem: .host)
 
         // Step 1: Initialize NDI
         logger.info("Step 1/5: Initializing NDI SDK...", subsystem: .host)
         try ndiReceiver.initialize()
-        ndiReceiver.delegate = self
 
         // Step 2: Discover sources
         logger.info("Step 2/5: Discovering NDI sources...", subsystem: .host)
@@ -112,46 +146,81 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
         }
 
         // Source selection logic
-        if let specificName = config.sourceName {
-            // User specified a source name - find it
-            selectedSource = allSources.first { $0.name.localizedCaseInsensitiveContains(specificName) }
-            if selectedSource == nil {
-                logger.error("Source '\(specificName)' not found", subsystem: .host)
-                logger.info("Available sources:", subsystem: .host)
-                for src in allSources {
-                    logger.info("  - \(src.name)", subsystem: .host)
+        if !config.sourceNames.isEmpty {
+            // User specified source names - find each of them
+            for specificName in config.sourceNames {
+                guard let match = allSources.first(where: { candidate in
+                    candidate.name.localizedCaseInsensitiveContains(specificName)
+                        && !selectedSources.contains { $0.name == candidate.name }
+                }) else {
+                    logger.error("Source '\(specificName)' not found", subsystem: .host)
+                    logger.info("Available sources:", subsystem: .host)
+                    for src in allSources {
+                        logger.info("  - \(src.name)", subsystem: .host)
+                    }
+                    throw NDIError.noSourcesFound
                 }
-                throw NDIError.noSourcesFound
+                selectedSources.append(match)
+                logger.info("Using specified source: \(match.name)", subsystem: .host)
             }
-            logger.info("Using specified source: \(selectedSource?.name ?? "unknown")", subsystem: .host)
+        } else if config.bridgeAllSources {
+            // Multi-source mode - every filtered source
+            selectedSources = filteredSources
+            logger.info("Bridging all \(filteredSources.count) source(s)", subsystem: .host)
         } else if config.autoSelectFirstSource {
             // Auto mode - select first filtered source
-            selectedSource = filteredSources.first
-            logger.info("Auto-selected: \(selectedSource?.name ?? "unknown")", subsystem: .host)
+            selectedSources = Array(filteredSources.prefix(1))
+            logger.info("Auto-selected: \(selectedSources.first?.name ?? "unknown")", subsystem: .host)
         } else {
             // Interactive mode - prompt user to choose
-            selectedSource = promptForSource(from: filteredSources)
-            if selectedSource == nil {
+            guard let choice = promptForSource(from: filteredSources) else {
                 throw HostModeError.noSourceSelected
             }
-            logger.info("User selected: \(selectedSource?.name ?? "unknown")", subsystem: .host)
+            selectedSources = [choice]
+            logger.info("User selected: \(choice.name)", subsystem: .host)
         }
 
-        guard let source = selectedSource else {
+        guard !selectedSources.isEmpty else {
             throw HostModeError.noSourceSelected
         }
+        guard selectedSources.count <= HostMode.maxSources else {
+            throw HostModeError.tooManySources
+        }
 
-        // Connect to source
-        try ndiReceiver.connect(to: source)
-
-        // Step 4: Configure encoder
-        logger.info("Step 4/5: Configuring H.264 encoder...", subsystem: .host)
-        encoder.delegate = self
+        // Step 4: One capture + encoder pipeline per source
+        logger.info("Step 4/5: Configuring \(selectedSources.count) \(config.encoder.codec.name) pipeline(s)...", subsystem: .host)
         do {
-            try encoder.configure(config: config.encoder)
+            for (index, source) in selectedSources.enumerated() {
+                let receiver: NDIReceiver
+                if index == 0 {
+                    receiver = ndiReceiver
+                } else {
+                    receiver = NDIReceiver()
+                    try receiver.initialize()
+                }
+
+                let pipeline = HostPipeline(
+                    sourceId: UInt8(index),
+                    source: source,
+                    receiver: receiver,
+                    networkSender: networkSender,
+                    encoderConfig: config.encoder,
+                    passthrough: config.passthrough,
+                    adaptiveBitrate: config.adaptiveBitrate,
+                    captureQueueDepth: config.captureQueueDepth,
+                    captureDropPolicy: config.captureDropPolicy,
+                    colorFormat: config.colorFormat,
+                    audioCodec: config.audioCodec,
+                    audioBitratePerChannel: config.audioBitratePerChannel,
+                    renditions: config.renditions
+                )
+                pipelines.append(pipeline)
+                try pipeline.prepare()
+            }
         } catch {
-            logger.error("Encoder configuration failed: \(error.localizedDescription)", subsystem: .host)
-            throw HostModeError.encoderConfigFailed
+            pipelines.forEach { $0.stop() }
+            pipelines.removeAll()
+            throw error
         }
 
         // Step 5: Connect network
@@ -162,11 +231,14 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
         // Start capture
         isRunning = true
         startTime = Date()
-        ndiReceiver.startCapture()
+        pipelines.forEach { $0.startCapture() }
+        startMetricsServer()
 
         logger.success("═══════════════════════════════════════════════════════", subsystem: .host)
         logger.success("HOST MODE STARTED", subsystem: .host)
-        logger.success("Streaming: \(source.name) → \(config.targetHost):\(config.targetPort)", subsystem: .host)
+        for pipeline in pipelines {
+            logger.success("Streaming: \(pipeline.source.name) → \(targetList) (source \(pipeline.sourceId))", subsystem: .host)
+        }
         logger.success("═══════════════════════════════════════════════════════", subsystem: .host)
     }
 
@@ -177,19 +249,33 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
         logger.info("Stopping Host Mode...", subsystem: .host)
 
         isRunning = false
-        ndiReceiver.stop()
-        encoder.flush()
-        encoder.invalidate()
+        pipelines.forEach { $0.stop() }
         networkSender.disconnect()
+        metricsServer?.stop()
+        metricsServer = nil
 
         if let start = startTime {
             let duration = Date().timeIntervalSince(start)
-            logger.success("Host mode stopped. Duration: \(String(format: "%.1f", duration))s, Frames: \(framesProcessed)", subsystem: .host)
+            let frames = pipelines.reduce(UInt64(0)) { $0 + $1.framesProcessed }
+            logger.success("Host mode stopped. Duration: \(String(format: "%.1f", duration))s, Frames: \(frames)", subsystem: .host)
         }
+        pipelines.removeAll()
     }
 
     // MARK: - Private Helpers
 
+    /// Metrics are optional: a busy port must not keep the stream from starting
+    private func startMetricsServer() {
+        guard config.metricsPort > 0 else { return }
+        let server = MetricsServer(port: config.metricsPort)
+        do {
+            try server.start()
+            metricsServer = server
+        } catch {
+            logger.warning("Metrics endpoint unavailable on port \(config.metricsPort): \(error.localizedDescription)", subsystem: .host)
+        }
+    }
+
     /// Prompt user to select an NDI source interactively
     private func promptForSource(from sources: [NDISource]) -> NDISource? {
         print("\n╔═══════════════════════════════════════════════════════╗")
@@ -223,58 +309,13 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
         guard let source = sources.first(where: { $0.name.contains(name) }) else {
             throw NDIError.noSourcesFound
         }
-        selectedSource = source
+        selectedSources = [source]
         logger.info("Source selected: \(source.name)", subsystem: .host)
     }
 
-    // MARK: - NDIReceiverDelegate
-
-    func ndiReceiver(_ receiver: NDIReceiver, didReceiveVideoFrame pixelBuffer: CVPixelBuffer, timestamp: UInt64, frameNumber: UInt64) {
-        framesProcessed = frameNumber
-
-        // Encode the video frame
-        do {
-            try encoder.encode(pixelBuffer: pixelBuffer, timestamp: timestamp)
-        } catch {
-            logger.error("Encoding error: \(error.localizedDescription)", subsystem: .host)
-        }
-    }
-
-    func ndiReceiver(_ receiver: NDIReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32) {
-        // Send audio directly over network (no encoding, PCM passthrough)
-        networkSender.sendAudio(data: data, timestamp: timestamp, sampleRate: sampleRate, channels: channels)
-    }
-
-    func ndiReceiver(_ receiver: NDIReceiver, didDisconnect error: Error?) {
-        if let error = error {
-            logger.error("NDI disconnected: \(error.localizedDescription)", subsystem: .host)
-        } else {
-            logger.warning("NDI source disconnected", subsystem: .host)
-        }
-
-        // Attempt reconnect
-        if isRunning, let source = selectedSource {
-            logger.info("Attempting to reconnect...", subsystem: .host)
-            DispatchQueue.main.asyncAfter(deadline: .now() + 2.0) { [weak self] in
-                do {
-                    try self?.ndiReceiver.connect(to: source)
-                    self?.ndiReceiver.startCapture()
-                } catch {
-                    logger.error("Reconnect failed: \(error.localizedDescription)", subsystem: .host)
-                }
-            }
-        }
-    }
-
-    // MARK: - VideoEncoderDelegate
-
-    func videoEncoder(_ encoder: VideoEncoder, didEncodeData data: Data, isKeyframe: Bool, timestamp: UInt64, duration: UInt64) {
-        // Send encoded data over network
-        networkSender.send(data: data, isKeyframe: isKeyframe, timestamp: timestamp)
-    }
-
-    func videoEncoder(_ encoder: VideoEncoder, didFailWithError error: Error) {
-        logger.error("Encoder error: \(error.localizedDescription)", subsystem: .host)
+    private var targetList: String {
+        let targets = [NetworkTarget(host: config.targetHost, port: config.targetPort)] + config.extraTargets
+        return targets.map { $0.isMulticast ? "\($0) (multicast)" : "\($0)" }.joined(separator: ", ")
     }
 
     // MARK: - NetworkSenderDelegate
@@ -292,4 +333,14 @@ final class HostMode: NDIReceiverDelegate, VideoEncoderDelegate, NetworkSenderDe
     func networkSender(_ sender: NetworkSender, didUpdateStats bytesSent: UInt64, packetsent: UInt64) {
         // Statistics are logged by NetworkSender itself
     }
+
+    func networkSender(_ sender: NetworkSender, didReceiveKeyframeRequest sourceId: UInt8, layer: UInt8) {
+        for pipeline in pipelines where sourceId == NetworkSender.allSources || pipeline.sourceId == sourceId {
+            pipeline.requestKeyframe(layer: layer)
+        }
+    }
+
+    func networkSender(_ sender: NetworkSender, didReceiveReport report: ReceiverReport, from peer: ObjectIdentifier) {
+        pipelines.first { $0.sourceId == report.sourceId }?.handleReport(report, from: peer)
+    }
 }
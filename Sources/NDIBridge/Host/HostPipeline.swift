@@ -0,0 +1,385 @@
+//
+//  HostPipeline.swift
+//  NDI Bridge Mac
+//
+//  One bridged NDI source: capture → encoding → shared network sender
+//
+
+import Foundation
+import CoreVideo
+import QuartzCore
+import CAtomics
+
+/// Captured picture waiting in the capture → encode ring
+private final class CapturedFrame {
+    let pixelBuffer: CVPixelBuffer
+    let timestamp: UInt64
+    let captured: UInt64  // StageClock
+
+    init(pixelBuffer: CVPixelBuffer, timestamp: UInt64, captured: UInt64) {
+        self.pixelBuffer = pixelBuffer
+        self.timestamp = timestamp
+        self.captured = captured
+    }
+}
+
+/// Capture and encoding chain of a single NDI source.
+/// HostMode runs one pipeline per selected source; all of them share the process NDI
+/// runtime and one `NetworkSender`, and tag their packets with `sourceId` so Join can
+/// demultiplex the streams arriving on its single port.
+/// Captured pictures cross to a dedicated encode queue through a lock-free ring, so an
+/// encoder stall never delays `ndi_receiver_capture`: a full ring drops by policy instead.
+/// Simulcast: each `VideoRendition` encodes a scaled copy of the same captured picture
+/// as layer 1, 2... of this source, skipped while no Join subscribes to it
+final class HostPipeline: NDIReceiverDelegate, VideoEncoderDelegate {
+    let sourceId: UInt8
+    let source: NDISource
+
+    private let ndiReceiver: NDIReceiver
+    private let encoder = VideoEncoder()
+    private unowned let networkSender: NetworkSender  // Owned by HostMode, outlives its pipelines
+    private let encoderConfig: VideoEncoderConfig
+    private let passthrough: Bool
+    private let colorFormat: NDIColorFormat
+    private let audioEncoder: AudioEncoder?  // nil = PCM audio
+    private let renditions: [VideoRendition]
+    private let bitrateController: BitrateController?
+    private var isRunning = false
+
+    // Capture → encode handoff
+    private let captureRing: SPSCRing<CapturedFrame>
+    private let encodeQueue: DispatchQueue
+    private let framesQueued = DispatchSemaphore(value: 0)
+    private let encodeLoopDone = DispatchSemaphore(value: 0)
+    private let encodeLoopFlag: UnsafeMutablePointer<UInt64>  // Written by start/stop, polled by the encode queue
+
+    // Capture/submit times of frames inside the encoder, by timestamp (latency timing)
+    private var inFlightTiming: [UInt64: HostFrameTiming] = [:]
+    private let timingLock = NSLock()
+    private static let maxInFlightTiming = 64
+
+    // Statistics
+    private(set) var framesProcessed: UInt64 = 0
+    private let framesCaptured: MetricCounter
+    private let framesEncoded: MetricCounter
+    private let encodeErrors: MetricCounter
+    private let encodeLatencyMicros: MetricCounter
+    private let targetBitrate: MetricGauge
+
+    // Join keyframe requests: at most one forced IDR per interval and layer
+    private let keyframeRequestInterval: CFTimeInterval = 0.5
+    private var lastForcedKeyframe: [CFTimeInterval]
+
+    // NDI|HX passthrough: the encoder is bypassed while the source delivers compressed frames
+    // (written on the capture thread, read on the network queue by keyframe requests and reports)
+    private let forwardingFlag: UnsafeMutablePointer<UInt64>
+
+    private var encodeLoopRunning: Bool {
+        get { catomic_load_acquire(encodeLoopFlag) != 0 }
+        set { catomic_store_release(encodeLoopFlag, newValue ? 1 : 0) }
+    }
+
+    private var forwardingCompressed: Bool {
+        get { catomic_load_acquire(forwardingFlag) != 0 }
+        set { catomic_store_release(forwardingFlag, newValue ? 1 : 0) }
+    }
+
+    /// - Parameter receiver: an initialized receiver; the first pipeline reuses the one
+    ///   that ran discovery so its finder (and the source pointers) stay alive
+    init(sourceId: UInt8, source: NDISource, receiver: NDIReceiver, networkSender: NetworkSender,
+         encoderConfig: VideoEncoderConfig, passthrough: Bool, adaptiveBitrate: BitrateControllerConfig? = nil,
+         captureQueueDepth: Int = 4, captureDropPolicy: RingDropPolicy = .dropOldest, colorFormat: NDIColorFormat = .uyvy,
+         audioCodec: AudioCodec = .pcm, audioBitratePerChannel: Int = 64_000, renditions: [VideoRenditionConfig] = []) {
+        self.sourceId = sourceId
+        self.source = source
+        self.ndiReceiver = receiver
+        self.networkSender = networkSender
+        self.encoderConfig = encoderConfig
+        self.passthrough = passthrough
+        self.colorFormat = colorFormat
+        self.audioEncoder = audioCodec == .pcm ? nil : AudioEncoder(codec: audioCodec, bitratePerChannel: audioBitratePerChannel)
+        self.renditions = renditions.enumerated().map { VideoRendition(layer: UInt8($0.offset + 1), config: $0.element) }
+        self.lastForcedKeyframe = [CFTimeInterval](repeating: 0, count: renditions.count + 1)
+        self.bitrateController = adaptiveBitrate.map {
+            BitrateController(initialBitrate: encoderConfig.bitrate, config: $0)
+        }
+        self.captureRing = SPSCRing(capacity: captureQueueDepth, policy: captureDropPolicy)
+        self.encodeQueue = DispatchQueue(label: "com.ndibridge.encode.\(sourceId)", qos: .userInteractive)
+        self.encodeLoopFlag = .allocate(capacity: 1)
+        self.encodeLoopFlag.initialize(to: 0)
+        self.forwardingFlag = .allocate(capacity: 1)
+        self.forwardingFlag.initialize(to: 0)
+
+        let labels = ["source": String(sourceId), "name": source.name]
+        framesCaptured = metrics.counter("ndibridge_host_frames_captured_total", help: "Video frames captured from NDI", labels: labels,
+                                         rate: MetricRate(name: "ndibridge_host_capture_fps", help: "Capture frame rate since the previous scrape"))
+        framesEncoded = metrics.counter("ndibridge_host_frames_encoded_total", help: "Video frames out of the encoder (or forwarded in passthrough)", labels: labels,
+                                        rate: MetricRate(name: "ndibridge_host_encode_fps", help: "Encoded frame rate since the previous scrape"))
+        encodeErrors = metrics.counter("ndibridge_host_encode_errors_total", help: "Frames the encoder rejected", labels: labels)
+        encodeLatencyMicros = metrics.counter("ndibridge_host_encode_latency_microseconds_total",
+                                              help: "Sum of submit to output encoder latency; divide by frames_encoded_total", labels: labels)
+        targetBitrate = metrics.gauge("ndibridge_host_target_bitrate_bps", help: "Encoder target bitrate", labels: labels)
+
+        let ring = captureRing
+        metrics.register("ndibridge_host_capture_queue_depth", help: "Captured frames waiting for the encoder", kind: .gauge, labels: labels) { [weak ring] in
+            ring.map { Double($0.count) }
+        }
+        metrics.register("ndibridge_host_capture_dropped_total", help: "Captured frames dropped because the encoder fell behind", kind: .counter, labels: labels) { [weak ring] in
+            ring.map { Double($0.droppedCount) }
+        }
+    }
+
+    deinit {
+        stop()
+        encodeLoopFlag.deallocate()
+        forwardingFlag.deallocate()
+    }
+
+    /// Connect to the source and configure the encoder
+    func prepare() throws {
+        ndiReceiver.delegate = self
+        ndiReceiver.compressedPassthrough = passthrough
+        ndiReceiver.colorFormat = colorFormat
+        try ndiReceiver.connect(to: source)
+
+        encoder.delegate = self
+        do {
+            try encoder.configure(config: encoderConfig)
+        } catch {
+            logger.error("[\(source.name)] Encoder configuration failed: \(error.localizedDescription)", subsystem: .host)
+            throw HostModeError.encoderConfigFailed
+        }
+        networkSender.setPacingBitrate(bitrateController?.bitrate ?? encoderConfig.bitrate, sourceId: sourceId)
+        targetBitrate.set(Double(bitrateController?.bitrate ?? encoderConfig.bitrate))
+        logger.info("Source \(sourceId): \(source.name)", subsystem: .host)
+
+        for rendition in renditions {
+            rendition.encoder.delegate = self
+            do {
+                try rendition.prepare(primary: encoderConfig)
+            } catch {
+                logger.error("[\(source.name)] Rendition \(rendition.config) failed: \(error.localizedDescription)", subsystem: .host)
+                throw HostModeError.encoderConfigFailed
+            }
+            networkSender.setPacingBitrate(rendition.bitrate, sourceId: sourceId, layer: rendition.layer)
+            logger.info("Source \(sourceId) layer \(rendition.layer): \(rendition.config) @ \(rendition.bitrate / 1000) kbps", subsystem: .host)
+        }
+        if let controller = bitrateController {
+            logger.info("Adaptive bitrate: \(controller.config.minBitrate / 1_000_000)-\(controller.config.maxBitrate / 1_000_000) Mbps", subsystem: .host)
+        }
+    }
+
+    /// Start feeding captured frames to the encoder and the network
+    func startCapture() {
+        isRunning = true
+        startEncodeLoop()
+        ndiReceiver.startCapture()
+    }
+
+    func stop() {
+        let wasRunning = isRunning
+        isRunning = false
+
+        ndiReceiver.stop()
+        stopEncodeLoop()
+        if wasRunning {
+            // Frames still queued are stale by now: release them back to NDI
+            while captureRing.pop() != nil {}
+            if captureRing.droppedCount > 0 {
+                logger.warning("[\(source.name)] Encoder fell behind: \(captureRing.droppedCount) captured frames dropped (\(captureRing.policy.rawValue) first)", subsystem: .host)
+            }
+            encoder.flush()
+            renditions.forEach { $0.encoder.flush() }
+        }
+        encoder.invalidate()
+        renditions.forEach { $0.invalidate() }
+    }
+
+    /// Join lost a frame of this source (or just subscribed to `layer`): force an IDR
+    /// of that layer, rate-limited
+    func requestKeyframe(layer: UInt8 = NetworkSender.allLayers) {
+        let now = CACurrentMediaTime()
+        for index in lastForcedKeyframe.indices where layer == NetworkSender.allLayers || Int(layer) == index {
+            guard now - lastForcedKeyframe[index] >= keyframeRequestInterval else { continue }
+            lastForcedKeyframe[index] = now
+
+            guard index == 0 else {
+                renditions[index - 1].encoder.forceKeyframe()
+                continue
+            }
+
+            // The HX source's GOP is not ours to change: the receiver waits for its next IDR
+            guard !forwardingCompressed else {
+                logger.debug("[\(source.name)] Keyframe request ignored - passthrough follows the source GOP", subsystem: .host)
+                continue
+            }
+
+            logger.info("[\(source.name)] Receiver lost a frame - forcing keyframe", subsystem: .host)
+            encoder.forceKeyframe()
+        }
+    }
+
+    /// Join reception statistics for this source: let the controller retune the encoder
+    func handleReport(_ report: ReceiverReport, from peer: ObjectIdentifier) {
+        // An HX stream's rate belongs to the source
+        guard let controller = bitrateController, !forwardingCompressed else { return }
+        if let bitrate = controller.add(report, from: peer) {
+            encoder.setBitrate(bitrate)
+            networkSender.setPacingBitrate(bitrate, sourceId: sourceId)
+            targetBitrate.set(Double(bitrate))
+        }
+    }
+
+    // MARK: - Encode loop
+
+    /// Consumer side of the ring: encode queued frames as they arrive
+    private func startEncodeLoop() {
+        guard !encodeLoopRunning else { return }
+        encodeLoopRunning = true
+
+        encodeQueue.async { [weak self] in
+            guard let self = self else { return }
+            while self.encodeLoopRunning {
+                // Timeout only so a stop is noticed without a final signal
+                _ = self.framesQueued.wait(timeout: .now() + .milliseconds(100))
+                while let frame = self.captureRing.pop() {
+                    self.encode(frame)
+                }
+            }
+            self.encodeLoopDone.signal()
+        }
+    }
+
+    private func stopEncodeLoop() {
+        guard encodeLoopRunning else { return }
+        encodeLoopRunning = false
+        framesQueued.signal()
+        encodeLoopDone.wait()
+    }
+
+    private func encode(_ frame: CapturedFrame) {
+        timingLock.lock()
+        if inFlightTiming.count >= HostPipeline.maxInFlightTiming {
+            inFlightTiming.removeAll()  // Frames the encoder dropped never come back
+        }
+        inFlightTiming[frame.timestamp] = HostFrameTiming(
+            captured: frame.captured, encodeSubmitted: StageClock.now(), encoded: 0
+        )
+        timingLock.unlock()
+
+        Signposts.begin("Encode", timestamp: frame.timestamp, sourceId: sourceId)
+        do {
+            try encoder.encode(pixelBuffer: frame.pixelBuffer, timestamp: frame.timestamp)
+        } catch {
+            Signposts.abandon("Encode", timestamp: frame.timestamp, sourceId: sourceId)
+            encodeErrors.add()
+            logger.error("[\(source.name)] Encoding error: \(error.localizedDescription)", subsystem: .host)
+        }
+
+        // Renditions nobody watches cost nothing; a new subscriber gets a keyframe request
+        for rendition in renditions where networkSender.hasSubscribers(layer: rendition.layer) {
+            do {
+                try rendition.encode(frame.pixelBuffer, timestamp: frame.timestamp)
+            } catch {
+                encodeErrors.add()
+                logger.error("[\(source.name)] Rendition \(rendition.config) encoding error: \(error.localizedDescription)", subsystem: .host)
+            }
+        }
+    }
+
+    // MARK: - NDIReceiverDelegate
+
+    func ndiReceiver(_ receiver: NDIReceiver, didReceiveVideoFrame pixelBuffer: CVPixelBuffer, timestamp: UInt64, frameNumber: UInt64) {
+        framesProcessed = frameNumber
+        if forwardingCompressed {
+            forwardingCompressed = false
+            logger.info("[\(source.name)] Source switched to uncompressed video - encoding", subsystem: .host)
+        }
+
+        // Hand off to the encode queue; the capture thread goes straight back to NDI
+        framesCaptured.add()
+        let frame = CapturedFrame(pixelBuffer: pixelBuffer, timestamp: timestamp, captured: StageClock.now())
+        if !captureRing.push(frame) {
+            logger.debug("[\(source.name)] Capture ring full - frame dropped", subsystem: .host)
+        }
+        framesQueued.signal()
+    }
+
+    func ndiReceiver(_ receiver: NDIReceiver, didReceiveCompressedVideo frame: CompressedVideoFrame) {
+        framesProcessed += 1
+        framesCaptured.add()
+        framesEncoded.add()
+        if !forwardingCompressed {
+            forwardingCompressed = true
+            logger.info("[\(source.name)] Forwarding \(frame.codec.name) from NDI|HX source - encoder bypassed", subsystem: .host)
+        }
+
+        // The HX access unit is already Annex-B: send it as-is
+        let captured = StageClock.now()
+        networkSender.send(data: frame.data, isKeyframe: frame.isKeyframe, timestamp: frame.timestamp,
+                           codec: frame.codec, sourceId: sourceId,
+                           timing: HostFrameTiming(captured: captured, encodeSubmitted: captured, encoded: captured))
+    }
+
+    func ndiReceiver(_ receiver: NDIReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32) {
+        // Compressed when configured and the receiver can decode it, PCM otherwise
+        if let encoder = audioEncoder, networkSender.receiverSupports(encoder.codec.capability),
+           encoder.canEncode(sampleRate: sampleRate, channels: channels) {
+            if let packets = encoder.encode(planar: data, sampleRate: sampleRate, channels: channels) {
+                networkSender.sendAudio(data: packets, timestamp: timestamp, sampleRate: sampleRate, channels: channels,
+                                        codec: encoder.codec, sourceId: sourceId)
+            }
+            return
+        }
+        networkSender.sendAudio(data: data, timestamp: timestamp, sampleRate: sampleRate, channels: channels, sourceId: sourceId)
+    }
+
+    func ndiReceiver(_ receiver: NDIReceiver, didDisconnect error: Error?) {
+        if let error = error {
+            logger.error("[\(source.name)] NDI disconnected: \(error.localizedDescription)", subsystem: .host)
+        } else {
+            logger.warning("[\(source.name)] NDI source disconnected", subsystem: .host)
+        }
+
+        // Attempt reconnect
+        guard isRunning else { return }
+        logger.info("[\(source.name)] Attempting to reconnect...", subsystem: .host)
+        DispatchQueue.main.asyncAfter(deadline: .now() + 2.0) { [weak self] in
+            guard let self = self, self.isRunning else { return }
+            do {
+                try self.ndiReceiver.connect(to: self.source)
+                self.ndiReceiver.startCapture()
+            } catch {
+                logger.error("[\(self.source.name)] Reconnect failed: \(error.localizedDescription)", subsystem: .host)
+            }
+        }
+    }
+
+    // MARK: - VideoEncoderDelegate
+
+    func videoEncoder(_ encoder: VideoEncoder, didEncodeFrame frame: EncodedVideoFrame) {
+        if let rendition = renditions.first(where: { $0.encoder === encoder }) {
+            networkSender.send(frame: frame, sourceId: sourceId, layer: rendition.layer)
+            return
+        }
+
+        let encoded = StageClock.now()
+        Signposts.end("Encode", timestamp: frame.timestamp, sourceId: sourceId)
+        timingLock.lock()
+        var timing = inFlightTiming.removeValue(forKey: frame.timestamp)
+        timingLock.unlock()
+        timing?.encoded = encoded
+        framesEncoded.add()
+        if let submitted = timing?.encodeSubmitted, encoded > submitted {
+            encodeLatencyMicros.add(encoded - submitted)
+        }
+
+        // Send encoded data over network
+        networkSender.send(frame: frame, sourceId: sourceId, timing: timing)
+    }
+
+    func videoEncoder(_ encoder: VideoEncoder, didFailWithError error: Error) {
+        encodeErrors.add()
+        logger.error("[\(source.name)] Encoder error: \(error.localizedDescription)", subsystem: .host)
+    }
+}
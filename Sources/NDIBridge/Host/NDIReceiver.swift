@@ -29,9 +29,18 @@ struct NDISource {
     }
 }
 
+/// Compressed frame from an NDI|HX source, forwarded without decoding
+struct CompressedVideoFrame {
+    let data: Data          // Annex-B access unit, parameter sets prepended on keyframes
+    let codec: VideoCodec
+    let isKeyframe: Bool
+    let timestamp: UInt64   // NDI timecode, same clock as uncompressed frames
+}
+
 /// Callback for receiving video and audio frames
 protocol NDIReceiverDelegate: AnyObject {
     func ndiReceiver(_ receiver: NDIReceiver, didReceiveVideoFrame pixelBuffer: CVPixelBuffer, timestamp: UInt64, frameNumber: UInt64)
+    func ndiReceiver(_ receiver: NDIReceiver, didReceiveCompressedVideo frame: CompressedVideoFrame)
     func ndiReceiver(_ receiver: NDIReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32)
     func ndiReceiver(_ receiver: NDIReceiver, didDisconnect error: Error?)
 }
@@ -41,6 +50,10 @@ extension NDIReceiverDelegate {
     func ndiReceiver(_ receiver: NDIReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32) {
         // Default: ignore audio if not implemented
     }
+
+    func ndiReceiver(_ receiver: NDIReceiver, didReceiveCompressedVideo frame: CompressedVideoFrame) {
+        // Default: ignore compressed video if not implemented
+    }
 }
 
 /// Error types for NDI operations
@@ -66,10 +79,36 @@ enum NDIError: Error, LocalizedError {
     }
 }
 
+/// Uncompressed video format requested from the NDI SDK
+enum NDIColorFormat: String {
+    case bgra     // SDK converts its native YUV to BGRA, the encoder converts it back
+    case uyvy     // Native 4:2:2: half the bytes of BGRA, fed to the encoder as-is
+    case fastest  // Whatever the SDK delivers cheapest (UYVY, UYVA with alpha)
+
+    fileprivate var wrapperValue: NDIBridgeColorFormat {
+        switch self {
+        case .bgra: return NDIBRIDGE_COLOR_BGRA
+        case .uyvy: return NDIBRIDGE_COLOR_UYVY
+        case .fastest: return NDIBRIDGE_COLOR_FASTEST
+        }
+    }
+}
+
 /// Captures video frames from NDI sources
 final class NDIReceiver {
     weak var delegate: NDIReceiverDelegate?
 
+    /// Ask the SDK for NDI|HX frames as-is instead of decoded pixels (set before connect)
+    var compressedPassthrough = false
+
+    /// Pixel format of uncompressed frames (set before connect)
+    var colorFormat: NDIColorFormat = .uyvy
+
+    /// True when the linked NDI SDK can deliver compressed frames (Advanced SDK)
+    static var supportsCompressedReceive: Bool {
+        return ndi_supports_compressed_receive()
+    }
+
     private var finder: UnsafeMutableRawPointer?
     private var receiver: UnsafeMutableRawPointer?
     private var isRunning = false
@@ -87,6 +126,10 @@ final class NDIReceiver {
     private var lastFrameTime: CFTimeInterval = 0
     private var currentFPS: Double = 0
     private var audioFrameCount: UInt64 = 0
+    private var compressedFrameCount: UInt64 = 0
+    private var warnedExtraData = false  // Unusable HX parameter sets already reported
+    private var warnedPixelFormat = false
+    private var holdsRuntime = false
 
     init() {
         logger.info("NDIReceiver initializing...", subsystem: .ndi)
@@ -99,13 +142,16 @@ final class NDIReceiver {
     }
 
     /// Initialize NDI SDK - must be called before any other operations
+    /// The SDK itself is shared by every receiver of the process (see `NDIRuntime`)
     func initialize() throws {
+        guard !holdsRuntime else { return }
         logger.info("Initializing NDI SDK...", subsystem: .ndi)
 
-        guard ndi_initialize() else {
+        guard NDIRuntime.acquire() else {
             logger.error("NDI SDK initialization failed", subsystem: .ndi)
             throw NDIError.initializationFailed
         }
+        holdsRuntime = true
 
         // Allocate video frame structure
         videoFrame = ndi_video_frame_create()
@@ -171,7 +217,11 @@ final class NDIReceiver {
         logger.info("Connecting to NDI source: \(source.name)", subsystem: .ndi)
 
         // Create receiver
-        receiver = ndi_receiver_create()
+        if compressedPassthrough && !NDIReceiver.supportsCompressedReceive {
+            logger.warning("Compressed passthrough needs the NDI Advanced SDK - decoding instead", subsystem: .ndi)
+            compressedPassthrough = false
+        }
+        receiver = ndi_receiver_create_ex(colorFormat.wrapperValue, compressedPassthrough)
         guard receiver != nil else {
             logger.error("Failed to create NDI receiver", subsystem: .ndi)
             throw NDIError.receiverCreationFailed
@@ -235,11 +285,15 @@ final class NDIReceiver {
 
         while isRunning {
             // Capture frame with 100ms timeout - pass both video and audio frames
-            let result = ndi_receiver_capture(receiver, vFrame, aFrame, 100)
+            let result = Signposts.interval("NDI capture") {
+                ndi_receiver_capture(receiver, vFrame, aFrame, 100)
+            }
 
             switch result {
             case 1: // NDIlib_frame_type_video
-                processVideoFrame(vFrame)
+                Signposts.interval("Process frame", timestamp: UInt64(bitPattern: vFrame.pointee.timecode)) {
+                    processVideoFrame(vFrame)
+                }
 
             case 2: // NDIlib_frame_type_audio
                 processAudioFrame(aFrame)
@@ -269,11 +323,13 @@ final class NDIReceiver {
     }
 
     /// Context for CVPixelBuffer release callback
+    /// Holds its own copy of the frame descriptor: the capture loop reuses `videoFrame`
+    /// for the next capture while this picture may still be queued for encoding
     private class FrameReleaseContext {
         let receiver: UnsafeMutableRawPointer?
-        let frame: UnsafeMutablePointer<NDIBridgeVideoFrame>
-        
-        init(receiver: UnsafeMutableRawPointer?, frame: UnsafeMutablePointer<NDIBridgeVideoFrame>) {
+        var frame: NDIBridgeVideoFrame
+
+        init(receiver: UnsafeMutableRawPointer?, frame: NDIBridgeVideoFrame) {
             self.receiver = receiver
             self.frame = frame
         }
@@ -297,6 +353,26 @@ final class NDIReceiver {
 
         frameCount += 1
 
+        // NDI|HX source in passthrough mode: forward the elementary stream untouched
+        if compressedPassthrough {
+            var packet = NDIBridgeCompressedPacket()
+            if ndi_video_frame_get_compressed(frame, &packet) {
+                processCompressedPacket(packet, timecode: timecode)
+                ndi_receiver_free_video(receiver, frame)
+                return
+            }
+        }
+
+        // UYVY unless BGRA was requested; sources with alpha may still arrive as BGRA or UYVA
+        guard let pixelFormat = NDIReceiver.pixelFormat(forFourCC: videoFrame.FourCC) else {
+            if !warnedPixelFormat {
+                warnedPixelFormat = true
+                logger.warning("Unsupported NDI FourCC 0x\(String(videoFrame.FourCC, radix: 16)) - frames dropped", subsystem: .ndi)
+            }
+            ndi_receiver_free_video(receiver, frame)
+            return
+        }
+
         // Calculate FPS
         let now = CACurrentMediaTime()
         if lastFrameTime > 0 {
@@ -311,7 +387,7 @@ final class NDIReceiver {
         }
 
         // Create release context to free NDI frame when CVPixelBuffer is released
-        let releaseContext = FrameReleaseContext(receiver: receiver, frame: frame)
+        let releaseContext = FrameReleaseContext(receiver: receiver, frame: videoFrame)
         let contextPtr = Unmanaged.passRetained(releaseContext).toOpaque()
         
         // Release callback - called when CVPixelBuffer is deallocated
@@ -319,11 +395,11 @@ final class NDIReceiver {
             guard let refCon = releaseRefCon else { return }
             let context = Unmanaged<FrameReleaseContext>.fromOpaque(refCon).takeRetainedValue()
             // Now safe to free the NDI frame
-            ndi_receiver_free_video(context.receiver, context.frame)
+            withUnsafeMutablePointer(to: &context.frame) { ndi_receiver_free_video(context.receiver, $0) }
         }
 
         // Create CVPixelBuffer from NDI frame data
-        // NDI uses BGRA format by default (as configured in receiver_create)
+        // Wraps the SDK's buffer in place: UYVY goes to VideoToolbox without a BGRA round trip
         var pixelBuffer: CVPixelBuffer?
         let attributes: [String: Any] = [
             kCVPixelBufferCGImageCompatibilityKey as String: true,
@@ -335,7 +411,7 @@ final class NDIReceiver {
             kCFAllocatorDefault,
             Int(width),
             Int(height),
-            kCVPixelFormatType_32BGRA,
+            pixelFormat,
             data,
             Int(lineStride),
             releaseCallback,
@@ -356,6 +432,70 @@ final class NDIReceiver {
         delegate?.ndiReceiver(self, didReceiveVideoFrame: buffer, timestamp: UInt64(bitPattern: timecode), frameNumber: frameCount)
     }
 
+    /// Copy a compressed packet out of the NDI frame as one Annex-B access unit
+    private func processCompressedPacket(_ packet: NDIBridgeCompressedPacket, timecode: Int64) {
+        guard let payload = packet.p_data, packet.data_size > 0,
+              let codec = VideoCodec(rawValue: UInt8(truncatingIfNeeded: packet.codec)) else {
+            return
+        }
+
+        var accessUnit = Data(capacity: Int(packet.extra_data_size) + 16 + Int(packet.data_size))
+        // Parameter sets travel in extra data; prepend them so keyframes are self-contained
+        if packet.is_keyframe, let extra = packet.p_extra_data, packet.extra_data_size >= 4 {
+            appendParameterSets(UnsafeRawBufferPointer(start: extra, count: Int(packet.extra_data_size)),
+                                codec: codec, to: &accessUnit)
+        }
+        accessUnit.append(payload, count: Int(packet.data_size))
+
+        compressedFrameCount += 1
+        if compressedFrameCount == 1 {
+            logger.success("NDI|HX passthrough: receiving \(codec.name) stream", subsystem: .ndi)
+        }
+
+        delegate?.ndiReceiver(self, didReceiveCompressedVideo: CompressedVideoFrame(
+            data: accessUnit,
+            codec: codec,
+            isKeyframe: packet.is_keyframe,
+            timestamp: UInt64(bitPattern: timecode)
+        ))
+    }
+
+    /// HX extra data as Annex-B: copied as-is when already start-code prefixed, converted
+    /// from an avcC/hvcC record otherwise
+    private func appendParameterSets(_ extra: UnsafeRawBufferPointer, codec: VideoCodec, to accessUnit: inout Data) {
+        if extra[0] == 0, extra[1] == 0, extra[2] == 1 || (extra[2] == 0 && extra[3] == 1) {
+            accessUnit.append(contentsOf: extra)
+            return
+        }
+
+        guard let sets = AnnexB.parameterSets(fromConfigurationRecord: extra, codec: codec) else {
+            if !warnedExtraData {
+                warnedExtraData = true
+                logger.warning("NDI|HX \(codec.name) parameter sets in an unknown format - Joins need them in-band; run without --passthrough if they never decode", subsystem: .ndi)
+            }
+            return
+        }
+        let startCode: [UInt8] = [0, 0, 0, 1]
+        for set in sets {
+            accessUnit.append(contentsOf: startCode)
+            accessUnit.append(contentsOf: extra[set])
+        }
+    }
+
+    /// CoreVideo format for an uncompressed NDI FourCC
+    private static func pixelFormat(forFourCC fourCC: UInt32) -> OSType? {
+        switch fourCC {
+        case 0x4152_4742, 0x5852_4742: // 'BGRA', 'BGRX'
+            return kCVPixelFormatType_32BGRA
+        case 0x5956_5955: // 'UYVY'
+            return kCVPixelFormatType_422YpCbCr8
+        case 0x4156_5955: // 'UYVA': UYVY plane followed by an alpha plane, which the encoder ignores
+            return kCVPixelFormatType_422YpCbCr8
+        default:
+            return nil
+        }
+    }
+
     /// Process a captured audio frame
     private func processAudioFrame(_ frame: UnsafeMutablePointer<NDIBridgeAudioFrame>) {
         let audioData = frame.pointee
@@ -375,18 +515,14 @@ final class NDIReceiver {
 
         audioFrameCount += 1
 
-        // Calculate total data size
-        // For planar format: channels * samplesPerChannel * 4 (32-bit float)
-        let totalSize: Int
-        if channelStride > 0 {
-            totalSize = Int(channels) * Int(channelStride)
-        } else {
-            // Interleaved format
-            totalSize = Int(channels) * Int(samplesPerChannel) * 4
-        }
-
-        // Copy audio data before freeing NDI frame
-        let audioBuffer = Data(bytes: data, count: totalSize)
+        // Copy into a pooled block before freeing the NDI frame, dropping the row padding
+        // of `channelStride`: the wire always carries contiguous planar float
+        let audioBuffer = PCMConverter.packPlanar(
+            data,
+            channels: Int(channels),
+            samples: Int(samplesPerChannel),
+            channelStride: Int(channelStride)
+        )
 
         // Free the NDI audio frame
         ndi_receiver_free_audio(receiver, frame)
@@ -428,7 +564,10 @@ final class NDIReceiver {
             finder = nil
         }
 
-        ndi_destroy()
+        if holdsRuntime {
+            NDIRuntime.release()
+            holdsRuntime = false
+        }
         logger.debug("NDI resources cleaned up", subsystem: .ndi)
     }
 }
@@ -14,12 +14,22 @@ protocol NetworkSenderDelegate: AnyObject {
     func networkSender(_ sender: NetworkSender, didConnect endpoint: NWEndpoint)
     func networkSender(_ sender: NetworkSender, didDisconnect error: Error?)
     func networkSender(_ sender: NetworkSender, didUpdateStats bytesSent: UInt64, packetsent: UInt64)
+    func networkSender(_ sender: NetworkSender, didReceiveKeyframeRequest sourceId: UInt8, layer: UInt8)
+    /// `peer` tells the reports of several Joins apart
+    func networkSender(_ sender: NetworkSender, didReceiveReport report: ReceiverReport, from peer: ObjectIdentifier)
+}
+
+extension NetworkSenderDelegate {
+    func networkSender(_ sender: NetworkSender, didReceiveKeyframeRequest sourceId: UInt8, layer: UInt8) {}
+    func networkSender(_ sender: NetworkSender, didReceiveReport report: ReceiverReport, from peer: ObjectIdentifier) {}
 }
 
 /// Media types for packet header
 enum MediaType: UInt8 {
     case video = 0
     case audio = 1
+    case parameterSets = 2  // Out-of-band SPS/PPS preceding an AVCC keyframe
+    case timing = 3         // HostFrameTiming of the video frame with the same sequence number
 }
 
 /// Packet header for media data (video or audio)
@@ -27,8 +37,8 @@ struct MediaPacketHeader {
     var magic: UInt32 = 0x4E444942  // "NDIB"
     var version: UInt8 = 2          // Version 2 with audio support
     var mediaType: UInt8 = 0        // 0 = video, 1 = audio
-    var sourceId: UInt8 = 0         // Source ID (for future multi-source)
-    var flags: UInt8 = 0            // Flags: bit 0 = keyframe (video) or reserved (audio)
+    var sourceId: UInt8 = 0         // Source ID: one per bridged NDI source (multi-source Host)
+    var flags: UInt8 = 0            // Flags: bit 0 = keyframe (video), bit 1 = FEC parity packet, bit 2 = AVCC, bit 3 = retransmission
     var sequenceNumber: UInt32 = 0
     var timestamp: UInt64 = 0
     var totalSize: UInt32 = 0
@@ -39,26 +49,40 @@ struct MediaPacketHeader {
     // Audio-specific fields (only used when mediaType == 1)
     var sampleRate: UInt32 = 48000  // Audio sample rate
     var channels: UInt8 = 2         // Audio channels
-    var reserved: [UInt8] = [0, 0, 0]  // Padding for alignment
 
-    static let size = 38  // Total header size in bytes (verified from toData())
+    var fecGroupSize: UInt8 = 0     // Video FEC: data fragments per parity packet (0 = no FEC)
+    var codec: UInt8 = 0            // Video: VideoCodec (0 = H.264, 1 = HEVC); audio: AudioCodec (0 = PCM)
+    var layer: UInt8 = 0            // Video: simulcast rendition (0 = source resolution); was padding
+
+    static let size = 38  // Total header size in bytes
+
+    static let avccFlag: UInt8 = 0x04        // Video payload is length-prefixed NALs, parameter sets out-of-band
+    static let retransmitFlag: UInt8 = 0x08  // Packet re-sent in answer to a NACK
+    static let pcm16Flag: UInt8 = 0x10       // Audio payload is interleaved int16 instead of planar float
+
+    /// Serialize the header big-endian into `base`, which must have `size` writable bytes
+    func write(to base: UnsafeMutableRawPointer) {
+        base.storeBytes(of: magic.bigEndian, toByteOffset: 0, as: UInt32.self)
+        base.storeBytes(of: version, toByteOffset: 4, as: UInt8.self)
+        base.storeBytes(of: mediaType, toByteOffset: 5, as: UInt8.self)
+        base.storeBytes(of: sourceId, toByteOffset: 6, as: UInt8.self)
+        base.storeBytes(of: flags, toByteOffset: 7, as: UInt8.self)
+        base.storeBytes(of: sequenceNumber.bigEndian, toByteOffset: 8, as: UInt32.self)
+        base.storeBytes(of: timestamp.bigEndian, toByteOffset: 12, as: UInt64.self)
+        base.storeBytes(of: totalSize.bigEndian, toByteOffset: 20, as: UInt32.self)
+        base.storeBytes(of: fragmentIndex.bigEndian, toByteOffset: 24, as: UInt16.self)
+        base.storeBytes(of: fragmentCount.bigEndian, toByteOffset: 26, as: UInt16.self)
+        base.storeBytes(of: payloadSize.bigEndian, toByteOffset: 28, as: UInt16.self)
+        base.storeBytes(of: sampleRate.bigEndian, toByteOffset: 30, as: UInt32.self)
+        base.storeBytes(of: channels, toByteOffset: 34, as: UInt8.self)
+        base.storeBytes(of: fecGroupSize, toByteOffset: 35, as: UInt8.self)
+        base.storeBytes(of: codec, toByteOffset: 36, as: UInt8.self)
+        base.storeBytes(of: layer, toByteOffset: 37, as: UInt8.self)
+    }
 
     func toData() -> Data {
-        var data = Data(capacity: MediaPacketHeader.size)
-        withUnsafeBytes(of: magic.bigEndian) { data.append(contentsOf: $0) }
-        data.append(version)
-        data.append(mediaType)
-        data.append(sourceId)
-        data.append(flags)
-        withUnsafeBytes(of: sequenceNumber.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: timestamp.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: totalSize.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: fragmentIndex.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: fragmentCount.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: payloadSize.bigEndian) { data.append(contentsOf: $0) }
-        withUnsafeBytes(of: sampleRate.bigEndian) { data.append(contentsOf: $0) }
-        data.append(channels)
-        data.append(contentsOf: reserved)
+        var data = Data(count: MediaPacketHeader.size)
+        data.withUnsafeMutableBytes { write(to: $0.baseAddress!) }
         return data
     }
 }
@@ -66,30 +90,148 @@ struct MediaPacketHeader {
 /// Legacy alias for backward compatibility
 typealias VideoPacketHeader = MediaPacketHeader
 
+/// One destination of the stream: a Join, or a multicast group many Joins listen on
+struct NetworkTarget: CustomStringConvertible {
+    var host: String
+    var port: UInt16
+
+    /// IPv4 224.0.0.0/4 or IPv6 ff00::/8
+    var isMulticast: Bool {
+        let octets = host.split(separator: ".")
+        if octets.count == 4, let first = UInt8(octets[0]) {
+            return (224...239).contains(first)
+        }
+        return isIPv6 && host.lowercased().hasPrefix("ff")
+    }
+
+    /// IPv6 literal (names and IPv4 addresses have no colon once the port is split off)
+    var isIPv6: Bool { host.contains(":") }
+
+    var description: String { "\(host):\(port)" }
+
+    init(host: String, port: UInt16) {
+        self.host = host
+        self.port = port
+    }
+
+    /// "host[:port]" (IPv6 as "[address]:port"), port defaulting to `defaultPort`
+    init?(parsing string: String, defaultPort: UInt16) {
+        if string.hasPrefix("["), let close = string.firstIndex(of: "]") {
+            host = String(string[string.index(after: string.startIndex)..<close])
+            let rest = string[string.index(after: close)...]
+            port = rest.hasPrefix(":") ? UInt16(rest.dropFirst()) ?? defaultPort : defaultPort
+        } else {
+            let parts = string.split(separator: ":")
+            guard let first = parts.first, parts.count <= 2 else { return nil }
+            host = String(first)
+            port = parts.count > 1 ? UInt16(parts[1]) ?? defaultPort : defaultPort
+        }
+        guard !host.isEmpty else { return nil }
+    }
+}
+
 /// Network configuration
 struct NetworkSenderConfig {
     var host: String = "127.0.0.1"
     var port: UInt16 = 5990
     var mtu: Int = 1400  // Safe MTU for UDP (accounting for headers)
+    var batchTransmit: Bool = true  // Hand each frame's fragments to the stack in one batch
+    var fecGroupSize: Int = 0       // Video FEC: one XOR parity packet per N fragments (0 = off)
+    var retransmitWindowMs: Int = 200  // How long sent frames stay available to NACKs (0 = off)
+    var pacingFraction: Double = 0     // Spread each video frame over this fraction of the frame interval (0 = off)
+    var frameRate: Double = 60         // Pacer frame interval until a stream's own timestamps give it
+    var audioInt16: Bool = false       // Send audio as interleaved int16 to receivers advertising `.pcm16`
+    var extraTargets: [NetworkTarget] = []  // Fan-out: further destinations of the same packets
+    var multicastTTL: Int = 8          // Hop limit of multicast destinations
+    var controlPort: UInt16 = 5991     // Multicast: local port the Joins' control messages come back to
+    var layers: Int = 1                // Simulcast renditions per source, layer 0 included
+}
+
+/// A destination of the media packets, or a multicast Join known only from its control
+/// messages (answered in unicast: retransmissions, clock replies)
+private final class Peer {
+    let connection: NWConnection
+    let label: String
+    let receivesMedia: Bool
+    let isMulticast: Bool
+    var layer: UInt8 = 0  // Simulcast rendition the Join subscribed to
+    var isReady = false
+    var capabilities: ReceiverCapabilities = []
+    var lastHelloTime: CFTimeInterval = 0
+
+    init(connection: NWConnection, label: String, receivesMedia: Bool, isMulticast: Bool = false) {
+        self.connection = connection
+        self.label = label
+        self.receivesMedia = receivesMedia
+        self.isMulticast = isMulticast
+    }
 }
 
 /// Sends video packets over UDP
+/// Several Host pipelines may share one sender: every send takes the `sourceId` of its
+/// pipeline and the per-source stream state is kept under a lock.
+/// Fan-out: with several targets (unicast Joins and/or multicast groups) a frame is still
+/// fragmented once, and the same arena packets are handed to every connection
 final class NetworkSender {
     weak var delegate: NetworkSenderDelegate?
 
-    private var connection: NWConnection?
+    /// Keyframe request addressed to every source (e.g. after a capability change)
+    static let allSources: UInt8 = 0xFF
+    /// ...and to every simulcast rendition of them
+    static let allLayers: UInt8 = 0xFF
+    static let maxLayers = 4
+
     private let queue = DispatchQueue(label: "com.ndibridge.network.sender", qos: .userInteractive)
     private var config: NetworkSenderConfig
-    private var isConnected = false
+    private var controlListener: NWListener?  // Multicast: NACKs, hellos and reports of the Joins
+    private let arenaPool: PacketArenaPool
+    private let history: RetransmitHistory?
+    private let pacer: PacketPacer?
+
+    /// Sequence numbers are per source, rendition and media type so each Join reassembler
+    /// sees a dense sequence (a Join receives one rendition)
+    private struct StreamState {
+        var videoSequenceNumber: UInt32 = 0
+        var audioSequenceNumber: UInt32 = 0
+        var sendingAVCC = false  // Switched only on keyframes
+        var bitrate = 0          // Encoder target, feeds the pacer base rate
+        var lastVideoTimestamp: UInt64 = 0
+        var frameInterval: Double = 0  // Seconds between this stream's frames, pacer budget (0 = not known yet)
+    }
+    private var streams = [StreamState](repeating: StreamState(), count: (Int(UInt8.max) + 1) * NetworkSender.maxLayers)
+    private let streamLock = NSLock()
+    private static let maxFrameInterval = 0.5  // Longer timestamp gaps are pauses, not the frame rate
+
+    // Planar float → int16 stage of `audioInt16`; pipelines may send audio concurrently
+    private let audioConverter = PCMConverter()
+    private let audioConverterLock = NSLock()
 
     // Statistics
-    private var sequenceNumber: UInt32 = 0
-    private var totalBytesSent: UInt64 = 0
-    private var totalPacketsSent: UInt64 = 0
+    private let bytesSent = metrics.counter("ndibridge_host_bytes_sent_total", help: "UDP payload bytes sent to Join",
+                                            rate: MetricRate(name: "ndibridge_host_send_bitrate_bps", help: "Send bitrate since the previous scrape", scale: 8))
+    private let packetsSent = metrics.counter("ndibridge_host_packets_sent_total", help: "UDP packets sent to Join")
+    private let retransmitted = metrics.counter("ndibridge_host_retransmitted_packets_total", help: "Packets re-sent in answer to NACKs")
+    private let expiredNackCount = metrics.counter("ndibridge_host_expired_nacks_total", help: "NACKed frames already gone from the history")
+    private let keyframeRequests = metrics.counter("ndibridge_host_keyframe_requests_total", help: "Keyframe requests received from Join")
     private var lastStatsTime: CFTimeInterval = 0
+    private var totalBytesSent: UInt64 { bytesSent.value }
+    private var totalPacketsSent: UInt64 { packetsSent.value }
+
+    // Destinations and their capabilities, valid while their hellos keep arriving
+    private static let capabilitiesTimeout: CFTimeInterval = 3.0
+    private static let silentPeerTimeout: CFTimeInterval = 30.0  // Multicast Joins gone quiet are dropped
+    private let peerLock = NSLock()
+    private var peers: [Peer] = []
 
     init(config: NetworkSenderConfig = NetworkSenderConfig()) {
         self.config = config
+        self.arenaPool = PacketArenaPool(slotSize: config.mtu)
+        self.history = config.retransmitWindowMs > 0
+            ? RetransmitHistory(window: CFTimeInterval(config.retransmitWindowMs) / 1000)
+            : nil
+        self.pacer = config.pacingFraction > 0
+            ? PacketPacer(bitrate: 0, packetSize: config.mtu)
+            : nil
         logger.info("NetworkSender initializing...", subsystem: .network)
     }
 
@@ -98,53 +240,146 @@ final class NetworkSender {
         logger.info("NetworkSender deinitialized", subsystem: .network)
     }
 
-    /// Connect to the target endpoint
+    /// Connect to the target endpoint, plus `extraTargets` in fan-out
     func connect(host: String? = nil, port: UInt16? = nil) {
         if let h = host { config.host = h }
         if let p = port { config.port = p }
 
-        logger.info("Connecting to \(config.host):\(config.port)...", subsystem: .network)
+        let targets = [NetworkTarget(host: config.host, port: config.port)] + config.extraTargets
+        for target in targets {
+            guard let targetPort = NWEndpoint.Port(rawValue: target.port) else { continue }
+            logger.info("Connecting to \(target)\(target.isMulticast ? " (multicast)" : "")...", subsystem: .network)
 
-        let endpoint = NWEndpoint.hostPort(
-            host: NWEndpoint.Host(config.host),
-            port: NWEndpoint.Port(rawValue: config.port)!
-        )
+            let endpoint = NWEndpoint.hostPort(host: NWEndpoint.Host(target.host), port: targetPort)
 
-        // UDP connection with parameters
-        let parameters = NWParameters.udp
-        parameters.allowLocalEndpointReuse = true
-
-        // Enable expedited data if available
-        if let options = parameters.defaultProtocolStack.internetProtocol as? NWProtocolIP.Options {
-            options.disableFragmentation = false
-        }
+            // UDP connection with parameters
+            let parameters = NWParameters.udp
+            parameters.allowLocalEndpointReuse = true
 
-        connection = NWConnection(to: endpoint, using: parameters)
+            // Enable expedited data if available
+            if let options = parameters.defaultProtocolStack.internetProtocol as? NWProtocolIP.Options {
+                options.disableFragmentation = false
+                if target.isMulticast {
+                    options.hopLimit = UInt8(clamping: config.multicastTTL)
+                }
+            }
+            if target.isMulticast, let controlPort = NWEndpoint.Port(rawValue: config.controlPort) {
+                // Joins answer the source port of the group traffic: the control listener shares it
+                // Bound to the wildcard of the group's family, or an IPv6 group never connects
+                parameters.requiredLocalEndpoint = .hostPort(host: target.isIPv6 ? .ipv6(.any) : .ipv4(.any), port: controlPort)
+            }
 
-        connection?.stateUpdateHandler = { [weak self] state in
-            self?.handleStateChange(state)
+            addPeer(Peer(connection: NWConnection(to: endpoint, using: parameters), label: target.description,
+                         receivesMedia: true, isMulticast: target.isMulticast))
         }
 
-        connection?.start(queue: queue)
+        if targets.contains(where: { $0.isMulticast }) {
+            startControlListener()
+        }
     }
 
     /// Disconnect from the target
     func disconnect() {
-        guard let conn = connection else { return }
+        peerLock.lock()
+        let closing = peers
+        peers.removeAll()
+        peerLock.unlock()
+        guard !closing.isEmpty else { return }
 
         logger.info("Disconnecting...", subsystem: .network)
 
-        conn.cancel()
-        connection = nil
-        isConnected = false
+        pacer?.cancel()
+        controlListener?.cancel()
+        controlListener = nil
+        closing.forEach { $0.connection.cancel() }
 
         logger.success("Disconnected. Total sent: \(formatBytes(totalBytesSent))", subsystem: .network)
+        if retransmitted.value > 0 || expiredNackCount.value > 0 {
+            logger.info("Retransmitted \(retransmitted.value) packets, \(expiredNackCount.value) NACKed frames no longer in history", subsystem: .network)
+        }
+        if let pacer = pacer, pacer.pacedFrames > 0 {
+            logger.info("Paced \(pacer.pacedFrames) video frames, at most \(pacer.maxQueuedFrames) queued", subsystem: .network)
+        }
+    }
+
+    /// Encoder bitrate of a source; the pacer's base rate follows the sum over all sources
+    func setPacingBitrate(_ bitrate: Int, sourceId: UInt8 = 0, layer: UInt8 = 0) {
+        guard let pacer = pacer else { return }
+
+        streamLock.lock()
+        streams[NetworkSender.streamIndex(sourceId, layer)].bitrate = bitrate
+        let total = streams.reduce(0) { $0 + $1.bitrate }
+        streamLock.unlock()
+
+        pacer.setBitrate(total)
+    }
+
+    /// Send an encoded frame in the best format the receiver advertised:
+    /// AVCC straight from the encoder's block buffer when it can take it, Annex-B otherwise
+    /// (including legacy receivers that never send a hello). The format only changes on a
+    /// keyframe so the decoder never sees a GOP straddling both
+    func send(frame: EncodedVideoFrame, sourceId: UInt8 = 0, layer: UInt8 = 0, timing: HostFrameTiming? = nil) {
+        let stream = NetworkSender.streamIndex(sourceId, layer)
+        let avcc: Bool
+        if frame.isKeyframe {
+            let wanted = currentPeerCapabilities().contains(.avcc)
+            streamLock.lock()
+            let changed = wanted != streams[stream].sendingAVCC
+            streams[stream].sendingAVCC = wanted
+            streamLock.unlock()
+            if changed {
+                logger.info("Video format (source \(sourceId), layer \(layer)): \(wanted ? "AVCC" : "Annex-B")", subsystem: .network)
+            }
+            avcc = wanted
+        } else {
+            streamLock.lock()
+            avcc = streams[stream].sendingAVCC
+            streamLock.unlock()
+        }
+
+        guard avcc else {
+            send(data: frame.annexB(), isKeyframe: frame.isKeyframe, timestamp: frame.timestamp,
+                 codec: frame.codec, sourceId: sourceId, layer: layer, timing: timing)
+            return
+        }
+
+        send(data: frame.avcc, isKeyframe: frame.isKeyframe, timestamp: frame.timestamp,
+             codec: frame.codec, extraFlags: MediaPacketHeader.avccFlag, sourceId: sourceId, layer: layer,
+             parameterSets: frame.isKeyframe ? frame.parameterSets : [], timing: timing)
+    }
+
+    /// Frame interval of a stream from the delta between its timestamps (10 MHz), so a
+    /// 25 or 30 fps source is paced over its own slot rather than a 60 fps one.
+    /// Gaps (pause, source switch) keep the previous interval; `config.frameRate` covers
+    /// the first frame. Caller holds `streamLock`
+    private func updateFrameInterval(_ state: inout StreamState, timestamp: UInt64) -> Double {
+        if state.lastVideoTimestamp > 0, timestamp > state.lastVideoTimestamp {
+            let delta = Double(timestamp - state.lastVideoTimestamp) / 10_000_000
+            if delta <= NetworkSender.maxFrameInterval {
+                state.frameInterval = delta
+            }
+        }
+        state.lastVideoTimestamp = timestamp
+        return state.frameInterval > 0 ? state.frameInterval : 1 / max(config.frameRate, 1)
+    }
+
+    /// Whether some receiver currently takes `layer` - renditions nobody watches are not encoded
+    func hasSubscribers(layer: UInt8) -> Bool {
+        return !mediaConnections(layer: layer).isEmpty
     }
 
     /// Send encoded video data (will be fragmented if needed)
-    func send(data: Data, isKeyframe: Bool, timestamp: UInt64) {
-        guard isConnected, let conn = connection else {
-            logger.warning("Cannot send - not connected", subsystem: .network)
+    /// With `timing`, receivers that advertised `.timing` get a timing packet once the
+    /// frame's last packet has been handed to the stack.
+    /// `parameterSets` (AVCC keyframes) travel in the frame's first packet, so they are
+    /// paced with it and can never be overtaken by its slices
+    func send(data: Data, isKeyframe: Bool, timestamp: UInt64, codec: VideoCodec = .h264, extraFlags: UInt8 = 0,
+              sourceId: UInt8 = 0, layer: UInt8 = 0, parameterSets: [Data] = [], timing: HostFrameTiming? = nil) {
+        let conns = mediaConnections(layer: layer)
+        guard !conns.isEmpty else {
+            if layer == 0 {
+                logger.warning("Cannot send - not connected", subsystem: .network)
+            }
             return
         }
 
@@ -153,124 +388,562 @@ final class NetworkSender {
         // Calculate number of fragments needed
         let fragmentCount = (data.count + maxPayload - 1) / maxPayload
 
-        sequenceNumber += 1
-
-        for i in 0..<fragmentCount {
-            let start = i * maxPayload
-            let end = min(start + maxPayload, data.count)
-            let fragment = data.subdata(in: start..<end)
-
-            var header = MediaPacketHeader()
-            header.mediaType = MediaType.video.rawValue
-            header.flags = isKeyframe ? 1 : 0
-            header.sequenceNumber = sequenceNumber
-            header.timestamp = timestamp
-            header.totalSize = UInt32(data.count)
-            header.fragmentIndex = UInt16(i)
-            header.fragmentCount = UInt16(fragmentCount)
-            header.payloadSize = UInt16(fragment.count)
-
-            var packet = header.toData()
-            packet.append(fragment)
-            let packetToSend = packet  // Create immutable copy for closure
-
-            // Send packet
-            conn.send(content: packetToSend, completion: .contentProcessed { [weak self] error in
-                if let error = error {
-                    logger.error("Send error: \(error.localizedDescription)", subsystem: .network)
-                } else {
-                    self?.totalPacketsSent += 1
-                    self?.totalBytesSent += UInt64(packet.count)
+        let now = CACurrentMediaTime()
+        let stream = NetworkSender.streamIndex(sourceId, layer)
+        streamLock.lock()
+        streams[stream].videoSequenceNumber += 1
+        let sequenceNumber = streams[stream].videoSequenceNumber
+        let frameInterval = updateFrameInterval(&streams[stream], timestamp: timestamp)
+        let statsDue = now - lastStatsTime >= 1.0
+        if statsDue {
+            lastStatsTime = now
+        }
+        streamLock.unlock()
+        Signposts.begin("Send", timestamp: timestamp, sourceId: sourceId, layer: layer, sequence: sequenceNumber)
+
+        var header = MediaPacketHeader()
+        header.mediaType = MediaType.video.rawValue
+        header.sourceId = sourceId
+        header.flags = (isKeyframe ? 1 : 0) | extraFlags
+        header.codec = codec.rawValue
+        header.layer = layer
+        header.sequenceNumber = sequenceNumber
+        header.timestamp = timestamp
+        header.totalSize = UInt32(data.count)
+        header.fragmentCount = UInt16(fragmentCount)
+
+        let groupSize = min(config.fecGroupSize, Int(UInt8.max))
+        let parityCount = XORParity.groupCount(fragmentCount: fragmentCount, groupSize: groupSize)
+        header.fecGroupSize = UInt8(groupSize)
+
+        let parameterSetPacket = parameterSets.isEmpty ? nil : makeParameterSetPacket(parameterSets, of: header)
+        let leading = parameterSetPacket.map { $0.payload.count <= maxPayload ? 1 : 0 } ?? 0
+        if let packet = parameterSetPacket, leading == 0 {
+            // Too large for an arena slot: ahead of the frame, unpaced
+            var datagram = packet.header.toData()
+            datagram.append(packet.payload)
+            conns.forEach { $0.send(content: datagram, completion: .idempotent) }
+        }
+
+        let arena = arenaPool.acquire(packetCount: leading + fragmentCount + parityCount)
+        if let packet = parameterSetPacket, leading > 0 {
+            packet.payload.withUnsafeBytes { bytes in
+                arena.writePacket(0, header: packet.header, payload: bytes.baseAddress!, count: bytes.count)
+            }
+        }
+        fillArena(arena, header: header, payload: data, maxPayload: maxPayload, fragmentCount: fragmentCount, firstSlot: leading)
+        if parityCount > 0 {
+            fillParity(arena, header: header, fragmentCount: fragmentCount, groupSize: groupSize, firstSlot: leading)
+        }
+        var frameTiming = timing.flatMap { currentPeerCapabilities().contains(.timing) ? $0 : nil }
+        if let pacer = pacer {
+            // Keyframes would otherwise leave at line rate and overflow shallow switch buffers
+            let budget = config.pacingFraction * frameInterval
+            pacer.enqueue(arena, budget: budget) { [weak self] arena, range in
+                guard let self = self else { return }
+                let packetCount = arena.packetCount
+                if range.lowerBound == 0 {
+                    frameTiming?.firstSent = StageClock.now()
                 }
-            })
+                self.transmit(arena, packets: range, on: conns, errorLabel: "Send error")
+                guard range.upperBound == packetCount else { return }
+                Signposts.end("Send", timestamp: timestamp, sourceId: sourceId, layer: layer)
+                if var timing = frameTiming {
+                    timing.lastSent = StageClock.now()
+                    self.sendTiming(timing, of: header, on: conns)
+                }
+            }
+        } else {
+            frameTiming?.firstSent = StageClock.now()
+            transmit(arena, on: conns, errorLabel: "Send error")
+            Signposts.end("Send", timestamp: timestamp, sourceId: sourceId, layer: layer)
+            if var timing = frameTiming {
+                timing.lastSent = StageClock.now()
+                sendTiming(timing, of: header, on: conns)
+            }
+        }
+
+        history?.record(header: header, payload: data, maxPayload: maxPayload, now: now)
+        if let packet = parameterSetPacket {
+            history?.record(header: packet.header, payload: packet.payload, maxPayload: max(maxPayload, packet.payload.count), now: now)
         }
 
         // Update statistics periodically
-        let now = CACurrentMediaTime()
-        if now - lastStatsTime >= 1.0 {
+        if statsDue {
             delegate?.networkSender(self, didUpdateStats: totalBytesSent, packetsent: totalPacketsSent)
             logger.logNetwork(bytesSent: totalBytesSent, bytesReceived: 0, rtt: 0, subsystem: .network)
-            lastStatsTime = now
         }
     }
 
     /// Send audio data (will be fragmented if needed)
-    func sendAudio(data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32) {
-        guard isConnected, let conn = connection else {
+    /// PCM `data` is contiguous planar float; with `audioInt16` it goes out as interleaved
+    /// int16 (half the bytes) to receivers that advertised `.pcm16`. Compressed `data` is
+    /// an `AudioPacketGroup`, sent as-is with its codec in the header
+    func sendAudio(data planar: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32,
+                   codec: AudioCodec = .pcm, sourceId: UInt8 = 0) {
+        let conns = mediaConnections(layer: nil)
+        guard !conns.isEmpty else {
             logger.warning("Cannot send audio - not connected", subsystem: .network)
             return
         }
 
+        var data = planar
+        var flags: UInt8 = 0
+        if codec == .pcm, config.audioInt16, channels > 0, currentPeerCapabilities().contains(.pcm16) {
+            audioConverterLock.lock()
+            data = audioConverter.interleavedInt16(fromPlanar: planar, channels: Int(channels))
+            audioConverterLock.unlock()
+            flags = MediaPacketHeader.pcm16Flag
+        }
+        guard !data.isEmpty else { return }
+
         let maxPayload = config.mtu - MediaPacketHeader.size
 
         // Calculate number of fragments needed
         let fragmentCount = (data.count + maxPayload - 1) / maxPayload
 
-        sequenceNumber += 1
-
-        for i in 0..<fragmentCount {
-            let start = i * maxPayload
-            let end = min(start + maxPayload, data.count)
-            let fragment = data.subdata(in: start..<end)
-
-            var header = MediaPacketHeader()
-            header.mediaType = MediaType.audio.rawValue
-            header.flags = 0
-            header.sequenceNumber = sequenceNumber
-            header.timestamp = timestamp
-            header.totalSize = UInt32(data.count)
-            header.fragmentIndex = UInt16(i)
-            header.fragmentCount = UInt16(fragmentCount)
-            header.payloadSize = UInt16(fragment.count)
-            header.sampleRate = UInt32(sampleRate)
-            header.channels = UInt8(channels)
-
-            var packet = header.toData()
-            packet.append(fragment)
-            let packetToSend = packet
-
-            conn.send(content: packetToSend, completion: .contentProcessed { [weak self] error in
+        streamLock.lock()
+        streams[Int(sourceId)].audioSequenceNumber += 1
+        let sequenceNumber = streams[Int(sourceId)].audioSequenceNumber
+        streamLock.unlock()
+
+        var header = MediaPacketHeader()
+        header.mediaType = MediaType.audio.rawValue
+        header.sourceId = sourceId
+        header.flags = flags
+        header.sequenceNumber = sequenceNumber
+        header.timestamp = timestamp
+        header.totalSize = UInt32(data.count)
+        header.fragmentCount = UInt16(fragmentCount)
+        header.sampleRate = UInt32(sampleRate)
+        header.channels = UInt8(channels)
+        header.codec = codec.rawValue
+
+        let arena = arenaPool.acquire(packetCount: fragmentCount)
+        fillArena(arena, header: header, payload: data, maxPayload: maxPayload, fragmentCount: fragmentCount)
+        transmit(arena, on: conns, errorLabel: "Audio send error")
+
+        history?.record(header: header, payload: data, maxPayload: maxPayload, now: CACurrentMediaTime())
+    }
+
+    /// The parameter sets of keyframe `frameHeader` as a single packet tagged with the
+    /// keyframe's sequence number, which is also how Join NACKs them
+    private func makeParameterSetPacket(_ parameterSets: [Data], of frameHeader: MediaPacketHeader) -> (header: MediaPacketHeader, payload: Data) {
+        let payload = VideoParameterSets.serialize(parameterSets)
+
+        var header = MediaPacketHeader()
+        header.mediaType = MediaType.parameterSets.rawValue
+        header.sourceId = frameHeader.sourceId
+        header.codec = frameHeader.codec
+        header.layer = frameHeader.layer
+        header.sequenceNumber = frameHeader.sequenceNumber
+        header.timestamp = frameHeader.timestamp
+        header.totalSize = UInt32(payload.count)
+        header.fragmentCount = 1
+        header.payloadSize = UInt16(payload.count)
+        return (header, payload)
+    }
+
+    /// Stage timestamps of a frame whose packets are all out, in one packet
+    private func sendTiming(_ timing: HostFrameTiming, of frameHeader: MediaPacketHeader, on conns: [NWConnection]) {
+        var header = MediaPacketHeader()
+        header.mediaType = MediaType.timing.rawValue
+        header.sourceId = frameHeader.sourceId
+        header.layer = frameHeader.layer
+        header.sequenceNumber = frameHeader.sequenceNumber
+        header.timestamp = frameHeader.timestamp
+        header.totalSize = UInt32(HostFrameTiming.size)
+        header.fragmentCount = 1
+        header.payloadSize = UInt16(HostFrameTiming.size)
+
+        var packet = header.toData()
+        packet.append(timing.serialize())
+        conns.forEach { $0.send(content: packet, completion: .idempotent) }
+    }
+
+    /// Whether the receiver currently advertises `capability` (false once its hellos stop)
+    func receiverSupports(_ capability: ReceiverCapabilities) -> Bool {
+        return currentPeerCapabilities().contains(capability)
+    }
+
+    /// What every receiver can take - the packets are shared, so an optional format needs
+    /// all of them. A unicast Join without recent hellos counts as none; a multicast group
+    /// counts as the Joins currently reporting from it (none reporting: baseline only)
+    private func currentPeerCapabilities() -> ReceiverCapabilities {
+        let now = CACurrentMediaTime()
+        peerLock.lock()
+        defer { peerLock.unlock() }
+
+        func advertised(_ peer: Peer) -> ReceiverCapabilities {
+            return now - peer.lastHelloTime < NetworkSender.capabilitiesTimeout ? peer.capabilities : []
+        }
+
+        var common: ReceiverCapabilities?
+        for peer in peers where peer.receivesMedia && !peer.isMulticast {
+            common = (common ?? advertised(peer)).intersection(advertised(peer))
+        }
+        if peers.contains(where: { $0.isMulticast }) {
+            let reporting = peers.filter { !$0.receivesMedia && now - $0.lastHelloTime < NetworkSender.capabilitiesTimeout }
+            guard !reporting.isEmpty else { return [] }
+            for peer in reporting {
+                common = (common ?? peer.capabilities).intersection(peer.capabilities)
+            }
+        }
+        return common ?? []
+    }
+
+    /// Ready destinations of the media packets of `layer` (nil: audio, which every receiver gets)
+    private func mediaConnections(layer: UInt8?) -> [NWConnection] {
+        peerLock.lock()
+        defer { peerLock.unlock() }
+        return peers.compactMap { peer in
+            peer.receivesMedia && peer.isReady && (layer == nil || peer.layer == layer) ? peer.connection : nil
+        }
+    }
+
+    private static func streamIndex(_ sourceId: UInt8, _ layer: UInt8) -> Int {
+        return min(Int(layer), maxLayers - 1) << 8 | Int(sourceId)
+    }
+
+    /// Subscribed rendition of the peer behind `conn` (0 for unknown flows)
+    private func layer(of conn: NWConnection) -> UInt8 {
+        peerLock.lock()
+        defer { peerLock.unlock() }
+        return peers.first { $0.connection === conn }?.layer ?? 0
+    }
+
+    private func addPeer(_ peer: Peer) {
+        peerLock.lock()
+        peers.append(peer)
+        peerLock.unlock()
+
+        peer.connection.stateUpdateHandler = { [weak self, weak peer] state in
+            guard let self = self, let peer = peer else { return }
+            self.handleStateChange(state, of: peer)
+        }
+        peer.connection.start(queue: queue)
+    }
+
+    private func removePeer(_ peer: Peer) {
+        peerLock.lock()
+        peers.removeAll { $0 === peer }
+        peerLock.unlock()
+    }
+
+    /// Multicast Joins send their control messages to our source port, one flow each:
+    /// every flow becomes a control-only peer, answered in unicast
+    private func startControlListener() {
+        guard controlListener == nil, let port = NWEndpoint.Port(rawValue: config.controlPort) else { return }
+
+        let parameters = NWParameters.udp
+        parameters.allowLocalEndpointReuse = true
+        do {
+            let listener = try NWListener(using: parameters, on: port)
+            listener.newConnectionHandler = { [weak self] connection in
+                logger.info("Multicast receiver \(connection.endpoint) reporting", subsystem: .network)
+                self?.addPeer(Peer(connection: connection, label: "\(connection.endpoint)", receivesMedia: false))
+            }
+            listener.start(queue: queue)
+            controlListener = listener
+        } catch {
+            logger.warning("No control listener on port \(config.controlPort): \(error.localizedDescription) - multicast without NACKs or capabilities", subsystem: .network)
+        }
+    }
+
+    /// Send raw packet without fragmentation
+    func sendRaw(_ data: Data) {
+        for conn in mediaConnections(layer: nil) {
+            conn.send(content: data, completion: .contentProcessed { [weak self] error in
                 if let error = error {
-                    logger.error("Audio send error: \(error.localizedDescription)", subsystem: .network)
+                    logger.error("Raw send error: \(error.localizedDescription)", subsystem: .network)
                 } else {
-                    self?.totalPacketsSent += 1
-                    self?.totalBytesSent += UInt64(packet.count)
+                    self?.packetsSent.add()
+                    self?.bytesSent.add(UInt64(data.count))
                 }
             })
         }
     }
 
-    /// Send raw packet without fragmentation
-    func sendRaw(_ data: Data) {
-        guard isConnected, let conn = connection else { return }
+    /// Serialize every fragment of `payload` into the arena, one slot per packet
+    private func fillArena(_ arena: PacketArena, header: MediaPacketHeader, payload: Data, maxPayload: Int, fragmentCount: Int,
+                           firstSlot: Int = 0) {
+        var header = header
 
-        conn.send(content: data, completion: .contentProcessed { [weak self] error in
+        payload.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) in
+            guard let base = bytes.baseAddress else { return }
+
+            for i in 0..<fragmentCount {
+                let start = i * maxPayload
+                let length = min(maxPayload, bytes.count - start)
+
+                header.fragmentIndex = UInt16(i)
+                header.payloadSize = UInt16(length)
+                arena.writePacket(firstSlot + i, header: header, payload: base.advanced(by: start), count: length)
+            }
+        }
+    }
+
+    /// Append one XOR parity packet per group of `groupSize` data fragments.
+    /// The parity payload is as long as the group's first (longest) fragment and is
+    /// accumulated in place in the arena slots following the data packets (which start at `firstSlot`)
+    private func fillParity(_ arena: PacketArena, header: MediaPacketHeader, fragmentCount: Int, groupSize: Int, firstSlot: Int = 0) {
+        var header = header
+        header.flags |= XORParity.parityFlag
+
+        for group in 0..<(arena.packetCount - firstSlot - fragmentCount) {
+            let fragments = XORParity.members(ofGroup: group, fragmentCount: fragmentCount, groupSize: groupSize)
+            let members = (firstSlot + fragments.lowerBound)..<(firstSlot + fragments.upperBound)
+            let slotIndex = firstSlot + fragmentCount + group
+            let parityLength = arena.length(of: members.lowerBound) - MediaPacketHeader.size
+            let parity = arena.payload(slotIndex)
+
+            parity.initializeMemory(as: UInt8.self, repeating: 0, count: parityLength)
+            for member in members {
+                XORParity.accumulate(parity, arena.payload(member), count: arena.length(of: member) - MediaPacketHeader.size)
+            }
+
+            header.fragmentIndex = UInt16(group)
+            header.payloadSize = UInt16(parityLength)
+            arena.writeHeader(slotIndex, header: header, payloadCount: parityLength)
+        }
+    }
+
+    /// Hand the packets of one frame to the network stack - all of them, or the `packets`
+    /// chunk the pacer released
+    /// In batch mode the datagrams go out inside a single `NWConnection.batch` block with
+    /// one completion on the frame's last packet, so statistics are updated once per frame.
+    /// The arena goes back to the pool once that last packet has been processed on every
+    /// connection (completions all run on `queue`, which serializes the countdown)
+    private func transmit(_ arena: PacketArena, packets: Range<Int>? = nil, on conns: [NWConnection], errorLabel: String) {
+        let packetCount = arena.packetCount
+        guard packetCount > 0, !conns.isEmpty else {
+            arenaPool.recycle(arena)
+            return
+        }
+
+        let range = packets ?? 0..<packetCount
+        guard range.upperBound == packetCount else {
+            // Intermediate chunk: the completion stays with the frame's last packet
+            for conn in conns {
+                guard config.batchTransmit else {
+                    for i in range {
+                        conn.send(content: arena.packet(i), completion: .contentProcessed { error in
+                            if let error = error {
+                                logger.error("\(errorLabel): \(error.localizedDescription)", subsystem: .network)
+                            }
+                        })
+                    }
+                    continue
+                }
+
+                conn.batch {
+                    for i in range {
+                        conn.send(content: arena.packet(i), completion: .idempotent)
+                    }
+                }
+            }
+            return
+        }
+
+        let batchBytes = UInt64(arena.totalBytes)
+        let lastIndex = packetCount - 1
+        var pendingConnections = conns.count
+
+        let lastCompletion = NWConnection.SendCompletion.contentProcessed { [weak self] error in
             if let error = error {
-                logger.error("Raw send error: \(error.localizedDescription)", subsystem: .network)
+                logger.error("\(errorLabel): \(error.localizedDescription)", subsystem: .network)
             } else {
-                self?.totalPacketsSent += 1
-                self?.totalBytesSent += UInt64(data.count)
+                self?.packetsSent.add(UInt64(packetCount))
+                self?.bytesSent.add(batchBytes)
+            }
+            pendingConnections -= 1
+            if pendingConnections == 0 {
+                self?.arenaPool.recycle(arena)
             }
-        })
+        }
+
+        for conn in conns {
+            guard config.batchTransmit else {
+                for i in range.lowerBound..<lastIndex {
+                    conn.send(content: arena.packet(i), completion: .contentProcessed { error in
+                        if let error = error {
+                            logger.error("\(errorLabel): \(error.localizedDescription)", subsystem: .network)
+                        }
+                    })
+                }
+                conn.send(content: arena.packet(lastIndex), completion: lastCompletion)
+                continue
+            }
+
+            conn.batch {
+                // Intermediate datagrams carry no completion; the stack processes sends in order,
+                // so the last packet's completion covers the whole frame
+                for i in range.lowerBound..<lastIndex {
+                    conn.send(content: arena.packet(i), completion: .idempotent)
+                }
+                conn.send(content: arena.packet(lastIndex), completion: lastCompletion)
+            }
+        }
+    }
+
+    /// Listen for Join control messages (NACKs, keyframe requests) on the media flow
+    private func receiveControl(on conn: NWConnection) {
+        conn.receiveMessage { [weak self] content, _, _, error in
+            guard let self = self else { return }
+
+            if let data = content, let message = ControlMessage(data: data) {
+                self.handleControl(message, on: conn)
+            }
+
+            if error == nil && conn.state == .ready {
+                self.receiveControl(on: conn)
+            }
+        }
+    }
+
+    private func handleControl(_ message: ControlMessage, on conn: NWConnection) {
+        switch message {
+        case .nack(let mediaType, let sourceId, let ranges):
+            let nackLayer = mediaType == MediaType.audio.rawValue ? 0 : layer(of: conn)
+            retransmit(mediaType: mediaType, sourceId: sourceId, layer: nackLayer, ranges: ranges, on: conn)
+
+        case .keyframeRequest(let sourceId):
+            logger.debug("Keyframe requested by receiver", subsystem: .network)
+            keyframeRequests.add()
+            delegate?.networkSender(self, didReceiveKeyframeRequest: sourceId, layer: layer(of: conn))
+
+        case .subscribe(let layer):
+            subscribe(conn, to: layer)
+
+        case .capabilities(let capabilities):
+            let previous = currentPeerCapabilities()
+
+            let now = CACurrentMediaTime()
+            peerLock.lock()
+            if let peer = peers.first(where: { $0.connection === conn }) {
+                peer.capabilities = capabilities
+                peer.lastHelloTime = now
+            }
+            let silent = peers.filter { !$0.receivesMedia && now - $0.lastHelloTime > NetworkSender.silentPeerTimeout }
+            peerLock.unlock()
+            silent.forEach { $0.connection.cancel() }
+
+            let current = currentPeerCapabilities()
+            if current != previous {
+                logger.info("Receiver capabilities: \(current.contains(.avcc) ? "AVCC" : "Annex-B only")", subsystem: .network)
+                // Formats switch on keyframes - get one now rather than at the next GOP
+                delegate?.networkSender(self, didReceiveKeyframeRequest: NetworkSender.allSources, layer: NetworkSender.allLayers)
+            }
+
+        case .receiverReport(let report):
+            // The bitrate controller drives layer 0; renditions keep their configured rate
+            guard layer(of: conn) == 0 else { break }
+            delegate?.networkSender(self, didReceiveReport: report, from: ObjectIdentifier(conn))
+
+        case .clockProbe(let origin):
+            // Answer at once: Join takes the lowest-RTT exchange as its offset estimate
+            let received = StageClock.now()
+            let reply = ControlMessage.clockReply(origin: origin, received: received, transmitted: StageClock.now())
+            conn.send(content: reply.toData(), completion: .idempotent)
+
+        case .clockReply:
+            break  // Host → Join only
+        }
+    }
+
+    /// Move a unicast Join to another simulcast rendition; it gets a keyframe of it at once
+    private func subscribe(_ conn: NWConnection, to layer: UInt8) {
+        peerLock.lock()
+        let peer = peers.first { $0.connection === conn && $0.receivesMedia && !$0.isMulticast }
+        let previous = peer?.layer
+        if let peer = peer {
+            peer.layer = Int(layer) < config.layers ? layer : 0
+        }
+        let subscribed = peer?.layer
+        peerLock.unlock()
+
+        guard let current = subscribed else {
+            logger.debug("Rendition request from a multicast receiver ignored - the group carries layer 0", subsystem: .network)
+            return
+        }
+        guard current != previous else { return }
+        if current != layer {
+            logger.warning("Receiver asked for rendition \(layer), only \(config.layers) configured - sending layer 0", subsystem: .network)
+        }
+        logger.info("Receiver \(conn.endpoint) subscribed to rendition \(current)", subsystem: .network)
+        delegate?.networkSender(self, didReceiveKeyframeRequest: NetworkSender.allSources, layer: current)
     }
 
-    private func handleStateChange(_ state: NWConnection.State) {
+    /// Re-send NACKed fragments straight from the history; frames older than the
+    /// window are skipped since Join will already have given up on them
+    private func retransmit(mediaType: UInt8, sourceId: UInt8, layer: UInt8, ranges: [NackRange], on conn: NWConnection) {
+        guard let history = history else { return }
+        let now = CACurrentMediaTime()
+
+        conn.batch {
+            for range in ranges {
+                guard let entry = history.lookup(mediaType: mediaType, sourceId: sourceId, layer: layer,
+                                                 sequence: range.sequenceNumber, now: now) else {
+                    expiredNackCount.add()
+                    continue
+                }
+
+                var header = entry.header
+                header.flags |= MediaPacketHeader.retransmitFlag
+                let first = Int(range.firstFragment)
+                let end = min(first + Int(range.fragmentCount), Int(header.fragmentCount))
+                guard first < end else { continue }
+
+                for index in first..<end {
+                    let start = index * entry.maxPayload
+                    let length = min(entry.maxPayload, entry.payload.count - start)
+
+                    header.fragmentIndex = UInt16(index)
+                    header.payloadSize = UInt16(length)
+
+                    var packet = header.toData()
+                    packet.append(entry.payload[(entry.payload.startIndex + start)..<(entry.payload.startIndex + start + length)])
+                    conn.send(content: packet, completion: .idempotent)
+
+                    retransmitted.add()
+                    packetsSent.add()
+                    bytesSent.add(UInt64(packet.count))
+                }
+            }
+        }
+    }
+
+    private func handleStateChange(_ state: NWConnection.State, of peer: Peer) {
         switch state {
         case .ready:
-            isConnected = true
-            logger.success("Connected to \(config.host):\(config.port)", subsystem: .network)
-            if let endpoint = connection?.currentPath?.remoteEndpoint {
+            peerLock.lock()
+            peer.isReady = true
+            peerLock.unlock()
+            receiveControl(on: peer.connection)
+            guard peer.receivesMedia else { return }
+            logger.success("Connected to \(peer.label)", subsystem: .network)
+            if let endpoint = peer.connection.currentPath?.remoteEndpoint {
                 delegate?.networkSender(self, didConnect: endpoint)
             }
 
         case .failed(let error):
-            isConnected = false
-            logger.error("Connection failed: \(error.localizedDescription)", subsystem: .network)
+            peerLock.lock()
+            peer.isReady = false
+            peerLock.unlock()
+            guard peer.receivesMedia else {
+                removePeer(peer)
+                return
+            }
+            logger.error("Connection to \(peer.label) failed: \(error.localizedDescription)", subsystem: .network)
             delegate?.networkSender(self, didDisconnect: error)
 
         case .cancelled:
-            isConnected = false
-            logger.info("Connection cancelled", subsystem: .network)
+            removePeer(peer)
+            guard peer.receivesMedia else {
+                logger.debug("Multicast receiver \(peer.label) gone", subsystem: .network)
+                return
+            }
+            logger.info("Connection to \(peer.label) cancelled", subsystem: .network)
             delegate?.networkSender(self, didDisconnect: nil)
 
         case .waiting(let error):
@@ -0,0 +1,125 @@
+//
+//  PacketArena.swift
+//  NDI Bridge Mac
+//
+//  Reusable contiguous packet storage for the UDP send path
+//
+
+import Foundation
+
+/// One contiguous buffer holding every packet of a frame, `slotSize` bytes per packet.
+/// Headers are serialized in place and payloads are copied once, straight from the
+/// encoder output, so building a frame's packets performs no heap allocation once the
+/// arena is pooled. Sending still costs one small allocation per datagram: the `Data`
+/// view `packet(_:)` hands to `NWConnection.send`, whose Swift API takes `Data` only
+final class PacketArena {
+    let slotSize: Int
+    private(set) var slotCapacity: Int
+    private(set) var packetCount: Int = 0
+
+    private var storage: UnsafeMutableRawPointer
+    private var lengths: UnsafeMutablePointer<Int>
+
+    init(slotSize: Int, slotCapacity: Int) {
+        self.slotSize = slotSize
+        self.slotCapacity = max(1, slotCapacity)
+        self.storage = UnsafeMutableRawPointer.allocate(byteCount: slotSize * self.slotCapacity, alignment: 16)
+        self.lengths = UnsafeMutablePointer<Int>.allocate(capacity: self.slotCapacity)
+    }
+
+    deinit {
+        storage.deallocate()
+        lengths.deallocate()
+    }
+
+    /// Prepare the arena for a frame of `count` packets, growing only if needed
+    func reset(packetCount count: Int) {
+        if count > slotCapacity {
+            storage.deallocate()
+            lengths.deallocate()
+            slotCapacity = count
+            storage = UnsafeMutableRawPointer.allocate(byteCount: slotSize * slotCapacity, alignment: 16)
+            lengths = UnsafeMutablePointer<Int>.allocate(capacity: slotCapacity)
+        }
+        packetCount = count
+    }
+
+    /// Start of the slot for packet `index`
+    func slot(_ index: Int) -> UnsafeMutableRawPointer {
+        return storage.advanced(by: index * slotSize)
+    }
+
+    /// Serialize a header and its payload into slot `index`
+    func writePacket(_ index: Int, header: MediaPacketHeader, payload: UnsafeRawPointer, count: Int) {
+        let base = slot(index)
+        header.write(to: base)
+        base.advanced(by: MediaPacketHeader.size).copyMemory(from: payload, byteCount: count)
+        lengths[index] = MediaPacketHeader.size + count
+    }
+
+    /// Start of the payload area of slot `index`
+    func payload(_ index: Int) -> UnsafeMutableRawPointer {
+        return slot(index).advanced(by: MediaPacketHeader.size)
+    }
+
+    /// Serialize only the header of slot `index` whose payload was written in place
+    func writeHeader(_ index: Int, header: MediaPacketHeader, payloadCount: Int) {
+        header.write(to: slot(index))
+        lengths[index] = MediaPacketHeader.size + payloadCount
+    }
+
+    /// Length in bytes of packet `index`
+    func length(of index: Int) -> Int {
+        return lengths[index]
+    }
+
+    /// Total bytes of all packets currently in the arena
+    var totalBytes: Int {
+        var total = 0
+        for i in 0..<packetCount {
+            total += lengths[i]
+        }
+        return total
+    }
+
+    /// Packet `index` as a `Data` view over the arena - valid until the arena is recycled.
+    /// No bytes are copied, but each view allocates its own storage object
+    func packet(_ index: Int) -> Data {
+        return Data(bytesNoCopy: slot(index), count: lengths[index], deallocator: .none)
+    }
+}
+
+/// Free list of arenas: an arena is borrowed for one frame and handed back once
+/// the network stack has processed the frame's last packet
+final class PacketArenaPool {
+    private var free: [PacketArena] = []
+    private let lock = NSLock()
+    private let slotSize: Int
+    private let maxPooled: Int
+
+    init(slotSize: Int, maxPooled: Int = 8) {
+        self.slotSize = slotSize
+        self.maxPooled = maxPooled
+        free.reserveCapacity(maxPooled)
+    }
+
+    /// Borrow an arena sized for `packetCount` packets
+    func acquire(packetCount: Int) -> PacketArena {
+        lock.lock()
+        let arena = free.popLast()
+        lock.unlock()
+
+        let result = arena ?? PacketArena(slotSize: slotSize, slotCapacity: packetCount)
+        result.reset(packetCount: packetCount)
+        return result
+    }
+
+    /// Return an arena once all of its packets have been sent
+    func recycle(_ arena: PacketArena) {
+        lock.lock()
+        defer { lock.unlock() }
+        if free.count < maxPooled {
+            free.append(arena)
+        }
+    }
+}
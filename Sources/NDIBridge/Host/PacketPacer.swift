@@ -0,0 +1,159 @@
+//
+//  PacketPacer.swift
+//  NDI Bridge Mac
+//
+//  Token-bucket pacing of video packets between the encoder and the socket
+//
+
+import Foundation
+import QuartzCore
+
+/// Spreads each frame's packets over time instead of handing them to the stack
+/// back-to-back, so a keyframe no longer hits the first shallow switch or Wi-Fi buffer
+/// as a line-rate burst.
+///
+/// Tokens (bytes) refill at the pacing rate: the configured bitrate with headroom, raised
+/// for the frame at the head of the queue to whatever drains it within its budget
+/// (a fraction of the frame interval), so pacing never delays a frame past its slot.
+/// The bucket holds a few packets so small frames still leave in one short batch.
+/// Frames are paced in FIFO order on a dedicated queue and timer
+final class PacketPacer {
+    /// Emit packets `range` of `arena`; the pacer calls it from its own queue
+    typealias Emit = (PacketArena, Range<Int>) -> Void
+
+    private final class Job {
+        let arena: PacketArena
+        let rate: Double   // Bytes per second that drains this frame within its budget
+        let emit: Emit
+        var next = 0
+
+        init(arena: PacketArena, rate: Double, emit: @escaping Emit) {
+            self.arena = arena
+            self.rate = rate
+            self.emit = emit
+        }
+    }
+
+    static let headroom = 1.5          // Base rate over the encoder's average bitrate
+    static let burstPackets = 4        // Bucket depth in full packets
+    static let burstDuration = 0.0005  // ...or this much time at the current rate, if larger
+
+    private let queue = DispatchQueue(label: "com.ndibridge.network.pacer", qos: .userInteractive)
+    private let timer: DispatchSourceTimer
+    private let packetSize: Int
+    private var jobs = RingQueue<Job>(capacity: 8)
+    private var baseRate: Double       // Bytes per second
+    private var tokens: Double = 0
+    private var lastRefill: CFTimeInterval = 0
+    private var timerArmed = false
+
+    // Statistics
+    private(set) var pacedFrames: UInt64 = 0
+    private(set) var maxQueuedFrames = 0
+    private let queuedFrames = metrics.gauge("ndibridge_host_pacer_queued_frames", help: "Video frames waiting in the pacer")
+
+    /// - Parameters:
+    ///   - bitrate: encoder bitrate in bits per second the base rate follows
+    ///   - packetSize: largest datagram (MTU) for the bucket depth
+    init(bitrate: Int, packetSize: Int) {
+        self.baseRate = Double(bitrate) * PacketPacer.headroom / 8
+        self.packetSize = packetSize
+        self.tokens = Double(packetSize * PacketPacer.burstPackets)
+        self.timer = DispatchSource.makeTimerSource(flags: .strict, queue: queue)
+        timer.setEventHandler { [weak self] in
+            self?.timerArmed = false
+            self?.drain()
+        }
+        timer.schedule(deadline: .distantFuture, repeating: .never)
+        timer.resume()
+    }
+
+    deinit {
+        timer.cancel()
+    }
+
+    /// Follow the encoder's bitrate (adaptive control, several sources)
+    func setBitrate(_ bitrate: Int) {
+        queue.async { [weak self] in
+            self?.baseRate = Double(bitrate) * PacketPacer.headroom / 8
+        }
+    }
+
+    /// Queue a frame to leave within `budget` seconds of the frames before it
+    func enqueue(_ arena: PacketArena, budget: CFTimeInterval, emit: @escaping Emit) {
+        let rate = Double(arena.totalBytes) / max(budget, 0.001)
+        let job = Job(arena: arena, rate: rate, emit: emit)
+
+        queue.async { [weak self] in
+            guard let self = self else { return }
+            self.jobs.append(job)
+            self.maxQueuedFrames = max(self.maxQueuedFrames, self.jobs.count)
+            self.pacedFrames += 1
+            self.queuedFrames.set(Double(self.jobs.count))
+            if !self.timerArmed {
+                self.drain()
+            }
+        }
+    }
+
+    /// Drop frames not sent yet (disconnect)
+    func cancel() {
+        queue.sync {
+            jobs.removeAll()
+            timer.schedule(deadline: .distantFuture, repeating: .never)
+            timerArmed = false
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    /// Send what the bucket allows, then sleep until the next packet is affordable
+    private func drain() {
+        while let job = jobs.first {
+            let rate = max(baseRate, job.rate)
+            refill(rate: rate)
+
+            let count = job.arena.packetCount
+            var end = job.next
+            while end < count {
+                let length = Double(job.arena.length(of: end))
+                guard tokens >= length else { break }
+                tokens -= length
+                end += 1
+            }
+
+            if end > job.next {
+                job.emit(job.arena, job.next..<end)
+                job.next = end
+            }
+
+            if job.next == count {
+                _ = jobs.popFirst()
+                queuedFrames.set(Double(jobs.count))
+                continue
+            }
+
+            let missing = Double(job.arena.length(of: job.next)) - tokens
+            arm(after: missing / rate)
+            return
+        }
+    }
+
+    private func refill(rate: Double) {
+        let now = CACurrentMediaTime()
+        let capacity = max(Double(packetSize * PacketPacer.burstPackets), rate * PacketPacer.burstDuration)
+        if lastRefill > 0 {
+            tokens = min(capacity, tokens + (now - lastRefill) * rate)
+        }
+        lastRefill = now
+    }
+
+    private func arm(after delay: CFTimeInterval) {
+        timerArmed = true
+        timer.schedule(
+            deadline: .now() + .nanoseconds(Int(max(0, delay) * 1_000_000_000)),
+            repeating: .never,
+            leeway: .microseconds(50)
+        )
+    }
+}
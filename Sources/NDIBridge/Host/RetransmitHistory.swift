@@ -0,0 +1,68 @@
+//
+//  RetransmitHistory.swift
+//  NDI Bridge Mac
+//
+//  Short history of sent frames so Join NACKs can be answered
+//
+
+import Foundation
+import QuartzCore
+
+/// Keeps the last frames of each source, rendition and media type for `window` seconds.
+/// Entries hold a reference to the encoder's output `Data`, not a copy, and live in a
+/// fixed ring indexed by sequence number so recording a frame never allocates
+/// (a ring is created the first time a source sends that media type)
+final class RetransmitHistory {
+    struct Entry {
+        var header: MediaPacketHeader  // Header template (fragmentIndex/payloadSize filled per packet)
+        var payload: Data
+        var maxPayload: Int
+        var sentAt: CFTimeInterval
+    }
+
+    static let capacity = 64  // Frames per media type - well over 200 ms at 60 fps video / ~94 pps audio
+
+    let window: CFTimeInterval
+    private var rings: [Int: [Entry?]] = [:]  // Keyed by ringKey(sourceId:layer:mediaType:)
+    private let lock = NSLock()
+
+    init(window: CFTimeInterval) {
+        self.window = window
+    }
+
+    func record(header: MediaPacketHeader, payload: Data, maxPayload: Int, now: CFTimeInterval) {
+        let entry = Entry(header: header, payload: payload, maxPayload: maxPayload, sentAt: now)
+        let index = Int(header.sequenceNumber % UInt32(RetransmitHistory.capacity))
+
+        let key = RetransmitHistory.ringKey(sourceId: header.sourceId, layer: header.layer, mediaType: header.mediaType)
+
+        lock.lock()
+        defer { lock.unlock() }
+        if rings[key] == nil {
+            rings[key] = [Entry?](repeating: nil, count: RetransmitHistory.capacity)
+        }
+        rings[key]![index] = entry
+    }
+
+    /// The frame `sequence` of `mediaType` from `sourceId` if it was sent less than `window` ago
+    func lookup(mediaType: UInt8, sourceId: UInt8, layer: UInt8 = 0, sequence: UInt32, now: CFTimeInterval) -> Entry? {
+        let index = Int(sequence % UInt32(RetransmitHistory.capacity))
+        let key = RetransmitHistory.ringKey(sourceId: sourceId, layer: layer, mediaType: mediaType)
+
+        lock.lock()
+        let entry = rings[key]?[index]
+        lock.unlock()
+
+        guard let entry = entry,
+              entry.header.sequenceNumber == sequence,
+              now - entry.sentAt <= window else {
+            return nil
+        }
+        return entry
+    }
+
+    private static func ringKey(sourceId: UInt8, layer: UInt8, mediaType: UInt8) -> Int {
+        // Video, audio and parameter sets each get a ring: parameter sets share their keyframe's sequence number
+        return Int(layer) << 10 | Int(sourceId) << 2 | Int(mediaType & 0x03)
+    }
+}
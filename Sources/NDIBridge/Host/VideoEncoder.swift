@@ -2,7 +2,7 @@
 //  VideoEncoder.swift
 //  NDI Bridge Mac
 //
-//  Hardware H.264 encoding using VideoToolbox
+//  Hardware H.264/HEVC encoding using VideoToolbox
 //
 
 import Foundation
@@ -10,10 +10,46 @@ import VideoToolbox
 import CoreMedia
 import CoreVideo
 import QuartzCore
+import CAtomics
+
+/// One encoded access unit as produced by VideoToolbox
+struct EncodedVideoFrame {
+    let avcc: Data               // 4-byte length-prefixed NAL units, viewing the CMBlockBuffer bytes
+    let parameterSets: [Data]    // SPS/PPS (VPS/SPS/PPS for HEVC), keyframes only
+    let codec: VideoCodec
+    let isKeyframe: Bool
+    let timestamp: UInt64
+    let duration: UInt64
+
+    /// Annex-B form: start-code-prefixed parameter sets followed by the slices.
+    /// With 4-byte start codes the slices are the AVCC bytes with each length
+    /// prefix overwritten, so this is a single copy of the frame
+    func annexB() -> Data {
+        let startCode = UInt32(1).bigEndian
+        var result = Data(capacity: parameterSets.reduce(0) { $0 + 4 + $1.count } + avcc.count)
+
+        for set in parameterSets {
+            withUnsafeBytes(of: startCode) { result.append(contentsOf: $0) }
+            result.append(set)
+        }
+
+        let bodyStart = result.count
+        result.append(avcc)
+        result.withUnsafeMutableBytes { (bytes: UnsafeMutableRawBufferPointer) in
+            var offset = bodyStart
+            while offset + 4 <= bytes.count {
+                let nalLength = Int(UInt32(bigEndian: bytes.loadUnaligned(fromByteOffset: offset, as: UInt32.self)))
+                bytes.storeBytes(of: startCode, toByteOffset: offset, as: UInt32.self)
+                offset += 4 + nalLength
+            }
+        }
+        return result
+    }
+}
 
 /// Callback for receiving encoded data
 protocol VideoEncoderDelegate: AnyObject {
-    func videoEncoder(_ encoder: VideoEncoder, didEncodeData data: Data, isKeyframe: Bool, timestamp: UInt64, duration: UInt64)
+    func videoEncoder(_ encoder: VideoEncoder, didEncodeFrame frame: EncodedVideoFrame)
     func videoEncoder(_ encoder: VideoEncoder, didFailWithError error: Error)
 }
 
@@ -25,7 +61,10 @@ struct VideoEncoderConfig {
     var bitrate: Int = 8_000_000   // 8 Mbps default
     var keyframeInterval: Int = 60 // 1 keyframe per second at 60fps
     var enableLowLatency: Bool = true
-    var profile: CFString = kVTProfileLevel_H264_High_AutoLevel
+    var codec: VideoCodec = .h264
+    var profile: CFString? = nil   // nil = codec default (H.264 High / HEVC Main)
+    var lowLatencyRateControl: Bool = false  // VT low-latency mode: even frame sizes, no frame held back
+    var maxSliceBytes: Int = 0     // H.264: cap each slice NAL to this many bytes (0 = one slice per frame)
 
     static let auto = VideoEncoderConfig()  // Auto-detect everything
 
@@ -65,7 +104,7 @@ enum VideoEncoderError: Error, LocalizedError {
     }
 }
 
-/// Hardware H.264 encoder using VideoToolbox
+/// Hardware H.264/HEVC encoder using VideoToolbox
 final class VideoEncoder {
     weak var delegate: VideoEncoderDelegate?
 
@@ -75,6 +114,10 @@ final class VideoEncoder {
     private var frameNumber: UInt64 = 0
     private var needsAutoConfig = false  // Waiting for first frame to detect resolution
 
+    // Set from any thread by `forceKeyframe` / `setBitrate`, consumed by the next `encode`
+    private let keyframeRequested: UnsafeMutablePointer<UInt64>
+    private let pendingBitrate: UnsafeMutablePointer<UInt64>  // 0 = no change
+
     // Statistics
     private var totalBytesEncoded: UInt64 = 0
     private var lastStatsTime: CFTimeInterval = 0
@@ -82,11 +125,17 @@ final class VideoEncoder {
     private var bytesInInterval: Int = 0
 
     init() {
+        keyframeRequested = .allocate(capacity: 1)
+        keyframeRequested.initialize(to: 0)
+        pendingBitrate = .allocate(capacity: 1)
+        pendingBitrate.initialize(to: 0)
         logger.info("VideoEncoder initializing...", subsystem: .video)
     }
 
     deinit {
         invalidate()
+        keyframeRequested.deallocate()
+        pendingBitrate.deallocate()
         logger.info("VideoEncoder deinitialized", subsystem: .video)
     }
 
@@ -112,7 +161,7 @@ final class VideoEncoder {
     private func createCompressionSession(width: Int32, height: Int32) throws {
         guard var config = self.config else { return }
 
-        logger.info("Creating encoder: \(width)x\(height) @ \(config.bitrate / 1_000_000) Mbps", subsystem: .video)
+        logger.info("Creating \(config.codec.name) encoder: \(width)x\(height) @ \(config.bitrate / 1_000_000) Mbps", subsystem: .video)
 
         // Update config with actual dimensions
         config.width = width
@@ -120,24 +169,23 @@ final class VideoEncoder {
         self.config = config
 
         // Create compression session
-        let encoderSpec: [String: Any] = [
+        var encoderSpec: [String: Any] = [
             kVTVideoEncoderSpecification_EnableHardwareAcceleratedVideoEncoder as String: true,
             kVTVideoEncoderSpecification_RequireHardwareAcceleratedVideoEncoder as String: true
         ]
+        if config.lowLatencyRateControl {
+            encoderSpec[kVTVideoEncoderSpecification_EnableLowLatencyRateControl as String] = true
+        }
 
-        var session: VTCompressionSession?
-        let status = VTCompressionSessionCreate(
-            allocator: kCFAllocatorDefault,
-            width: width,
-            height: height,
-            codecType: kCMVideoCodecType_H264,
-            encoderSpecification: encoderSpec as CFDictionary,
-            imageBufferAttributes: nil,
-            compressedDataAllocator: nil,
-            outputCallback: compressionOutputCallback,
-            refcon: Unmanaged.passUnretained(self).toOpaque(),
-            compressionSessionOut: &session
-        )
+        var (status, session) = makeSession(width: width, height: height, codec: config.codec, specification: encoderSpec)
+        if status != noErr && config.lowLatencyRateControl {
+            // Not every encoder has the low-latency mode (HEVC before Apple Silicon, older GPUs)
+            logger.warning("\(config.codec.name) low-latency rate control unavailable (\(status)) - using the standard mode", subsystem: .video)
+            encoderSpec.removeValue(forKey: kVTVideoEncoderSpecification_EnableLowLatencyRateControl as String)
+            self.config?.lowLatencyRateControl = false
+            config.lowLatencyRateControl = false
+            (status, session) = makeSession(width: width, height: height, codec: config.codec, specification: encoderSpec)
+        }
 
         guard status == noErr, let compressionSession = session else {
             logger.error("Failed to create compression session: \(status)", subsystem: .video)
@@ -160,23 +208,39 @@ final class VideoEncoder {
         logger.success("Encoder configured successfully", subsystem: .video)
     }
 
+    private func makeSession(width: Int32, height: Int32, codec: VideoCodec,
+                             specification: [String: Any]) -> (OSStatus, VTCompressionSession?) {
+        var session: VTCompressionSession?
+        let status = VTCompressionSessionCreate(
+            allocator: kCFAllocatorDefault,
+            width: width,
+            height: height,
+            codecType: codec.codecType,
+            encoderSpecification: specification as CFDictionary,
+            imageBufferAttributes: nil,
+            compressedDataAllocator: nil,
+            outputCallback: compressionOutputCallback,
+            refcon: Unmanaged.passUnretained(self).toOpaque(),
+            compressionSessionOut: &session
+        )
+        return (status, session)
+    }
+
     private func configureSessionProperties(config: VideoEncoderConfig) throws {
         guard let session = compressionSession else { return }
 
         // Real-time encoding for low latency
         VTSessionSetProperty(session, key: kVTCompressionPropertyKey_RealTime, value: kCFBooleanTrue)
 
-        // Profile and level
-        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_ProfileLevel, value: config.profile)
-
-        // Bitrate (average)
-        let bitrateNum = config.bitrate as CFNumber
-        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_AverageBitRate, value: bitrateNum)
+        // Profile and level - the low-latency mode pairs with Constrained High (no B-frames anyway)
+        var profile = config.profile ?? config.codec.defaultProfile
+        if config.profile == nil && config.lowLatencyRateControl && config.codec == .h264 {
+            profile = kVTProfileLevel_H264_ConstrainedHigh_AutoLevel
+        }
+        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_ProfileLevel, value: profile)
 
-        // Data rate limits (peak bitrate = 1.5x average for bursts)
-        let peakBitrate = config.bitrate * 3 / 2
-        let limits: [Int] = [peakBitrate, 1]  // bytes per second, duration in seconds
-        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_DataRateLimits, value: limits as CFArray)
+        // Bitrate (average and peak)
+        applyBitrate(config.bitrate, to: session)
 
         // Frame rate
         let frameRateNum = config.frameRate as CFNumber
@@ -196,9 +260,54 @@ final class VideoEncoder {
             }
         }
 
+        // Low-latency rate control: each frame comes out before the next one goes in
+        if config.lowLatencyRateControl {
+            VTSessionSetProperty(session, key: kVTCompressionPropertyKey_MaxFrameDelayCount, value: 0 as CFNumber)
+        }
+
+        // Several slices per frame: smaller NAL units, decodable in parallel
+        if config.maxSliceBytes > 0 {
+            if config.codec == .h264 {
+                let status = VTSessionSetProperty(session, key: kVTCompressionPropertyKey_MaxH264SliceBytes,
+                                                  value: config.maxSliceBytes as CFNumber)
+                if status != noErr {
+                    logger.warning("Encoder rejected \(config.maxSliceBytes)-byte slices (\(status))", subsystem: .video)
+                }
+            } else {
+                logger.warning("Slice size limit is H.264 only - ignored for \(config.codec.name)", subsystem: .video)
+            }
+        }
+
         logger.debug("Encoder properties configured", subsystem: .video)
     }
 
+    /// Average bitrate plus data rate limits (peak = 1.5x average for bursts)
+    private func applyBitrate(_ bitrate: Int, to session: VTCompressionSession) {
+        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_AverageBitRate, value: bitrate as CFNumber)
+
+        let peakBytesPerSecond = bitrate * 3 / 2 / 8
+        let limits: [Int] = [peakBytesPerSecond, 1]  // bytes per second, duration in seconds
+        VTSessionSetProperty(session, key: kVTCompressionPropertyKey_DataRateLimits, value: limits as CFArray)
+    }
+
+    /// Retarget the running session, e.g. from the adaptive bitrate controller.
+    /// Safe from any thread: the next `encode` applies it, so the session and `config`
+    /// are only touched on the encode path. No new session or keyframe needed
+    func setBitrate(_ bitrate: Int) {
+        guard bitrate > 0 else { return }
+        catomic_store_release(pendingBitrate, UInt64(bitrate))
+    }
+
+    /// Apply the latest `setBitrate` value, if any
+    private func applyPendingBitrate(to session: VTCompressionSession) {
+        let pending = catomic_load_acquire(pendingBitrate)
+        guard pending != 0, catomic_compare_exchange(pendingBitrate, pending, 0) else { return }
+        let bitrate = Int(pending)
+        config?.bitrate = bitrate  // Kept for a session recreated later
+        applyBitrate(bitrate, to: session)
+        logger.debug("Encoder bitrate set to \(bitrate / 1000) kbps", subsystem: .video)
+    }
+
     /// Encode a video frame
     func encode(pixelBuffer: CVPixelBuffer, timestamp: UInt64, duration: UInt64 = 0) throws {
         guard isConfigured else {
@@ -218,6 +327,12 @@ final class VideoEncoder {
             throw VideoEncoderError.notConfigured
         }
 
+        applyPendingBitrate(to: session)
+
+        // A forced IDR restarts the GOP cadence
+        if catomic_compare_exchange(keyframeRequested, 1, 0) {
+            frameNumber = 0
+        }
         frameNumber += 1
 
         // Create presentation timestamp
@@ -250,10 +365,10 @@ final class VideoEncoder {
         }
     }
 
-    /// Force a keyframe on the next frame
+    /// Force a keyframe on the next frame. Safe from any thread (Join requests arrive on
+    /// the network queue while the encode queue runs `encode`)
     func forceKeyframe() {
-        // Next frame will be encoded as keyframe
-        frameNumber = 0
+        catomic_store_release(keyframeRequested, 1)
         logger.debug("Keyframe forced", subsystem: .video)
     }
 
@@ -298,15 +413,23 @@ final class VideoEncoder {
         // Get timing info
         let pts = CMSampleBufferGetPresentationTimeStamp(buffer)
         let duration = CMSampleBufferGetDuration(buffer)
-        let timestamp = UInt64(CMTimeGetSeconds(pts) * 10_000_000)
+        // Exact when VT kept our 100ns timescale: the Host matches frames by timestamp
+        let timestamp = pts.timescale == 10_000_000
+            ? UInt64(bitPattern: pts.value)
+            : UInt64(CMTimeGetSeconds(pts) * 10_000_000)
         let durationValue = UInt64(CMTimeGetSeconds(duration) * 10_000_000)
 
-        // Extract NAL units
-        guard let data = extractNALUnits(from: buffer) else {
+        // Encoded bytes, still length-prefixed as VideoToolbox produced them
+        guard let data = sampleData(from: buffer) else {
             logger.warning("Failed to extract NAL units", subsystem: .video)
             return
         }
 
+        var parameterSets: [Data] = []
+        if isKeyframe, let formatDescription = CMSampleBufferGetFormatDescription(buffer) {
+            parameterSets = extractParameterSets(from: formatDescription, codec: config?.codec ?? .h264)
+        }
+
         // Update statistics
         totalBytesEncoded += UInt64(data.count)
         bytesInInterval += data.count
@@ -322,133 +445,98 @@ final class VideoEncoder {
         }
 
         // Notify delegate
-        delegate?.videoEncoder(self, didEncodeData: data, isKeyframe: isKeyframe, timestamp: timestamp, duration: durationValue)
+        let frame = EncodedVideoFrame(
+            avcc: data,
+            parameterSets: parameterSets,
+            codec: config?.codec ?? .h264,
+            isKeyframe: isKeyframe,
+            timestamp: timestamp,
+            duration: durationValue
+        )
+        delegate?.videoEncoder(self, didEncodeFrame: frame)
     }
 
-    /// Extract NAL units from CMSampleBuffer with Annex-B start codes
-    private func extractNALUnits(from sampleBuffer: CMSampleBuffer) -> Data? {
-        // Get format description for SPS/PPS on keyframes
-        guard let formatDescription = CMSampleBufferGetFormatDescription(sampleBuffer) else {
-            return nil
-        }
-
-        var result = Data()
-
-        // For keyframes, prepend SPS and PPS
-        if let attachments = CMSampleBufferGetSampleAttachmentsArray(sampleBuffer, createIfNecessary: false) as? [[CFString: Any]],
-           let first = attachments.first,
-           first[kCMSampleAttachmentKey_NotSync] as? Bool != true {
-            // This is a keyframe - add SPS and PPS
-            if let parameterSets = extractParameterSets(from: formatDescription) {
-                result.append(parameterSets)
-            }
-        }
-
-        // Get data buffer
+    /// The sample's AVCC bytes. A contiguous block buffer (the usual case) is viewed
+    /// without copying, the Data keeping the block buffer alive
+    private func sampleData(from sampleBuffer: CMSampleBuffer) -> Data? {
         guard let dataBuffer = CMSampleBufferGetDataBuffer(sampleBuffer) else {
             return nil
         }
 
+        var lengthAtOffset = 0
         var totalLength = 0
         var dataPointer: UnsafeMutablePointer<Int8>?
 
         let status = CMBlockBufferGetDataPointer(
             dataBuffer,
             atOffset: 0,
-            lengthAtOffsetOut: nil,
+            lengthAtOffsetOut: &lengthAtOffset,
             totalLengthOut: &totalLength,
             dataPointerOut: &dataPointer
         )
 
-        guard status == kCMBlockBufferNoErr, let ptr = dataPointer else {
+        guard status == kCMBlockBufferNoErr, let ptr = dataPointer, totalLength > 0 else {
             return nil
         }
 
-        // Convert AVCC to Annex-B format
-        let data = Data(bytes: ptr, count: totalLength)
-        var offset = 0
-
-        while offset < totalLength {
-            // Read NAL unit length (4 bytes, big-endian)
-            guard offset + 4 <= totalLength else { break }
-
-            var nalLength: UInt32 = 0
-            _ = withUnsafeMutableBytes(of: &nalLength) { dest in
-                data.copyBytes(to: dest, from: offset..<(offset + 4))
-            }
-            nalLength = nalLength.bigEndian
-            offset += 4
-
-            guard offset + Int(nalLength) <= totalLength else { break }
-
-            // Add Annex-B start code
-            let startCode: [UInt8] = [0x00, 0x00, 0x00, 0x01]
-            result.append(contentsOf: startCode)
-
-            // Add NAL unit data
-            result.append(data.subdata(in: offset..<(offset + Int(nalLength))))
-            offset += Int(nalLength)
+        if lengthAtOffset == totalLength {
+            return Data(bytesNoCopy: ptr, count: totalLength, deallocator: .custom { _, _ in
+                withExtendedLifetime(dataBuffer) {}
+            })
         }
 
-        return result
+        // Non-contiguous block buffer: gather it once
+        var data = Data(count: totalLength)
+        let copyStatus = data.withUnsafeMutableBytes { (bytes: UnsafeMutableRawBufferPointer) in
+            CMBlockBufferCopyDataBytes(dataBuffer, atOffset: 0, dataLength: totalLength, destination: bytes.baseAddress!)
+        }
+        return copyStatus == kCMBlockBufferNoErr ? data : nil
     }
 
-    /// Extract SPS and PPS from format description
-    private func extractParameterSets(from formatDescription: CMFormatDescription) -> Data? {
-        var result = Data()
-        let startCode: [UInt8] = [0x00, 0x00, 0x00, 0x01]
-
-        // Get SPS count and data
-        var spsCount = 0
-        var status = CMVideoFormatDescriptionGetH264ParameterSetAtIndex(
-            formatDescription,
-            parameterSetIndex: 0,
-            parameterSetPointerOut: nil,
-            parameterSetSizeOut: nil,
-            parameterSetCountOut: &spsCount,
-            nalUnitHeaderLengthOut: nil
-        )
-
-        if status == noErr {
-            for i in 0..<spsCount {
-                var spsPtr: UnsafePointer<UInt8>?
-                var spsSize = 0
-
-                status = CMVideoFormatDescriptionGetH264ParameterSetAtIndex(
+    /// Extract the parameter sets, in order, from the format description
+    /// (SPS then PPS for H.264, VPS/SPS/PPS for HEVC)
+    private func extractParameterSets(from formatDescription: CMFormatDescription, codec: VideoCodec) -> [Data] {
+        func parameterSet(at index: Int, pointer: UnsafeMutablePointer<UnsafePointer<UInt8>?>?,
+                          size: UnsafeMutablePointer<Int>?, count: UnsafeMutablePointer<Int>?) -> OSStatus {
+            switch codec {
+            case .h264:
+                return CMVideoFormatDescriptionGetH264ParameterSetAtIndex(
                     formatDescription,
-                    parameterSetIndex: i,
-                    parameterSetPointerOut: &spsPtr,
-                    parameterSetSizeOut: &spsSize,
-                    parameterSetCountOut: nil,
+                    parameterSetIndex: index,
+                    parameterSetPointerOut: pointer,
+                    parameterSetSizeOut: size,
+                    parameterSetCountOut: count,
+                    nalUnitHeaderLengthOut: nil
+                )
+            case .hevc:
+                return CMVideoFormatDescriptionGetHEVCParameterSetAtIndex(
+                    formatDescription,
+                    parameterSetIndex: index,
+                    parameterSetPointerOut: pointer,
+                    parameterSetSizeOut: size,
+                    parameterSetCountOut: count,
                     nalUnitHeaderLengthOut: nil
                 )
-
-                if status == noErr, let ptr = spsPtr {
-                    result.append(contentsOf: startCode)
-                    result.append(ptr, count: spsSize)
-                }
             }
         }
 
-        // Get PPS (index starts after SPS)
-        var ppsPtr: UnsafePointer<UInt8>?
-        var ppsSize = 0
+        var parameterSets: [Data] = []
 
-        status = CMVideoFormatDescriptionGetH264ParameterSetAtIndex(
-            formatDescription,
-            parameterSetIndex: spsCount,
-            parameterSetPointerOut: &ppsPtr,
-            parameterSetSizeOut: &ppsSize,
-            parameterSetCountOut: nil,
-            nalUnitHeaderLengthOut: nil
-        )
+        var count = 0
+        guard parameterSet(at: 0, pointer: nil, size: nil, count: &count) == noErr else {
+            return parameterSets
+        }
 
-        if status == noErr, let ptr = ppsPtr {
-            result.append(contentsOf: startCode)
-            result.append(ptr, count: ppsSize)
+        for i in 0..<count {
+            var setPointer: UnsafePointer<UInt8>?
+            var setSize = 0
+
+            if parameterSet(at: i, pointer: &setPointer, size: &setSize, count: nil) == noErr, let ptr = setPointer {
+                parameterSets.append(Data(bytes: ptr, count: setSize))
+            }
         }
 
-        return result.isEmpty ? nil : result
+        return parameterSets
     }
 }
 
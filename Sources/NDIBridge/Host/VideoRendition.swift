@@ -0,0 +1,142 @@
+//
+//  VideoRendition.swift
+//  NDI Bridge Mac
+//
+//  Simulcast: an extra, hardware-scaled resolution of one Host source
+//
+
+import Foundation
+import VideoToolbox
+import CoreVideo
+
+/// Size and rate of one simulcast rendition, parsed from "WxH[@mbps]"
+struct VideoRenditionConfig: CustomStringConvertible {
+    var width: Int32
+    var height: Int32
+    var bitrate: Int = 0  // 0 = primary bitrate scaled by pixel count against 1080p
+
+    init(width: Int32, height: Int32, bitrate: Int = 0) {
+        self.width = width
+        self.height = height
+        self.bitrate = bitrate
+    }
+
+    init?(parsing string: String) {
+        let parts = string.split(separator: "@")
+        guard let sizePart = parts.first, parts.count <= 2 else { return nil }
+        let size = sizePart.lowercased().split(separator: "x")
+        guard size.count == 2, let w = Int32(size[0]), let h = Int32(size[1]), w >= 16, h >= 16 else { return nil }
+        // Even dimensions for the chroma-subsampled capture formats
+        width = w & ~1
+        height = h & ~1
+        if parts.count == 2 {
+            guard let mbps = Double(parts[1]), mbps > 0 else { return nil }
+            bitrate = Int(mbps * 1_000_000)
+        }
+    }
+
+    var description: String { "\(width)x\(height)" }
+
+    /// Encoder target for this rendition given the primary one
+    func bitrate(primary: Int) -> Int {
+        guard bitrate == 0 else { return bitrate }
+        let ratio = Double(width) * Double(height) / (1920 * 1080)
+        return min(primary, max(500_000, Int(Double(primary) * ratio)))
+    }
+}
+
+/// One extra resolution of a source. Each captured picture is scaled by a
+/// `VTPixelTransferSession` (GPU) into a pooled IOSurface buffer and compressed by this
+/// rendition's own session, so the Host encodes once per resolution, not per Join.
+/// Packets carry `layer` in the NDIB header; only Joins subscribed to it receive them.
+/// Runs on the pipeline's encode queue; not thread-safe
+final class VideoRendition {
+    let layer: UInt8
+    let config: VideoRenditionConfig
+    let encoder = VideoEncoder()
+    private(set) var bitrate = 0
+
+    private var transferSession: VTPixelTransferSession?
+    private var pool: CVPixelBufferPool?
+    private var poolFormat: OSType = 0
+
+    init(layer: UInt8, config: VideoRenditionConfig) {
+        self.layer = layer
+        self.config = config
+    }
+
+    deinit {
+        invalidate()
+    }
+
+    /// Same encoder settings as the primary, at this rendition's size and rate
+    func prepare(primary: VideoEncoderConfig) throws {
+        var encoderConfig = primary
+        encoderConfig.width = config.width
+        encoderConfig.height = config.height
+        encoderConfig.bitrate = config.bitrate(primary: primary.bitrate)
+        bitrate = encoderConfig.bitrate
+        try encoder.configure(config: encoderConfig)
+
+        var session: VTPixelTransferSession?
+        let status = VTPixelTransferSessionCreate(allocator: kCFAllocatorDefault, pixelTransferSessionOut: &session)
+        guard status == noErr, let created = session else {
+            throw VideoEncoderError.sessionCreationFailed(status)
+        }
+        VTSessionSetProperty(created, key: kVTPixelTransferPropertyKey_ScalingMode, value: kVTScalingMode_Normal)
+        transferSession = created
+    }
+
+    /// Scale and encode one captured picture
+    func encode(_ source: CVPixelBuffer, timestamp: UInt64) throws {
+        guard let session = transferSession else {
+            throw VideoEncoderError.notConfigured
+        }
+
+        // Scaled buffers keep the capture format (UYVY or BGRA), which the encoder takes as-is
+        let format = CVPixelBufferGetPixelFormatType(source)
+        if pool == nil || format != poolFormat {
+            pool = makePool(format: format)
+            poolFormat = format
+        }
+
+        var scaled: CVPixelBuffer?
+        guard let pool = pool,
+              CVPixelBufferPoolCreatePixelBuffer(kCFAllocatorDefault, pool, &scaled) == kCVReturnSuccess,
+              let target = scaled else {
+            throw VideoEncoderError.invalidPixelBuffer
+        }
+
+        let status = VTPixelTransferSessionTransferImage(session, from: source, to: target)
+        guard status == noErr else {
+            throw VideoEncoderError.encodingFailed(status)
+        }
+        try encoder.encode(pixelBuffer: target, timestamp: timestamp)
+    }
+
+    func invalidate() {
+        encoder.invalidate()
+        if let session = transferSession {
+            VTPixelTransferSessionInvalidate(session)
+            transferSession = nil
+        }
+        pool = nil
+    }
+
+    // MARK: - Private Helpers
+
+    private func makePool(format: OSType) -> CVPixelBufferPool? {
+        let attributes: [String: Any] = [
+            kCVPixelBufferPixelFormatTypeKey as String: format,
+            kCVPixelBufferWidthKey as String: Int(config.width),
+            kCVPixelBufferHeightKey as String: Int(config.height),
+            kCVPixelBufferIOSurfacePropertiesKey as String: [String: Any]()
+        ]
+        var created: CVPixelBufferPool?
+        let status = CVPixelBufferPoolCreate(kCFAllocatorDefault, nil, attributes as CFDictionary, &created)
+        if status != kCVReturnSuccess {
+            logger.error("Rendition \(layer) (\(config)): pixel buffer pool failed (\(status))", subsystem: .video)
+        }
+        return created
+    }
+}
@@ -0,0 +1,176 @@
+//
+//  AudioDecoder.swift
+//  NDI Bridge Mac
+//
+//  AAC-ELD audio decoding using AudioToolbox
+//
+
+import Foundation
+import AudioToolbox
+import Accelerate
+
+/// Turns the `AudioPacketGroup` payloads of one received source back into contiguous
+/// planar float for NDI. The converter needs the encoder's magic cookie: frames are
+/// dropped until one carrying it arrives, and a new cookie or format rebuilds it.
+/// Runs on the network receive queue; not thread-safe
+final class AudioDecoder {
+    private var converter: AudioConverterRef?
+    private var codec: AudioCodec = .pcm
+    private var sampleRate: Int32 = 0
+    private var channels: Int32 = 0
+    private var cookie = Data()
+
+    // Packets of the current call, handed whole to the converter's input proc
+    private var parsed: [AudioStreamPacketDescription] = []
+    private var descriptions: UnsafeMutablePointer<AudioStreamPacketDescription>?
+    private var descriptionCapacity = 0
+    private var packets: UnsafeRawPointer?
+    private var packetCount = 0
+    private var packetBytes = 0
+
+    // Interleaved decoder output
+    private var output: UnsafeMutablePointer<Float>?
+    private var outputCapacity = 0
+
+    private static let inputExhausted: OSStatus = 0x6E6F6D6F  // 'nomo'
+
+    deinit {
+        if let converter = converter {
+            AudioConverterDispose(converter)
+        }
+        descriptions?.deallocate()
+        output?.deallocate()
+    }
+
+    /// Decode one frame. Returns the planar samples and their count per channel, or nil
+    /// while waiting for a cookie or when the payload is malformed
+    func decode(_ payload: Data, codec: AudioCodec, sampleRate: Int32, channels: Int32) -> (data: Data, samplesPerChannel: Int32)? {
+        guard channels > 0, sampleRate > 0 else { return nil }
+
+        return payload.withUnsafeBytes { (raw: UnsafeRawBufferPointer) -> (data: Data, samplesPerChannel: Int32)? in
+            guard let group = AudioPacketGroup.parse(raw, descriptions: &parsed), let base = raw.baseAddress else {
+                logger.debug("Malformed \(codec.name) audio frame (\(raw.count) bytes)", subsystem: .join)
+                return nil
+            }
+
+            let sameFormat = codec == self.codec && sampleRate == self.sampleRate && channels == self.channels
+            if !group.cookie.isEmpty && (converter == nil || !sameFormat || !group.cookie.elementsEqual(cookie)) {
+                configure(codec: codec, sampleRate: sampleRate, channels: channels, cookie: Data(group.cookie))
+            }
+            guard let converter = converter, !parsed.isEmpty,
+                  codec == self.codec, sampleRate == self.sampleRate, channels == self.channels else {
+                return nil
+            }
+
+            // Stable copy of the descriptions for the input proc
+            if parsed.count > descriptionCapacity {
+                descriptions?.deallocate()
+                descriptions = .allocate(capacity: parsed.count)
+                descriptionCapacity = parsed.count
+            }
+            guard let descriptions = descriptions else { return nil }
+            descriptions.update(from: parsed, count: parsed.count)
+            packets = UnsafeRawPointer(base.advanced(by: group.packetsOffset))
+            packetCount = parsed.count
+            packetBytes = parsed.reduce(0) { $0 + Int($1.mDataByteSize) }
+
+            let channelCount = Int(channels)
+            let maxFrames = parsed.count * codec.framesPerPacket
+            if maxFrames * channelCount > outputCapacity {
+                output?.deallocate()
+                output = .allocate(capacity: maxFrames * channelCount)
+                outputCapacity = maxFrames * channelCount
+            }
+            guard let output = output else { return nil }
+
+            var frames = UInt32(maxFrames)
+            var buffers = AudioBufferList(
+                mNumberBuffers: 1,
+                mBuffers: AudioBuffer(mNumberChannels: UInt32(channels), mDataByteSize: UInt32(maxFrames * channelCount * 4),
+                                      mData: UnsafeMutableRawPointer(output))
+            )
+            let status = AudioConverterFillComplexBuffer(converter, AudioDecoder.inputProc,
+                                                         Unmanaged.passUnretained(self).toOpaque(),
+                                                         &frames, &buffers, nil)
+            packets = nil
+            if status != noErr && status != AudioDecoder.inputExhausted {
+                logger.warning("\(codec.name) decode error: \(status)", subsystem: .join)
+            }
+            guard frames > 0 else { return nil }
+
+            // Interleaved (frames × channels) → planar (channels × frames)
+            let decoded = Int(frames)
+            let planar = AudioBlockPool.shared.data(count: decoded * channelCount * 4) { block in
+                vDSP_mtrans(output, 1, block.assumingMemoryBound(to: Float.self), 1,
+                            vDSP_Length(channelCount), vDSP_Length(decoded))
+            }
+            return (planar, Int32(decoded))
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    private static let inputProc: AudioConverterComplexInputDataProc = { _, ioPacketCount, ioData, outDescriptions, userData in
+        guard let userData = userData else { return AudioDecoder.inputExhausted }
+        let decoder = Unmanaged<AudioDecoder>.fromOpaque(userData).takeUnretainedValue()
+        guard decoder.packetCount > 0, let packets = decoder.packets else {
+            ioPacketCount.pointee = 0
+            return AudioDecoder.inputExhausted
+        }
+
+        ioPacketCount.pointee = UInt32(decoder.packetCount)
+        let buffers = UnsafeMutableAudioBufferListPointer(ioData)
+        buffers[0].mData = UnsafeMutableRawPointer(mutating: packets)
+        buffers[0].mDataByteSize = UInt32(decoder.packetBytes)
+        buffers[0].mNumberChannels = UInt32(decoder.channels)
+        outDescriptions?.pointee = decoder.descriptions
+        decoder.packetCount = 0
+        return noErr
+    }
+
+    private func configure(codec: AudioCodec, sampleRate: Int32, channels: Int32, cookie: Data) {
+        if let converter = converter {
+            AudioConverterDispose(converter)
+            self.converter = nil
+        }
+        self.codec = codec
+        self.sampleRate = sampleRate
+        self.channels = channels
+        self.cookie = cookie
+
+        var inputFormat = AudioStreamBasicDescription()
+        inputFormat.mSampleRate = Float64(sampleRate)
+        inputFormat.mFormatID = codec.formatID
+        inputFormat.mFramesPerPacket = UInt32(codec.framesPerPacket)
+        inputFormat.mChannelsPerFrame = UInt32(channels)
+        var outputFormat = AudioStreamBasicDescription(
+            mSampleRate: Float64(sampleRate),
+            mFormatID: kAudioFormatLinearPCM,
+            mFormatFlags: kAudioFormatFlagIsFloat | kAudioFormatFlagIsPacked,
+            mBytesPerPacket: UInt32(4 * channels),
+            mFramesPerPacket: 1,
+            mBytesPerFrame: UInt32(4 * channels),
+            mChannelsPerFrame: UInt32(channels),
+            mBitsPerChannel: 32,
+            mReserved: 0
+        )
+
+        var newConverter: AudioConverterRef?
+        let status = AudioConverterNew(&inputFormat, &outputFormat, &newConverter)
+        guard status == noErr, let created = newConverter else {
+            logger.error("\(codec.name) decoder unavailable for \(sampleRate)Hz \(channels)ch (status \(status))", subsystem: .join)
+            return
+        }
+
+        var bytes = [UInt8](cookie)
+        let cookieStatus = AudioConverterSetProperty(created, kAudioConverterDecompressionMagicCookie, UInt32(bytes.count), &bytes)
+        guard cookieStatus == noErr else {
+            logger.error("\(codec.name) decoder rejected the stream cookie (status \(cookieStatus))", subsystem: .join)
+            AudioConverterDispose(created)
+            return
+        }
+
+        converter = created
+        logger.info("\(codec.name) decoder: \(sampleRate)Hz \(channels)ch", subsystem: .join)
+    }
+}
@@ -2,19 +2,34 @@
 //  JoinMode.swift
 //  NDI Bridge Mac
 //
-//  Orchestrates network reception → H.264 decoding → NDI output
+//  Orchestrates network reception → H.264 decoding → NDI output, one output per Host source
 //
 
 import Foundation
-import CoreVideo
 
 /// Join mode configuration
 struct JoinModeConfig {
     var listenPort: UInt16 = 5990
+    var multicastGroup: String? = nil  // Groupe multicast à rejoindre (Host en --target <groupe>), nil = unicast
+    var layer: UInt8 = 0  // Rendition simulcast demandée au Host (0 = résolution de la source)
     var ndiOutputName: String = "NDI Bridge Output"
     var outputWidth: Int32 = 1920
     var outputHeight: Int32 = 1080
-    var bufferMs: Int = 0  // 0 = temps réel, >0 = délai en ms
+    var bufferMs: Int = 0  // 0 = temps réel, >0 = profondeur du buffer de gigue en ms (minimale si bufferMaxMs)
+    var bufferMaxMs: Int = 0  // >bufferMs = profondeur adaptative entre bufferMs et bufferMaxMs, 0 = fixe
+    var nackHoldMs: Int = 0  // 0 = pas de retransmission, >0 = attente max des fragments perdus
+    var maxSources: Int = 16  // Nombre max de sorties NDI (une par source du Host)
+    var reportIntervalMs: Int = 500  // Rapports perte/jitter vers le Host (débit adaptatif), 0 = désactivé
+    var measureLatency: Bool = false  // Histogrammes de latence par étape (horodatages du Host + sondes d'horloge)
+    var metricsPort: UInt16 = 0  // Port HTTP des métriques Prometheus/JSON, 0 = désactivé
+    var outputFormat: NDIOutputFormat = .uyvy  // Format envoyé au SDK NDI (uyvy = NV12 décodeur converti par Metal)
+    var scaleOutput: Bool = false  // Redimensionne à outputWidth x outputHeight (sortie UYVY)
+    var asyncSend: Bool = true  // Envoi NDI asynchrone : la frame N part pendant que N+1 est préparée
+
+    /// Nom de la sortie NDI d'une source : la source 0 garde le nom choisi
+    func outputName(for sourceId: UInt8) -> String {
+        return sourceId == 0 ? ndiOutputName : "\(ndiOutputName) \(Int(sourceId) + 1)"
+    }
 }
 
 /// Error types for join mode
@@ -36,28 +51,32 @@ enum JoinModeError: Error, LocalizedError {
 
 /// Main join mode controller
 /// Receives network → Decodes H.264 → Outputs NDI
-final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDelegate {
+/// Packets are demultiplexed by `sourceId`: source 0 gets its pipeline at start, any
+/// other source of a multi-source Host gets one (and its own NDI output) on first packet
+final class JoinMode: NetworkReceiverDelegate {
 
     private let networkReceiver: NetworkReceiver
-    private let decoder = VideoDecoder()
-    private let ndiSender: NDISender
+    private var pipelines: [UInt8: JoinPipeline] = [:]  // Mutated on the receiver queue once started
+    private let pipelinesLock = NSLock()
 
     private var config: JoinModeConfig
     private var isRunning = false
-
-    // Buffer for delayed playback
-    private var frameBuffer: FrameBuffer?
-    private var outputTimer: DispatchSourceTimer?
-    private let outputQueue = DispatchQueue(label: "com.ndibridge.output", qos: .userInteractive)
+    private var rejectedSources = Set<UInt8>()
+    private var metricsServer: MetricsServer?
 
     // Statistics
     private var startTime: Date?
-    private var framesOutput: UInt64 = 0
 
     init(config: JoinModeConfig = JoinModeConfig()) {
         self.config = config
-        self.networkReceiver = NetworkReceiver(port: config.listenPort)
-        self.ndiSender = NDISender(name: config.ndiOutputName)
+        self.networkReceiver = NetworkReceiver(
+            port: config.listenPort,
+            nackHoldMs: config.nackHoldMs,
+            capabilities: config.measureLatency ? [.avcc, .pcm16, .aacELD, .timing] : [.avcc, .pcm16, .aacELD],
+            reportIntervalMs: config.reportIntervalMs,
+            multicastGroup: config.multicastGroup,
+            layer: config.layer
+        )
 
         logger.info("JoinMode initialized", subsystem: .join)
     }
@@ -76,31 +95,28 @@ final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDe
         logger.info("═══════════════════════════════════════════════════════", subsystem: .join)
         logger.info("Starting JOIN MODE (Receiver)", subsystem: .join)
         logger.info("Listen port: \(config.listenPort)", subsystem: .join)
+        if let group = config.multicastGroup {
+            logger.info("Multicast group: \(group)", subsystem: .join)
+        }
+        if config.layer > 0 {
+            logger.info("Simulcast layer: \(config.layer)", subsystem: .join)
+        }
         logger.info("NDI output: '\(config.ndiOutputName)'", subsystem: .join)
-        if config.bufferMs > 0 {
+        if config.bufferMaxMs > config.bufferMs {
+            logger.info("Buffer: adaptive \(config.bufferMs)-\(config.bufferMaxMs)ms", subsystem: .join)
+        } else if config.bufferMs > 0 {
             logger.info("Buffer: \(config.bufferMs)ms delay", subsystem: .join)
         } else {
             logger.info("Buffer: disabled (real-time)", subsystem: .join)
         }
         logger.info("═══════════════════════════════════════════════════════", subsystem: .join)
 
-        // Step 1: Setup decoder
+        // Step 1-2: Decoder and NDI output of the first source
         logger.info("Step 1/3: Initializing H.264 decoder...", subsystem: .join)
-        decoder.delegate = self
-        logger.success("Decoder ready (waiting for SPS/PPS)", subsystem: .join)
-
-        // Step 2: Start NDI sender
         logger.info("Step 2/3: Starting NDI output...", subsystem: .join)
-        ndiSender.delegate = self
-        do {
-            try ndiSender.start(
-                width: config.outputWidth,
-                height: config.outputHeight
-            )
-        } catch {
-            logger.error("Failed to start NDI output: \(error.localizedDescription)", subsystem: .join)
-            throw JoinModeError.ndiOutputFailed
-        }
+        let primary = try makePipeline(sourceId: 0)
+        pipelines[0] = primary
+        logger.success("Decoder ready (waiting for SPS/PPS)", subsystem: .join)
 
         // Step 3: Start network receiver
         logger.info("Step 3/3: Starting network listener...", subsystem: .join)
@@ -109,17 +125,16 @@ final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDe
             try networkReceiver.startListening(port: config.listenPort)
         } catch {
             logger.error("Failed to start network listener: \(error.localizedDescription)", subsystem: .join)
-            ndiSender.stop()
+            primary.stop()
+            pipelines.removeAll()
             throw JoinModeError.networkFailed
         }
 
         isRunning = true
         startTime = Date()
+        startMetricsServer()
 
-        // Initialize buffer if configured
         if config.bufferMs > 0 {
-            frameBuffer = FrameBuffer(bufferMs: config.bufferMs)
-            startOutputTimer()
             logger.success("Buffer enabled: \(config.bufferMs)ms delay", subsystem: .join)
         }
 
@@ -133,45 +148,6 @@ final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDe
         logger.success("═══════════════════════════════════════════════════════", subsystem: .join)
     }
 
-    /// Start the output timer for buffered playback
-    private func startOutputTimer() {
-        outputTimer = DispatchSource.makeTimerSource(queue: outputQueue)
-        outputTimer?.schedule(deadline: .now(), repeating: .milliseconds(1))
-        outputTimer?.setEventHandler { [weak self] in
-            self?.processBufferedFrames()
-        }
-        outputTimer?.resume()
-    }
-
-    /// Process buffered frames and send them to NDI when ready
-    private func processBufferedFrames() {
-        guard let buffer = frameBuffer else { return }
-
-        // Emit ready video frames
-        for frame in buffer.dequeueReadyVideo() {
-            do {
-                try ndiSender.send(pixelBuffer: frame.pixelBuffer, timestamp: frame.timestamp)
-                framesOutput += 1
-            } catch {
-                logger.error("Buffer video send error: \(error.localizedDescription)", subsystem: .join)
-            }
-        }
-
-        // Emit ready audio frames
-        for frame in buffer.dequeueReadyAudio() {
-            do {
-                try ndiSender.sendAudio(
-                    data: frame.data,
-                    timestamp: frame.timestamp,
-                    sampleRate: frame.sampleRate,
-                    channels: frame.channels
-                )
-            } catch {
-                logger.error("Buffer audio send error: \(error.localizedDescription)", subsystem: .join)
-            }
-        }
-    }
-
     /// Stop join mode
     func stop() {
         guard isRunning else { return }
@@ -179,19 +155,19 @@ final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDe
         logger.info("Stopping Join Mode...", subsystem: .join)
 
         isRunning = false
-
-        // Stop buffer timer
-        outputTimer?.cancel()
-        outputTimer = nil
-        frameBuffer?.flush()
-        frameBuffer = nil
-
         networkReceiver.stop()
-        decoder.invalidate()
-        ndiSender.stop()
+        metricsServer?.stop()
+        metricsServer = nil
+
+        pipelinesLock.lock()
+        let all = Array(pipelines.values)
+        pipelines.removeAll()
+        pipelinesLock.unlock()
+        all.forEach { $0.stop() }
 
         if let start = startTime {
             let duration = Date().timeIntervalSince(start)
+            let framesOutput = all.reduce(UInt64(0)) { $0 + $1.framesOutput }
             logger.success("Join mode stopped. Duration: \(String(format: "%.1f", duration))s, Frames output: \(framesOutput)", subsystem: .join)
         }
     }
@@ -199,72 +175,102 @@ final class JoinMode: NetworkReceiverDelegate, VideoDecoderDelegate, NDISenderDe
     /// Update NDI output name
     func setOutputName(_ name: String) {
         config.ndiOutputName = name
-        ndiSender.setSourceName(name)
+        pipelinesLock.lock()
+        let current = pipelines
+        pipelinesLock.unlock()
+        for (sourceId, pipeline) in current {
+            pipeline.setOutputName(config.outputName(for: sourceId))
+        }
     }
 
-    // MARK: - NetworkReceiverDelegate
+    // MARK: - Private Helpers
 
-    func networkReceiver(_ receiver: NetworkReceiver, didReceiveVideoFrame data: Data, isKeyframe: Bool, timestamp: UInt64) {
-        // Decode the received video frame
+    /// Metrics are optional: a busy port must not keep reception from starting
+    private func startMetricsServer() {
+        guard config.metricsPort > 0 else { return }
+        let server = MetricsServer(port: config.metricsPort)
         do {
-            try decoder.decode(data: data, timestamp: timestamp)
+            try server.start()
+            metricsServer = server
         } catch {
-            logger.error("Decode error: \(error.localizedDescription)", subsystem: .join)
+            logger.warning("Metrics endpoint unavailable on port \(config.metricsPort): \(error.localizedDescription)", subsystem: .join)
         }
     }
 
-    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32) {
-        if let buffer = frameBuffer {
-            // Buffered mode: enqueue for delayed playback
-            buffer.enqueueAudio(data, timestamp: timestamp, sampleRate: sampleRate, channels: channels)
-        } else {
-            // Real-time mode: send directly to NDI output
-            do {
-                try ndiSender.sendAudio(data: data, timestamp: timestamp, sampleRate: sampleRate, channels: channels)
-            } catch {
-                logger.error("NDI audio send error: \(error.localizedDescription)", subsystem: .join)
-            }
-        }
+    private func makePipeline(sourceId: UInt8) throws -> JoinPipeline {
+        let pipeline = JoinPipeline(
+            sourceId: sourceId,
+            outputName: config.outputName(for: sourceId),
+            bufferMs: config.bufferMs,
+            bufferMaxMs: config.bufferMaxMs,
+            outputWidth: config.outputWidth,
+            outputHeight: config.outputHeight,
+            receiver: networkReceiver,
+            measureLatency: config.measureLatency,
+            outputFormat: config.outputFormat,
+            scaleOutput: config.scaleOutput,
+            asyncSend: config.asyncSend
+        )
+        try pipeline.start()
+        return pipeline
     }
 
-    func networkReceiver(_ receiver: NetworkReceiver, didDisconnect error: Error?) {
-        if let error = error {
-            logger.error("Network disconnected: \(error.localizedDescription)", subsystem: .join)
-        } else {
-            logger.warning("Network connection closed", subsystem: .join)
+    /// Pipeline of `sourceId`, created on its first packet (runs on the receiver queue)
+    private func pipeline(for sourceId: UInt8) -> JoinPipeline? {
+        pipelinesLock.lock()
+        defer { pipelinesLock.unlock() }
+
+        if let existing = pipelines[sourceId] {
+            return existing
         }
-    }
+        guard isRunning, !rejectedSources.contains(sourceId) else { return nil }
 
-    // MARK: - VideoDecoderDelegate
+        guard pipelines.count < config.maxSources else {
+            rejectedSources.insert(sourceId)
+            logger.warning("Source \(sourceId) ignored: \(config.maxSources) NDI outputs already running", subsystem: .join)
+            return nil
+        }
 
-    func videoDecoder(_ decoder: VideoDecoder, didDecodeFrame pixelBuffer: CVPixelBuffer, timestamp: UInt64) {
-        if let buffer = frameBuffer {
-            // Buffered mode: enqueue for delayed playback
-            buffer.enqueueVideo(pixelBuffer, timestamp: timestamp)
-        } else {
-            // Real-time mode: send directly to NDI output
-            framesOutput += 1
-            do {
-                try ndiSender.send(pixelBuffer: pixelBuffer, timestamp: timestamp)
-            } catch {
-                logger.error("NDI send error: \(error.localizedDescription)", subsystem: .join)
-            }
+        do {
+            let created = try makePipeline(sourceId: sourceId)
+            pipelines[sourceId] = created
+            logger.success("New source \(sourceId) → NDI output '\(created.outputName)'", subsystem: .join)
+            return created
+        } catch {
+            rejectedSources.insert(sourceId)
+            logger.error("Source \(sourceId) has no output: \(error.localizedDescription)", subsystem: .join)
+            return nil
         }
     }
 
-    func videoDecoder(_ decoder: VideoDecoder, didFailWithError error: Error) {
-        logger.error("Decoder error: \(error.localizedDescription)", subsystem: .join)
+    // MARK: - NetworkReceiverDelegate
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveVideoFrame frame: ReassembledFrame) {
+        pipeline(for: frame.sourceId)?.handleVideo(frame)
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveParameterSets parameterSets: [Data], codec: VideoCodec, sourceId: UInt8) {
+        pipeline(for: sourceId)?.handleParameterSets(parameterSets, codec: codec)
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveTiming timing: HostFrameTiming, timestamp: UInt64, sourceId: UInt8) {
+        pipeline(for: sourceId)?.handleTiming(timing, timestamp: timestamp)
     }
 
-    // MARK: - NDISenderDelegate
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32, sourceId: UInt8) {
+        pipeline(for: sourceId)?.handleAudio(data, timestamp: timestamp, sampleRate: sampleRate, channels: channels,
+                                             samplesPerChannel: samplesPerChannel)
+    }
 
-    func ndiSender(_ sender: NDISender, didStartWithName name: String) {
-        logger.success("NDI output broadcasting as '\(name)'", subsystem: .join)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveEncodedAudio data: Data, codec: AudioCodec, timestamp: UInt64, sampleRate: Int32, channels: Int32, sourceId: UInt8) {
+        pipeline(for: sourceId)?.handleEncodedAudio(data, codec: codec, timestamp: timestamp, sampleRate: sampleRate, channels: channels)
     }
 
-    func ndiSender(_ sender: NDISender, didFailWithError error: Error?) {
+    func networkReceiver(_ receiver: NetworkReceiver, didDisconnect error: Error?) {
         if let error = error {
-            logger.error("NDI sender error: \(error.localizedDescription)", subsystem: .join)
+            logger.error("Network disconnected: \(error.localizedDescription)", subsystem: .join)
+        } else {
+            logger.warning("Network connection closed", subsystem: .join)
         }
     }
 }
@@ -0,0 +1,375 @@
+//
+//  JoinPipeline.swift
+//  NDI Bridge Mac
+//
+//  One received source: decoding → optional delay buffer → NDI output
+//
+
+import Foundation
+import CoreVideo
+import QuartzCore
+
+/// Decode and output chain of a single Host source.
+/// JoinMode demultiplexes the stream by `sourceId` and runs one pipeline per source,
+/// each with its own decoder, delay buffer, output clock and NDI sender
+final class JoinPipeline: VideoDecoderDelegate, NDISenderDelegate {
+    let sourceId: UInt8
+    private(set) var outputName: String
+
+    private let decoder = VideoDecoder()
+    private let ndiSender: NDISender
+    private weak var receiver: NetworkReceiver?  // Keyframe requests for this source
+    private let layer: UInt8                     // Rendition received, part of the signpost IDs
+    private let latency: LatencyTracker?         // Per-stage latency histograms (join --latency)
+
+    private let bufferMs: Int
+    private let bufferMaxMs: Int            // Above bufferMs: adaptive jitter buffer depth
+    private var bufferEnabled: Bool { bufferMs > 0 || bufferMaxMs > 0 }
+    private var bufferCapacity: Int { FrameBuffer.frameCapacity(bufferMs: max(bufferMs, bufferMaxMs)) }
+    private let outputWidth: Int32
+    private let outputHeight: Int32
+    private let outputFormat: NDIOutputFormat
+    private let scaleOutput: Bool           // Scale to outputWidth x outputHeight (UYVY output only)
+    private var converter: PixelConverter?  // Decoder NV12 → NDI UYVY
+    private let audioDecoder = AudioDecoder()  // Compressed audio, used on the receive queue
+
+    // Buffer for delayed playback
+    private var frameBuffer: FrameBuffer?
+    private var outputTimer: DispatchSourceTimer?
+    private let outputQueue: DispatchQueue
+
+    // Statistics
+    private let outputCounter: MetricCounter
+    private let decodeErrors: MetricCounter
+    private let framesDecoded: MetricCounter
+    private let decodeLatencyMicros: MetricCounter
+    var framesOutput: UInt64 { outputCounter.value }
+
+    // Submit times of frames inside the decoder, by timestamp (decode latency metric)
+    private var decodeSubmitted: [UInt64: UInt64] = [:]
+    private let decodeLock = NSLock()
+    private static let maxInFlightDecodes = 64
+
+    /// Decoder buffers in use for references and in-flight output, on top of the delay
+    private static let decoderWorkingSet = 6
+
+    /// Converter buffers being converted or still held by the async NDI send, on top of the delay
+    private static let converterWorkingSet = 4
+
+    init(sourceId: UInt8, outputName: String, bufferMs: Int, bufferMaxMs: Int = 0, outputWidth: Int32, outputHeight: Int32, receiver: NetworkReceiver,
+         measureLatency: Bool = false, outputFormat: NDIOutputFormat = .uyvy, scaleOutput: Bool = false,
+         asyncSend: Bool = true) {
+        self.sourceId = sourceId
+        self.outputName = outputName
+        self.bufferMs = bufferMs
+        self.bufferMaxMs = bufferMaxMs
+        self.outputWidth = outputWidth
+        self.outputHeight = outputHeight
+        self.outputFormat = outputFormat
+        self.scaleOutput = scaleOutput
+        self.receiver = receiver
+        self.layer = receiver.layer
+        self.latency = measureLatency ? LatencyTracker(name: outputName, clock: receiver.clock) : nil
+        // The delay buffer presents frames on its own clock: no SDK pacing on top of it
+        self.ndiSender = NDISender(name: outputName, asyncVideo: asyncSend, clockVideo: bufferMs == 0 && bufferMaxMs == 0)
+        self.outputQueue = DispatchQueue(label: "com.ndibridge.output.\(sourceId)", qos: .userInteractive)
+
+        let labels = ["source": String(sourceId)]
+        outputCounter = metrics.counter("ndibridge_join_frames_output_total", help: "Video frames sent to the NDI output", labels: labels,
+                                        rate: MetricRate(name: "ndibridge_join_output_fps", help: "Output frame rate since the previous scrape"))
+        framesDecoded = metrics.counter("ndibridge_join_frames_decoded_total", help: "Video frames out of the decoder", labels: labels)
+        decodeErrors = metrics.counter("ndibridge_join_decode_errors_total", help: "Frames the decoder rejected or failed", labels: labels)
+        decodeLatencyMicros = metrics.counter("ndibridge_join_decode_latency_microseconds_total",
+                                              help: "Sum of submit to output decoder latency; divide by frames_decoded_total", labels: labels)
+    }
+
+    deinit {
+        stop()
+    }
+
+    /// Set up the decoder, start the NDI output and the delay buffer
+    func start() throws {
+        decoder.delegate = self
+        switch outputFormat {
+        case .uyvy:
+            // The delay buffer holds converter buffers: its pool covers the delay, the
+            // decoder's buffers are released as soon as they are converted
+            decoder.outputPixelFormat = kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange
+            converter = PixelConverter(targetWidth: scaleOutput ? Int(outputWidth) : nil,
+                                       targetHeight: scaleOutput ? Int(outputHeight) : nil,
+                                       minimumBufferCount: bufferEnabled ? bufferCapacity + JoinPipeline.converterWorkingSet : 0)
+        case .bgra:
+            if scaleOutput {
+                logger.warning("[\(outputName)] Output scaling needs UYVY output - sending at source size", subsystem: .join)
+            }
+            if bufferEnabled {
+                // Decoder pool large enough to hold the whole delay plus its own reference frames
+                decoder.minimumBufferCount = bufferCapacity + JoinPipeline.decoderWorkingSet
+            }
+        }
+
+        ndiSender.delegate = self
+        do {
+            try ndiSender.start(width: outputWidth, height: outputHeight)
+        } catch {
+            logger.error("Failed to start NDI output '\(outputName)': \(error.localizedDescription)", subsystem: .join)
+            throw JoinModeError.ndiOutputFailed
+        }
+
+        // Initialize buffer if configured
+        if bufferEnabled {
+            let buffer = FrameBuffer(
+                bufferMs: bufferMs,
+                maxBufferMs: bufferMaxMs,
+                retainBudget: bufferCapacity
+            )
+            frameBuffer = buffer
+            metrics.register("ndibridge_join_buffer_video_frames", help: "Video frames held by the delay buffer", kind: .gauge,
+                             labels: ["source": String(sourceId)]) { [weak buffer] in
+                buffer.map { Double($0.videoCount) }
+            }
+            metrics.register("ndibridge_join_buffer_audio_frames", help: "Audio frames held by the delay buffer", kind: .gauge,
+                             labels: ["source": String(sourceId)]) { [weak buffer] in
+                buffer.map { Double($0.audioCount) }
+            }
+            metrics.register("ndibridge_join_buffer_target_ms", help: "Jitter buffer depth above the minimum transit", kind: .gauge,
+                             labels: ["source": String(sourceId)]) { [weak buffer] in
+                buffer.map { $0.targetDelayMs }
+            }
+            metrics.register("ndibridge_join_arrival_jitter_ms", help: "Smoothed inter-arrival jitter seen by the jitter buffer", kind: .gauge,
+                             labels: ["source": String(sourceId)]) { [weak buffer] in
+                buffer.map { $0.jitterMs }
+            }
+            metrics.register("ndibridge_join_buffer_late_frames_total", help: "Frames that reached the buffer after their playout time", kind: .counter,
+                             labels: ["source": String(sourceId)]) { [weak buffer] in
+                buffer.map { Double($0.lateFrames) }
+            }
+            startOutputTimer()
+        }
+    }
+
+    func stop() {
+        // Stop buffer timer
+        outputTimer?.cancel()
+        outputTimer = nil
+        if let drops = frameBuffer?.poolExhaustedDrops, drops > 0 {
+            logger.warning("[\(outputName)] Buffer pool full: \(drops) video frames skipped", subsystem: .join)
+        }
+        if let copies = frameBuffer?.copyFallbacks, copies > 0 {
+            logger.info("[\(outputName)] Buffer: \(copies) video frames copied (decoder pool budget reached)", subsystem: .join)
+        }
+        frameBuffer?.flush()
+        frameBuffer = nil
+        latency?.logSummary()
+
+        decoder.invalidate()
+        ndiSender.stop()
+    }
+
+    /// Update NDI output name
+    func setOutputName(_ name: String) {
+        outputName = name
+        ndiSender.setSourceName(name)
+    }
+
+    // MARK: - Input (network receiver queue)
+
+    func handleVideo(_ frame: ReassembledFrame) {
+        latency?.recordReceived(timestamp: frame.timestamp,
+                                first: StageClock.micros(frame.firstPacketAt),
+                                last: StageClock.micros(frame.completedAt))
+
+        decodeLock.lock()
+        if decodeSubmitted.count >= JoinPipeline.maxInFlightDecodes {
+            decodeSubmitted.removeAll()  // Frames the decoder dropped never come back
+        }
+        decodeSubmitted[frame.timestamp] = StageClock.now()
+        decodeLock.unlock()
+
+        // Decode the received video frame
+        Signposts.begin("Decode", timestamp: frame.timestamp, sourceId: sourceId, layer: layer)
+        do {
+            if frame.isAVCC {
+                try decoder.decode(avcc: frame.data, timestamp: frame.timestamp, codec: frame.codec)
+            } else {
+                try decoder.decode(data: frame.data, timestamp: frame.timestamp, codec: frame.codec)
+            }
+        } catch VideoDecoderError.noParameterSets {
+            // Parameter set packet lost - the next keyframe brings new ones
+            Signposts.abandon("Decode", timestamp: frame.timestamp, sourceId: sourceId, layer: layer)
+            receiver?.requestKeyframe(sourceId: sourceId)
+        } catch {
+            Signposts.abandon("Decode", timestamp: frame.timestamp, sourceId: sourceId, layer: layer)
+            decodeErrors.add()
+            logger.error("[\(outputName)] Decode error: \(error.localizedDescription)", subsystem: .join)
+        }
+    }
+
+    func handleTiming(_ timing: HostFrameTiming, timestamp: UInt64) {
+        latency?.recordHostTiming(timing, timestamp: timestamp)
+    }
+
+    func handleParameterSets(_ parameterSets: [Data], codec: VideoCodec) {
+        do {
+            try decoder.setParameterSets(parameterSets, codec: codec)
+        } catch {
+            logger.error("[\(outputName)] Parameter sets rejected: \(error.localizedDescription)", subsystem: .join)
+        }
+    }
+
+    /// Compressed audio (receive queue): decoded back to planar float, then handled as PCM
+    func handleEncodedAudio(_ data: Data, codec: AudioCodec, timestamp: UInt64, sampleRate: Int32, channels: Int32) {
+        guard let decoded = audioDecoder.decode(data, codec: codec, sampleRate: sampleRate, channels: channels) else { return }
+        handleAudio(decoded.data, timestamp: timestamp, sampleRate: sampleRate, channels: channels,
+                    samplesPerChannel: decoded.samplesPerChannel)
+    }
+
+    func handleAudio(_ data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32) {
+        if let buffer = frameBuffer {
+            // Buffered mode: enqueue for delayed playback
+            if buffer.enqueueAudio(data, timestamp: timestamp, sampleRate: sampleRate, channels: channels,
+                                   samplesPerChannel: samplesPerChannel) {
+                outputClockNeedsRearm()
+            }
+        } else {
+            // Real-time mode: send directly to NDI output
+            do {
+                try ndiSender.sendAudio(data: data, timestamp: timestamp, sampleRate: sampleRate, channels: channels,
+                                        samplesPerChannel: samplesPerChannel)
+            } catch {
+                logger.error("[\(outputName)] NDI audio send error: \(error.localizedDescription)", subsystem: .join)
+            }
+        }
+    }
+
+    // MARK: - Output clock
+
+    /// Start the output clock for buffered playback
+    /// The timer is one-shot: it is armed for the next frame's presentation time and
+    /// stays idle while the buffer is empty, until an enqueue re-arms it
+    private func startOutputTimer() {
+        outputTimer = DispatchSource.makeTimerSource(flags: .strict, queue: outputQueue)
+        outputTimer?.setEventHandler { [weak self] in
+            self?.processBufferedFrames()
+        }
+        outputTimer?.schedule(deadline: .distantFuture, repeating: .never)
+        outputTimer?.resume()
+    }
+
+    /// Arm the output clock for the earliest buffered frame (must run on outputQueue)
+    private func scheduleNextOutput() {
+        guard let timer = outputTimer, let buffer = frameBuffer else { return }
+
+        guard let next = buffer.nextPresentationTime else {
+            timer.schedule(deadline: .distantFuture, repeating: .never)
+            return
+        }
+
+        let delay = max(0, next - CACurrentMediaTime())
+        timer.schedule(
+            deadline: .now() + .nanoseconds(Int(delay * 1_000_000_000)),
+            repeating: .never,
+            leeway: .microseconds(100)
+        )
+    }
+
+    /// A frame landed in an empty buffer: the clock is idle and must be re-armed
+    private func outputClockNeedsRearm() {
+        outputQueue.async { [weak self] in
+            self?.scheduleNextOutput()
+        }
+    }
+
+    /// Process buffered frames and send them to NDI when ready
+    private func processBufferedFrames() {
+        guard let buffer = frameBuffer else { return }
+
+        // Emit ready video frames
+        for frame in buffer.dequeueReadyVideo() {
+            Signposts.end("Buffered", timestamp: frame.timestamp, sourceId: sourceId, layer: layer)
+            do {
+                try ndiSender.send(pixelBuffer: frame.pixelBuffer, timestamp: frame.timestamp)
+                latency?.recordOutput(timestamp: frame.timestamp)
+                outputCounter.add()
+            } catch {
+                logger.error("[\(outputName)] Buffer video send error: \(error.localizedDescription)", subsystem: .join)
+            }
+        }
+
+        // Emit ready audio frames
+        for frame in buffer.dequeueReadyAudio() {
+            do {
+                try ndiSender.sendAudio(
+                    data: frame.data,
+                    timestamp: frame.timestamp,
+                    sampleRate: frame.sampleRate,
+                    channels: frame.channels,
+                    samplesPerChannel: frame.samplesPerChannel
+                )
+            } catch {
+                logger.error("[\(outputName)] Buffer audio send error: \(error.localizedDescription)", subsystem: .join)
+            }
+        }
+
+        scheduleNextOutput()
+    }
+
+    // MARK: - VideoDecoderDelegate
+
+    func videoDecoder(_ decoder: VideoDecoder, didDecodeFrame decodedBuffer: CVPixelBuffer, timestamp: UInt64) {
+        Signposts.end("Decode", timestamp: timestamp, sourceId: sourceId, layer: layer)
+        latency?.recordDecoded(timestamp: timestamp)
+        framesDecoded.add()
+        let decoded = StageClock.now()
+        decodeLock.lock()
+        let submitted = decodeSubmitted.removeValue(forKey: timestamp)
+        decodeLock.unlock()
+        if let submitted = submitted, decoded > submitted {
+            decodeLatencyMicros.add(decoded - submitted)
+        }
+
+        // NV12 → UYVY (and scaling) before the delay buffer, so it holds the smaller frames
+        var pixelBuffer = decodedBuffer
+        if let converter = converter {
+            guard let converted = Signposts.interval("Convert", timestamp: timestamp, { converter.convert(decodedBuffer) }) else {
+                logger.warning("[\(outputName)] No UYVY output buffer - frame dropped", subsystem: .join)
+                return
+            }
+            pixelBuffer = converted
+        }
+
+        if let buffer = frameBuffer {
+            // Buffered mode: enqueue for delayed playback
+            Signposts.begin("Buffered", timestamp: timestamp, sourceId: sourceId, layer: layer)
+            if buffer.enqueueVideo(pixelBuffer, timestamp: timestamp) {
+                outputClockNeedsRearm()
+            }
+        } else {
+            // Real-time mode: send directly to NDI output
+            outputCounter.add()
+            do {
+                try ndiSender.send(pixelBuffer: pixelBuffer, timestamp: timestamp)
+                latency?.recordOutput(timestamp: timestamp)
+            } catch {
+                logger.error("[\(outputName)] NDI send error: \(error.localizedDescription)", subsystem: .join)
+            }
+        }
+    }
+
+    func videoDecoder(_ decoder: VideoDecoder, didFailWithError error: Error) {
+        decodeErrors.add()
+        logger.error("[\(outputName)] Decoder error: \(error.localizedDescription)", subsystem: .join)
+    }
+
+    // MARK: - NDISenderDelegate
+
+    func ndiSender(_ sender: NDISender, didStartWithName name: String) {
+        logger.success("NDI output broadcasting as '\(name)'", subsystem: .join)
+    }
+
+    func ndiSender(_ sender: NDISender, didFailWithError error: Error?) {
+        if let error = error {
+            logger.error("NDI sender error: \(error.localizedDescription)", subsystem: .join)
+        }
+    }
+}
@@ -21,6 +21,7 @@ enum NDISenderError: Error, LocalizedError {
     case initializationFailed
     case senderCreationFailed
     case invalidPixelBuffer
+    case invalidAudioBuffer
     case notStarted
 
     var errorDescription: String? {
@@ -28,11 +29,18 @@ enum NDISenderError: Error, LocalizedError {
         case .initializationFailed: return "Failed to initialize NDI SDK"
         case .senderCreationFailed: return "Failed to create NDI sender"
         case .invalidPixelBuffer: return "Invalid pixel buffer"
+        case .invalidAudioBuffer: return "Audio buffer smaller than its channels and samples"
         case .notStarted: return "NDI sender not started"
         }
     }
 }
 
+/// Pixel format of the frames handed to the NDI SDK
+enum NDIOutputFormat: String {
+    case uyvy  // NDI's native format: 2 bytes/pixel, converted from the decoder's NV12
+    case bgra  // 4 bytes/pixel straight from the decoder; the SDK converts it to YUV
+}
+
 /// Broadcasts decoded video as NDI source
 final class NDISender {
     weak var delegate: NDISenderDelegate?
@@ -44,6 +52,14 @@ final class NDISender {
     // Video frame - allocated once and reused
     private var videoFrame: UnsafeMutablePointer<NDIBridgeVideoFrame>?
 
+    // Async video: the SDK reads the last frame sent until the next send returns, so its
+    // descriptor and its (still locked) pixel buffer are kept aside meanwhile and the
+    // two descriptors alternate - frame N+1 is filled while frame N is transmitted
+    private let asyncVideo: Bool
+    private let clockVideo: Bool
+    private var inFlightFrame: UnsafeMutablePointer<NDIBridgeVideoFrame>?
+    private var inFlightBuffer: CVPixelBuffer?
+
     // Audio frame - allocated once and reused
     private var audioFrame: UnsafeMutablePointer<NDIBridgeAudioFrame>?
 
@@ -65,8 +81,15 @@ final class NDISender {
     private var framesSent: UInt64 = 0
     private var lastStatsTime: CFTimeInterval = 0
 
-    init(name: String = "NDI Bridge Output") {
+    /// - Parameters:
+    ///   - asyncVideo: return from `send` once the SDK has queued the frame instead of
+    ///     after it was transmitted
+    ///   - clockVideo: let the SDK pace video at the frame rate (sends block meanwhile);
+    ///     off when the caller already presents frames on its own clock
+    init(name: String = "NDI Bridge Output", asyncVideo: Bool = true, clockVideo: Bool = true) {
         self.sourceName = name
+        self.asyncVideo = asyncVideo
+        self.clockVideo = clockVideo
         logger.info("NDISender initializing with name: \(name)", subsystem: .ndi)
     }
 
@@ -100,16 +123,22 @@ final class NDISender {
             frameRateD = 1000
         }
 
-        // Initialize NDI if not already
-        guard ndi_initialize() else {
+        // Initialize NDI if not already (shared with the other senders of this process)
+        guard NDIRuntime.acquire() else {
             logger.error("Failed to initialize NDI SDK", subsystem: .ndi)
             throw NDISenderError.initializationFailed
         }
 
-        // Allocate video frame structure
+        // Allocate video frame structures (a second one for the frame in flight)
         videoFrame = ndi_video_frame_create()
-        guard videoFrame != nil else {
+        inFlightFrame = asyncVideo ? ndi_video_frame_create() : nil
+        guard videoFrame != nil, !asyncVideo || inFlightFrame != nil else {
             logger.error("Failed to allocate video frame", subsystem: .ndi)
+            ndi_video_frame_destroy(videoFrame)
+            ndi_video_frame_destroy(inFlightFrame)
+            videoFrame = nil
+            inFlightFrame = nil
+            NDIRuntime.release()
             throw NDISenderError.senderCreationFailed
         }
 
@@ -118,21 +147,27 @@ final class NDISender {
         guard audioFrame != nil else {
             logger.error("Failed to allocate audio frame", subsystem: .ndi)
             ndi_video_frame_destroy(videoFrame)
+            ndi_video_frame_destroy(inFlightFrame)
             videoFrame = nil
+            inFlightFrame = nil
+            NDIRuntime.release()
             throw NDISenderError.senderCreationFailed
         }
 
         // Create sender
         sender = sourceName.withCString { namePtr in
-            ndi_sender_create(namePtr)
+            ndi_sender_create_ex(namePtr, clockVideo)
         }
 
         guard sender != nil else {
             logger.error("Failed to create NDI sender", subsystem: .ndi)
             ndi_video_frame_destroy(videoFrame)
+            ndi_video_frame_destroy(inFlightFrame)
             ndi_audio_frame_destroy(audioFrame)
             videoFrame = nil
+            inFlightFrame = nil
             audioFrame = nil
+            NDIRuntime.release()
             throw NDISenderError.senderCreationFailed
         }
 
@@ -149,12 +184,19 @@ final class NDISender {
             throw NDISenderError.notStarted
         }
 
-        // Lock the pixel buffer
+        // Lock the pixel buffer - in async mode until the SDK is done with it
         CVPixelBufferLockBaseAddress(pixelBuffer, .readOnly)
-        defer { CVPixelBufferUnlockBaseAddress(pixelBuffer, .readOnly) }
+        defer {
+            if !asyncVideo {
+                CVPixelBufferUnlockBaseAddress(pixelBuffer, .readOnly)
+            }
+        }
 
         // Get pixel buffer info
         guard let baseAddress = CVPixelBufferGetBaseAddress(pixelBuffer) else {
+            if asyncVideo {
+                CVPixelBufferUnlockBaseAddress(pixelBuffer, .readOnly)
+            }
             throw NDISenderError.invalidPixelBuffer
         }
 
@@ -198,11 +240,14 @@ final class NDISender {
 
         // Initialize the video frame using the helper function
         // NDI FourCC uses little-endian: 'B' | ('G'<<8) | ('R'<<16) | ('A'<<24) = 0x41524742
+        let fourCC: UInt32 = CVPixelBufferGetPixelFormatType(pixelBuffer) == kCVPixelFormatType_422YpCbCr8
+            ? 0x5956_5955   // NDIlib_FourCC_video_type_UYVY
+            : 0x41524742    // NDIlib_FourCC_video_type_BGRA
         ndi_video_frame_init(
             frame,
             actualWidth,
             actualHeight,
-            0x41524742,  // NDIlib_FourCC_video_type_BGRA
+            fourCC,
             frameRateN,
             frameRateD,
             baseAddress.assumingMemoryBound(to: UInt8.self),
@@ -213,7 +258,20 @@ final class NDISender {
         frame.pointee.timestamp = Int64(bitPattern: timestamp)
 
         // Send frame
-        ndi_sender_send_video(senderPtr, frame)
+        if asyncVideo {
+            Signposts.interval("NDI send", timestamp: timestamp) {
+                ndi_sender_send_video_async(senderPtr, frame)
+            }
+            // The previous frame is released now that the call returned
+            releaseInFlightVideo()
+            inFlightBuffer = pixelBuffer
+            videoFrame = inFlightFrame
+            inFlightFrame = frame
+        } else {
+            Signposts.interval("NDI send", timestamp: timestamp) {
+                ndi_sender_send_video(senderPtr, frame)
+            }
+        }
 
         framesSent += 1
 
@@ -226,15 +284,22 @@ final class NDISender {
     }
 
     /// Send an audio frame
-    func sendAudio(data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32) throws {
+    /// `data` is 32-bit float planar, one row of `channelStride` bytes per channel
+    /// (0 = contiguous rows of `samplesPerChannel` samples)
+    func sendAudio(data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32,
+                   samplesPerChannel: Int32, channelStride: Int32 = 0) throws {
         guard isRunning, let senderPtr = sender, let frame = audioFrame else {
             throw NDISenderError.notStarted
         }
 
         // NDI audio expects 32-bit float planar format
-        // Each channel's samples are stored contiguously
         let bytesPerSample: Int32 = 4  // 32-bit float
-        let noSamples = Int32(data.count) / (channels * bytesPerSample)
+        let noSamples = samplesPerChannel
+        let stride = channelStride > 0 ? channelStride : noSamples * bytesPerSample
+        guard channels > 0, noSamples > 0, stride >= noSamples * bytesPerSample,
+              data.count >= Int(stride) * Int(channels - 1) + Int(noSamples * bytesPerSample) else {
+            throw NDISenderError.invalidAudioBuffer
+        }
 
         // We need to keep the data alive during send
         data.withUnsafeBytes { rawBuffer in
@@ -247,7 +312,7 @@ final class NDISender {
                 channels,
                 noSamples,
                 UnsafeMutablePointer(mutating: dataPtr.assumingMemoryBound(to: UInt8.self)),
-                noSamples * bytesPerSample  // channel_stride for planar format
+                stride
             )
 
             // Set timestamp
@@ -267,6 +332,10 @@ final class NDISender {
         logger.info("Stopping NDI sender...", subsystem: .ndi)
 
         if let senderPtr = sender {
+            if asyncVideo {
+                ndi_sender_flush_video_async(senderPtr)
+                releaseInFlightVideo()
+            }
             ndi_sender_destroy(senderPtr)
             sender = nil
         }
@@ -276,12 +345,18 @@ final class NDISender {
             videoFrame = nil
         }
 
+        if let frame = inFlightFrame {
+            ndi_video_frame_destroy(frame)
+            inFlightFrame = nil
+        }
+
         if let frame = audioFrame {
             ndi_audio_frame_destroy(frame)
             audioFrame = nil
         }
 
         isRunning = false
+        NDIRuntime.release()
 
         // Reset frame rate detection for next start
         lastFrameTimestamp = 0
@@ -293,6 +368,14 @@ final class NDISender {
         logger.success("NDI sender stopped. Video frames: \(framesSent), Audio frames: \(audioFramesSent)", subsystem: .ndi)
     }
 
+    /// Unlock the pixel buffer of the last async frame (the SDK must be done with it)
+    private func releaseInFlightVideo() {
+        if let buffer = inFlightBuffer {
+            CVPixelBufferUnlockBaseAddress(buffer, .readOnly)
+            inFlightBuffer = nil
+        }
+    }
+
     /// Update source name (requires restart)
     func setSourceName(_ name: String) {
         let wasRunning = isRunning
@@ -11,16 +11,31 @@ import QuartzCore
 
 /// Callback for received data
 protocol NetworkReceiverDelegate: AnyObject {
-    func networkReceiver(_ receiver: NetworkReceiver, didReceiveVideoFrame data: Data, isKeyframe: Bool, timestamp: UInt64)
-    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveVideoFrame frame: ReassembledFrame)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveParameterSets parameterSets: [Data], codec: VideoCodec, sourceId: UInt8)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32, sourceId: UInt8)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveEncodedAudio data: Data, codec: AudioCodec, timestamp: UInt64, sampleRate: Int32, channels: Int32, sourceId: UInt8)
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveTiming timing: HostFrameTiming, timestamp: UInt64, sourceId: UInt8)
     func networkReceiver(_ receiver: NetworkReceiver, didDisconnect error: Error?)
 }
 
 /// Extension with default implementation for backward compatibility
 extension NetworkReceiverDelegate {
-    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32) {
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveAudioFrame data: Data, timestamp: UInt64, sampleRate: Int32, channels: Int32, samplesPerChannel: Int32, sourceId: UInt8) {
         // Default: ignore audio if not implemented
     }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveEncodedAudio data: Data, codec: AudioCodec, timestamp: UInt64, sampleRate: Int32, channels: Int32, sourceId: UInt8) {
+        // Default: ignore compressed audio if not implemented
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveTiming timing: HostFrameTiming, timestamp: UInt64, sourceId: UInt8) {
+        // Default: no latency measurement
+    }
+
+    func networkReceiver(_ receiver: NetworkReceiver, didReceiveParameterSets parameterSets: [Data], codec: VideoCodec, sourceId: UInt8) {
+        // Default: only needed by receivers advertising AVCC
+    }
 }
 
 /// Parsed media packet header
@@ -28,7 +43,7 @@ struct ParsedMediaHeader {
     var version: UInt8 = 1
     var mediaType: UInt8 = 0        // 0 = video, 1 = audio
     var sourceId: UInt8 = 0
-    var flags: UInt8 = 0            // For video: bit 0 = keyframe
+    var flags: UInt8 = 0            // For video: bit 0 = keyframe, bit 1 = FEC parity, bit 2 = AVCC, bit 3 = retransmission
     var sequenceNumber: UInt32 = 0
     var timestamp: UInt64 = 0
     var totalSize: UInt32 = 0
@@ -37,84 +52,489 @@ struct ParsedMediaHeader {
     var payloadSize: UInt16 = 0
     var sampleRate: UInt32 = 48000  // Audio only
     var channels: UInt8 = 2         // Audio only
+    var fecGroupSize: UInt8 = 0     // Video FEC: data fragments per parity packet
+    var codec: UInt8 = 0            // Video: VideoCodec raw value
+    var layer: UInt8 = 0            // Video: simulcast rendition
 
     var isKeyframe: Bool { flags & 1 != 0 }
+    var isParity: Bool { flags & XORParity.parityFlag != 0 }
+    var isAVCC: Bool { flags & 0x04 != 0 }
+    var isRetransmit: Bool { flags & 0x08 != 0 }
     var isVideo: Bool { mediaType == 0 }
     var isAudio: Bool { mediaType == 1 }
+    var isParameterSets: Bool { mediaType == 2 }
+    var isTiming: Bool { mediaType == 3 }
 }
 
 /// Complete reassembled frame with metadata
 struct ReassembledFrame {
     let data: Data
+    let sequenceNumber: UInt32
     let timestamp: UInt64
     let mediaType: UInt8
+    let sourceId: UInt8         // Host pipeline the frame belongs to
     let isKeyframe: Bool
+    let isAVCC: Bool            // Video: length-prefixed NAL units instead of Annex-B
+    let isPCM16: Bool           // Audio: interleaved int16 instead of planar float
+    let audioCodec: AudioCodec? // Audio: nil when this build does not know the codec
+    let codec: VideoCodec
     let sampleRate: UInt32
     let channels: UInt8
+    let firstPacketAt: CFTimeInterval  // Arrival of the frame's first packet
+    let completedAt: CFTimeInterval    // Arrival of the packet that completed it
 }
 
 /// Reassembles fragmented media frames
+///
+/// Up to `slotCount` frames are assembled concurrently in a ring of slots indexed by
+/// sequence number, so packets of frame N+1 arriving before the tail of frame N no
+/// longer discard frame N. Each fragment is written straight into a frame buffer
+/// allocated at `totalSize` when the frame starts, at `fragmentIndex * maxPayload`,
+/// and the completed buffer is handed out as-is.
+///
+/// Frames are released in sequence order. An older incomplete frame is abandoned once
+/// a newer frame has been complete for `maxHoldTime` (`reorderHoldTime` by default, so a
+/// small frame overtaking the tail of a larger one does not cost the larger one).
+///
+/// When the sender emits XOR parity packets, a single lost fragment per parity group
+/// is rebuilt in place instead of dropping the whole frame.
+///
+/// Headers whose geometry cannot come from a real sender (no fragments, a size the
+/// fragments cannot carry, above `maxFrameSize`) are discarded before a slot is allocated.
+///
+/// `collectNacks` lists the fragments still missing from in-flight frames so the
+/// receiver can ask the sender to retransmit them while the frame is held.
 final class FrameReassembler {
-    private var fragments: [UInt16: Data] = [:]
-    private var expectedCount: UInt16 = 0
-    private var currentSequence: UInt32 = 0
-    private var timestamp: UInt64 = 0
-    private var flags: UInt8 = 0
-    private var mediaType: UInt8 = 0
-    private var totalSize: UInt32 = 0
-    private var sampleRate: UInt32 = 48000
-    private var channels: UInt8 = 2
+    static let slotCount = 8
 
-    func reset() {
-        fragments.removeAll()
-        expectedCount = 0
-        currentSequence = 0
+    /// Largest fragment payload accepted: a 9000-byte jumbo datagram minus the NDIB header
+    static let maxFragmentPayload = 9000 - MediaPacketHeader.size
+
+    /// Largest frame accepted, well above a 4K HEVC keyframe at the highest bitrates
+    static let maxFrameSize = 32 * 1024 * 1024
+
+    private enum SlotState {
+        case empty
+        case assembling
+        case complete
     }
 
-    func addFragment(header: ParsedMediaHeader, payload: Data) -> ReassembledFrame? {
-        // New frame sequence
-        if header.sequenceNumber != currentSequence {
-            if !fragments.isEmpty {
-                logger.warning("Incomplete frame dropped (seq: \(currentSequence), got \(fragments.count)/\(expectedCount))", subsystem: .network)
-            }
-            reset()
-            currentSequence = header.sequenceNumber
-            expectedCount = header.fragmentCount
+    /// One in-flight frame
+    private struct Slot {
+        var state: SlotState = .empty
+        var sequence: UInt32 = 0
+        var buffer = Data()
+        var received: [Bool] = []
+        var receivedCount = 0
+        var expectedCount = 0
+        var maxPayload = 0          // 0 = not inferred yet
+        var totalSize = 0
+        var timestamp: UInt64 = 0
+        var flags: UInt8 = 0
+        var mediaType: UInt8 = 0
+        var sourceId: UInt8 = 0
+        var layer: UInt8 = 0
+        var sampleRate: UInt32 = 48000
+        var channels: UInt8 = 2
+        var fecGroupSize = 0
+        var codec: UInt8 = 0
+        var parity: [Data?] = []
+        var completedAt: CFTimeInterval = 0
+        var begunAt: CFTimeInterval = 0
+        var highestIndex = -1       // Highest data fragment received so far
+        var nackCount = 0
+        var lastNackAt: CFTimeInterval = 0
+
+        var isComplete: Bool { receivedCount == expectedCount }
+
+        mutating func begin(header: ParsedMediaHeader) {
+            state = .assembling
+            sequence = header.sequenceNumber
+            expectedCount = Int(header.fragmentCount)
+            totalSize = Int(header.totalSize)
             timestamp = header.timestamp
-            flags = header.flags
+            flags = header.flags & ~(XORParity.parityFlag | 0x08)
             mediaType = header.mediaType
-            totalSize = header.totalSize
+            sourceId = header.sourceId
+            layer = header.layer
             sampleRate = header.sampleRate
             channels = header.channels
+            fecGroupSize = Int(header.fecGroupSize)
+            codec = header.codec
+            maxPayload = expectedCount == 1 ? totalSize : 0
+            receivedCount = 0
+            completedAt = 0
+            highestIndex = -1
+            nackCount = 0
+            lastNackAt = 0
+
+            // Audio frames are small and steady: their buffers come back through the pool
+            buffer = mediaType == MediaType.audio.rawValue
+                ? AudioBlockPool.shared.data(count: totalSize) { _ in }
+                : Data(count: totalSize)
+            received.removeAll(keepingCapacity: true)
+            received.append(contentsOf: repeatElement(false, count: expectedCount))
+            parity.removeAll(keepingCapacity: true)
+            if fecGroupSize > 0 {
+                let groups = XORParity.groupCount(fragmentCount: expectedCount, groupSize: fecGroupSize)
+                parity.append(contentsOf: repeatElement(nil, count: groups))
+            }
+        }
+
+        /// Payload size of fragment `index` once `maxPayload` is known
+        func length(of index: Int) -> Int {
+            return index == expectedCount - 1 ? totalSize - index * maxPayload : maxPayload
         }
 
-        // Store fragment
-        fragments[header.fragmentIndex] = payload
+        /// Infer the full-fragment payload size from a data fragment
+        mutating func inferMaxPayload(index: Int, payloadCount: Int) {
+            guard maxPayload == 0 else { return }
+            if index < expectedCount - 1 {
+                maxPayload = payloadCount
+            } else if expectedCount > 1 {
+                maxPayload = (totalSize - payloadCount) / (expectedCount - 1)
+            }
+        }
+
+        /// Copy a data fragment to its final position in the frame buffer
+        mutating func store(index: Int, payload: Data) -> Bool {
+            guard index < expectedCount, !received[index] else { return false }
+
+            inferMaxPayload(index: index, payloadCount: payload.count)
+            guard maxPayload > 0 else { return false }
 
-        // Check if complete
-        if fragments.count == Int(expectedCount) {
-            // Reassemble in order
-            var completeFrame = Data(capacity: Int(totalSize))
-            for i in 0..<expectedCount {
-                if let fragment = fragments[i] {
-                    completeFrame.append(fragment)
+            let offset = index * maxPayload
+            guard payload.count == length(of: index), offset + payload.count <= totalSize else {
+                return false
+            }
+
+            buffer.withUnsafeMutableBytes { (dst: UnsafeMutableRawBufferPointer) in
+                payload.withUnsafeBytes { (src: UnsafeRawBufferPointer) in
+                    guard let dstBase = dst.baseAddress, let srcBase = src.baseAddress else { return }
+                    dstBase.advanced(by: offset).copyMemory(from: srcBase, byteCount: src.count)
                 }
             }
 
-            let result = ReassembledFrame(
-                data: completeFrame,
-                timestamp: timestamp,
-                mediaType: mediaType,
-                isKeyframe: flags & 1 != 0,
-                sampleRate: sampleRate,
-                channels: channels
-            )
+            received[index] = true
+            receivedCount += 1
+            highestIndex = max(highestIndex, index)
+            return true
+        }
+
+        /// Keep a parity payload for later recovery
+        mutating func storeParity(group: Int, payload: Data) {
+            guard group < parity.count, parity[group] == nil else { return }
+
+            // A group's parity is as long as its first fragment, which is full-size
+            // unless that fragment is the frame's last one
+            if maxPayload == 0 && group * fecGroupSize < expectedCount - 1 {
+                maxPayload = payload.count
+            }
+            parity[group] = payload
+        }
+
+        /// Rebuild the only missing fragment of `group` from its parity
+        mutating func recover(group: Int) -> Int? {
+            guard maxPayload > 0, group < parity.count, let parityData = parity[group] else { return nil }
+
+            let members = XORParity.members(ofGroup: group, fragmentCount: expectedCount, groupSize: fecGroupSize)
+            var lost: Int?
+            for member in members where !received[member] {
+                guard lost == nil else { return nil }  // Two or more missing - unrecoverable
+                lost = member
+            }
+            guard let lostIndex = lost else { return nil }
+
+            let lostLength = length(of: lostIndex)
+            guard lostLength > 0, lostLength <= parityData.count else { return nil }
+
+            var rebuilt = Data(parityData)
+            let maxPayload = self.maxPayload
+            let lastIndex = expectedCount - 1
+            let lastLength = length(of: lastIndex)
+            buffer.withUnsafeMutableBytes { (frame: UnsafeMutableRawBufferPointer) in
+                rebuilt.withUnsafeMutableBytes { (acc: UnsafeMutableRawBufferPointer) in
+                    guard let frameBase = frame.baseAddress, let accBase = acc.baseAddress else { return }
+                    for member in members where member != lostIndex {
+                        let count = member == lastIndex ? lastLength : maxPayload
+                        XORParity.accumulate(accBase, frameBase.advanced(by: member * maxPayload), count: count)
+                    }
+                    frameBase.advanced(by: lostIndex * maxPayload).copyMemory(from: accBase, byteCount: lostLength)
+                }
+            }
+
+            received[lostIndex] = true
+            receivedCount += 1
+            return lostIndex
+        }
+    }
+
+    private var slots = [Slot](repeating: Slot(), count: FrameReassembler.slotCount)
+    private var releasedThrough: UInt32?  // Newest sequence delivered or abandoned
+
+    /// Default hold without NACKs: covers packets reordered on the path, not losses
+    static let reorderHoldTime: CFTimeInterval = 0.005
+
+    /// How long a complete frame may wait for an older incomplete one before that is abandoned
+    var maxHoldTime: CFTimeInterval = FrameReassembler.reorderHoldTime
+
+    /// Fragments rebuilt from parity since creation
+    private(set) var recoveredFragments: UInt64 = 0
+
+    /// Incomplete frames abandoned since creation
+    private(set) var droppedFrames: UInt64 = 0
+
+    /// Packets discarded for an impossible header since creation
+    private(set) var malformedPackets: UInt64 = 0
+
+    /// Packets the sender emitted for the frames seen (data + parity; a frame never seen
+    /// counts as one packet) and first-transmission packets actually received, for loss reports
+    private(set) var packetsExpected: UInt64 = 0
+    private(set) var packetsReceived: UInt64 = 0
+    private var newestBegun: UInt32?
+
+    func reset() {
+        for i in slots.indices {
+            slots[i].state = .empty
+            slots[i].buffer = Data()
+        }
+        releasedThrough = nil
+        newestBegun = nil
+    }
+
+    /// Add one packet and return every frame that became releasable, oldest first
+    func addFragment(header: ParsedMediaHeader, payload: Data, now: CFTimeInterval = CACurrentMediaTime()) -> [ReassembledFrame] {
+        guard FrameReassembler.isPlausible(header) else {
+            malformedPackets += 1
+            logger.debug("Malformed header dropped (seq: \(header.sequenceNumber), size: \(header.totalSize), fragment \(header.fragmentIndex)/\(header.fragmentCount))", subsystem: .network)
+            return []
+        }
+
+        let sequence = header.sequenceNumber
+        if !header.isRetransmit {
+            packetsReceived += 1
+        }
 
+        // Late packet, duplicate or parity for a frame already released
+        if let released = releasedThrough, !FrameReassembler.isNewer(sequence, than: released) {
+            guard released &- sequence > UInt32(FrameReassembler.slotCount * 4) else {
+                return []
+            }
+            // Far behind what was released: the sender restarted its sequence
+            logger.info("Sequence restarted (\(released) → \(sequence)), resetting reassembly", subsystem: .network)
             reset()
-            return result
         }
 
-        return nil
+        var output: [ReassembledFrame] = []
+        let index = Int(sequence % UInt32(FrameReassembler.slotCount))
+
+        if slots[index].state != .empty && slots[index].sequence != sequence {
+            guard FrameReassembler.isNewer(sequence, than: slots[index].sequence) else {
+                return []  // Older than the frame occupying the slot - too late
+            }
+            // The ring wrapped: everything up to the occupant must go first
+            release(through: slots[index].sequence, into: &output)
+        }
+
+        if slots[index].state == .empty {
+            slots[index].begin(header: header)
+            slots[index].begunAt = now
+            if header.isVideo {
+                Signposts.begin("Reassemble", timestamp: header.timestamp, sourceId: header.sourceId, layer: header.layer, sequence: sequence)
+            }
+            countExpected(header: header)
+        }
+
+        if slots[index].state == .assembling {
+            if header.isParity {
+                let group = Int(header.fragmentIndex)
+                slots[index].storeParity(group: group, payload: payload)
+                recover(slot: index, group: group)
+            } else if slots[index].store(index: Int(header.fragmentIndex), payload: payload),
+                      slots[index].fecGroupSize > 0 {
+                recover(slot: index, group: Int(header.fragmentIndex) / slots[index].fecGroupSize)
+            }
+
+            if slots[index].isComplete {
+                slots[index].state = .complete
+                slots[index].completedAt = now
+                if slots[index].mediaType == MediaType.video.rawValue {
+                    Signposts.end("Reassemble", timestamp: slots[index].timestamp, sourceId: slots[index].sourceId, layer: slots[index].layer)
+                }
+            }
+        }
+
+        releaseReady(now: now, into: &output)
+        return output
+    }
+
+    /// Missing fragment ranges of in-flight frames, at most one request per frame every
+    /// `interval` and `maxAttempts` in total. A frame's tail counts as missing only once a
+    /// newer frame has started, since its last packets may simply still be in flight
+    func collectNacks(now: CFTimeInterval, interval: CFTimeInterval, maxAttempts: Int) -> [NackRange] {
+        var newest: UInt32?
+        for slot in slots where slot.state != .empty {
+            if let current = newest, !FrameReassembler.isNewer(slot.sequence, than: current) {
+                continue
+            }
+            newest = slot.sequence
+        }
+
+        var ranges: [NackRange] = []
+        for i in slots.indices where slots[i].state == .assembling {
+            guard slots[i].nackCount < maxAttempts, now - slots[i].lastNackAt >= interval else { continue }
+
+            let limit = slots[i].sequence == newest ? slots[i].highestIndex : slots[i].expectedCount
+            guard limit > 0 else { continue }
+
+            let before = ranges.count
+            var runStart: Int?
+            for fragment in 0...limit {
+                let missing = fragment < limit && !slots[i].received[fragment]
+                if missing {
+                    if runStart == nil { runStart = fragment }
+                } else if let start = runStart {
+                    ranges.append(NackRange(
+                        sequenceNumber: slots[i].sequence,
+                        firstFragment: UInt16(start),
+                        fragmentCount: UInt16(fragment - start)
+                    ))
+                    runStart = nil
+                }
+            }
+
+            if ranges.count > before {
+                slots[i].nackCount += 1
+                slots[i].lastNackAt = now
+            }
+        }
+        return ranges
+    }
+
+    /// Whether a frame buffer may be allocated from this header: a spoofed or corrupt
+    /// `totalSize` would otherwise size the slot (up to 4 GB), and zero fragments would
+    /// make an empty frame complete at once
+    static func isPlausible(_ header: ParsedMediaHeader) -> Bool {
+        let fragments = Int(header.fragmentCount)
+        let totalSize = Int(header.totalSize)
+        guard fragments > 0, totalSize > 0, Int(header.fragmentIndex) < fragments else { return false }
+        return totalSize <= fragments * maxFragmentPayload &&
+            totalSize <= fragments * Int(UInt16.max) &&
+            totalSize <= maxFrameSize
+    }
+
+    /// Wrap-aware sequence comparison
+    static func isNewer(_ a: UInt32, than b: UInt32) -> Bool {
+        return Int32(bitPattern: a &- b) > 0
+    }
+
+    // MARK: - Private Helpers
+
+    /// Account for the packets of a newly started frame and of any frame skipped before it
+    private func countExpected(header: ParsedMediaHeader) {
+        let sequence = header.sequenceNumber
+        let fragments = Int(header.fragmentCount)
+        let parity = header.fecGroupSize > 0
+            ? XORParity.groupCount(fragmentCount: fragments, groupSize: Int(header.fecGroupSize))
+            : 0
+        packetsExpected += UInt64(fragments + parity)
+
+        guard let newest = newestBegun else {
+            newestBegun = sequence
+            return
+        }
+        if FrameReassembler.isNewer(sequence, than: newest) {
+            // Frames in between never showed a single packet (bounded: a jump that large is a sender restart)
+            packetsExpected += UInt64(min(sequence &- newest &- 1, 1024))
+            newestBegun = sequence
+        } else if packetsExpected > 0 {
+            // Reordered: this frame was already counted as one missing packet
+            packetsExpected -= 1
+        }
+    }
+
+    private func recover(slot index: Int, group: Int) {
+        if let lost = slots[index].recover(group: group) {
+            recoveredFragments += 1
+            logger.debug("FEC recovered fragment \(lost)/\(slots[index].expectedCount) (seq: \(slots[index].sequence))", subsystem: .network)
+        }
+    }
+
+    /// Index of the oldest occupied slot
+    private func oldestSlot() -> Int? {
+        var oldest: Int?
+        for i in slots.indices where slots[i].state != .empty {
+            if let current = oldest, !FrameReassembler.isNewer(slots[current].sequence, than: slots[i].sequence) {
+                continue
+            }
+            oldest = i
+        }
+        return oldest
+    }
+
+    /// Release complete frames in order; abandon an incomplete head once a newer frame has waited long enough
+    private func releaseReady(now: CFTimeInterval, into output: inout [ReassembledFrame]) {
+        while let head = oldestSlot() {
+            if slots[head].state == .complete {
+                output.append(deliver(slot: head))
+                continue
+            }
+
+            let headSequence = slots[head].sequence
+            let newerWaited = slots.contains { slot in
+                slot.state == .complete &&
+                    FrameReassembler.isNewer(slot.sequence, than: headSequence) &&
+                    now - slot.completedAt >= maxHoldTime
+            }
+            guard newerWaited else { return }
+            abandon(slot: head)
+        }
+    }
+
+    /// Release or abandon every occupied slot up to and including `sequence`
+    private func release(through sequence: UInt32, into output: inout [ReassembledFrame]) {
+        while let head = oldestSlot(), !FrameReassembler.isNewer(slots[head].sequence, than: sequence) {
+            if slots[head].state == .complete {
+                output.append(deliver(slot: head))
+            } else {
+                abandon(slot: head)
+            }
+        }
+    }
+
+    private func deliver(slot index: Int) -> ReassembledFrame {
+        let slot = slots[index]
+        let frame = ReassembledFrame(
+            data: slot.buffer,
+            sequenceNumber: slot.sequence,
+            timestamp: slot.timestamp,
+            mediaType: slot.mediaType,
+            sourceId: slot.sourceId,
+            isKeyframe: slot.flags & 1 != 0,
+            isAVCC: slot.flags & 0x04 != 0,
+            isPCM16: slot.mediaType == MediaType.audio.rawValue && slot.flags & MediaPacketHeader.pcm16Flag != 0,
+            audioCodec: slot.mediaType == MediaType.audio.rawValue ? AudioCodec(rawValue: slot.codec) : nil,
+            codec: VideoCodec(rawValue: slot.codec) ?? .h264,
+            sampleRate: slot.sampleRate,
+            channels: slot.channels,
+            firstPacketAt: slot.begunAt,
+            completedAt: slot.completedAt
+        )
+        slots[index].state = .empty
+        slots[index].buffer = Data()  // Hand ownership to the consumer
+        releasedThrough = slot.sequence
+        return frame
+    }
+
+    private func abandon(slot index: Int) {
+        let slot = slots[index]
+        logger.warning("Incomplete frame dropped (seq: \(slot.sequence), got \(slot.receivedCount)/\(slot.expectedCount))", subsystem: .network)
+        droppedFrames += 1
+        if slot.mediaType == MediaType.video.rawValue {
+            Signposts.abandon("Reassemble", timestamp: slot.timestamp, sourceId: slot.sourceId, layer: slot.layer)
+        }
+        slots[index].state = .empty
+        releasedThrough = slot.sequence
     }
 }
 
@@ -124,23 +544,139 @@ final class NetworkReceiver {
 
     private var listener: NWListener?
     private var connection: NWConnection?
+    private var connectionGroup: NWConnectionGroup?  // Multicast: media from the group, control on `connection`
     private let queue = DispatchQueue(label: "com.ndibridge.network.receiver", qos: .userInteractive)
     private var isListening = false
 
-    // Separate reassemblers for video and audio to avoid mixing frames
-    private let videoReassembler = FrameReassembler()
-    private let audioReassembler = FrameReassembler()
+    /// Per-source reception state: separate reassemblers for video and audio to avoid
+    /// mixing frames, plus what the periodic receiver report needs
+    private final class SourceStream {
+        let video = FrameReassembler()
+        let audio = FrameReassembler()
+
+        var bytesReceived: UInt64 = 0
+
+        // AVCC: sequence number of the last parameter sets received, and of the last keyframe they were NACKed for
+        var parameterSetSequence: UInt32?
+        var parameterSetNack: UInt32?
+
+        // RFC 3550 inter-arrival jitter over the first packet of each video frame
+        private(set) var jitter: CFTimeInterval = 0
+        private var lastArrival: CFTimeInterval = 0
+        private var lastMediaTime: CFTimeInterval = 0
+
+        // Counters at the previous report
+        private var reportedExpected: UInt64 = 0
+        private var reportedReceived: UInt64 = 0
+        private var reportedDropped: UInt64 = 0
+        private var reportedBytes: UInt64 = 0
+        var lastReportTime: CFTimeInterval = 0
+
+        init(maxHoldTime: CFTimeInterval) {
+            video.maxHoldTime = maxHoldTime
+            audio.maxHoldTime = maxHoldTime
+        }
+
+        func updateJitter(timestamp: UInt64, arrival: CFTimeInterval) {
+            let mediaTime = CFTimeInterval(timestamp) / 10_000_000  // 100ns units
+            defer {
+                lastArrival = arrival
+                lastMediaTime = mediaTime
+            }
+            guard lastArrival > 0 else { return }
+
+            let deviation = abs((arrival - lastArrival) - (mediaTime - lastMediaTime))
+            guard deviation < 1.0 else { return }  // Timestamp discontinuity, not jitter
+            jitter += (deviation - jitter) / 16
+        }
+
+        /// Statistics since the previous report
+        func makeReport(sourceId: UInt8, now: CFTimeInterval) -> ReceiverReport {
+            let expected = video.packetsExpected + audio.packetsExpected
+            let received = video.packetsReceived + audio.packetsReceived
+            let dropped = video.droppedFrames + audio.droppedFrames
+
+            let expectedDelta = expected - reportedExpected
+            let receivedDelta = received - reportedReceived
+            let report = ReceiverReport(
+                sourceId: sourceId,
+                intervalMs: UInt16(min(max(0, (now - lastReportTime) * 1000), Double(UInt16.max))),
+                packetsExpected: UInt32(truncatingIfNeeded: expectedDelta),
+                packetsLost: UInt32(truncatingIfNeeded: expectedDelta > receivedDelta ? expectedDelta - receivedDelta : 0),
+                framesDropped: UInt16(min(dropped - reportedDropped, UInt64(UInt16.max))),
+                jitterMicros: UInt32(min(jitter * 1_000_000, Double(UInt32.max))),
+                bytesReceived: UInt32(truncatingIfNeeded: bytesReceived - reportedBytes)
+            )
+
+            reportedExpected = expected
+            reportedReceived = received
+            reportedDropped = dropped
+            reportedBytes = bytesReceived
+            lastReportTime = now
+            return report
+        }
+    }
+
+    // One pair per Host source, created when its first packet arrives
+    private var sources: [UInt8: SourceStream] = [:]
+
+    // Retransmission requests (0 = never NACK, just drop incomplete frames)
+    private let nackHoldTime: CFTimeInterval
+    private let nackInterval: CFTimeInterval
+    private let nackMaxAttempts = 3
+    private var lastNackScan: CFTimeInterval = 0
+
+    // Keyframe requests after an unrecoverable video loss, rate-limited per source
+    private let keyframeRequestInterval: CFTimeInterval = 0.25
+    private var lastKeyframeRequest: [UInt8: CFTimeInterval] = [:]
+
+    // Capabilities hello, repeated so the Host falls back if this receiver goes away
+    private let capabilities: ReceiverCapabilities
+    private let helloInterval: CFTimeInterval = 1.0
+    private var lastHelloTime: CFTimeInterval = 0
+
+    // Clock probes answered by the Host, for cross-machine latency stages (`.timing` only)
+    let clock = ClockOffsetEstimator()
+
+    // Receiver reports feeding the Host bitrate controller (0 = off)
+    private let reportInterval: CFTimeInterval
+    private var lastReportScan: CFTimeInterval = 0
 
     // Statistics
-    private var totalBytesReceived: UInt64 = 0
-    private var totalPacketsReceived: UInt64 = 0
-    private var framesReceived: UInt64 = 0
+    private let bytesReceived = metrics.counter("ndibridge_join_bytes_received_total", help: "UDP bytes received from the Host",
+                                                rate: MetricRate(name: "ndibridge_join_receive_bitrate_bps", help: "Receive bitrate since the previous scrape", scale: 8))
+    private let packetsReceived = metrics.counter("ndibridge_join_packets_received_total", help: "UDP packets received from the Host")
+    private let framesReassembled = metrics.counter("ndibridge_join_frames_received_total", help: "Complete media frames out of reassembly")
+    private var totalBytesReceived: UInt64 { bytesReceived.value }
+    private var framesReceived: UInt64 { framesReassembled.value }
     private var lastStatsTime: CFTimeInterval = 0
+    private let nackCounter = metrics.counter("ndibridge_join_nacks_sent_total", help: "NACK messages sent to the Host")
+    private let retransmitCounter = metrics.counter("ndibridge_join_retransmits_received_total", help: "Retransmitted packets received")
+    private var nacksSent: UInt64 { nackCounter.value }
+    private var retransmitsReceived: UInt64 { retransmitCounter.value }
 
     private var listenPort: UInt16
-
-    init(port: UInt16 = 5990) {
+    private let multicastGroup: String?
+    let layer: UInt8  // Simulcast rendition this receiver takes
+    private var foreignLayerSince: CFTimeInterval = 0  // First packet of another rendition
+    private var warnedForeignLayer = false
+
+    /// - Parameters:
+    ///   - nackHoldMs: how long an incomplete frame is held while its lost
+    ///     fragments are re-requested from the Host (0 = retransmission off)
+    ///   - capabilities: optional stream features advertised to the Host
+    ///   - reportIntervalMs: how often loss/jitter statistics go back to the Host (0 = never)
+    ///   - multicastGroup: group address to join instead of accepting a unicast stream
+    ///   - layer: simulcast rendition asked from the Host with each hello
+    init(port: UInt16 = 5990, nackHoldMs: Int = 0, capabilities: ReceiverCapabilities = [], reportIntervalMs: Int = 0,
+         multicastGroup: String? = nil, layer: UInt8 = 0) {
         self.listenPort = port
+        self.multicastGroup = multicastGroup
+        self.layer = layer
+        self.capabilities = capabilities
+        self.reportInterval = CFTimeInterval(max(0, reportIntervalMs)) / 1000
+        self.nackHoldTime = CFTimeInterval(max(0, nackHoldMs)) / 1000
+        self.nackInterval = max(0.01, nackHoldTime / Double(nackMaxAttempts))
         logger.info("NetworkReceiver initializing on port \(port)...", subsystem: .network)
     }
 
@@ -167,6 +703,12 @@ final class NetworkReceiver {
             throw NSError(domain: "NetworkReceiver", code: -1, userInfo: [NSLocalizedDescriptionKey: "Invalid port"])
         }
 
+        if let group = multicastGroup {
+            try joinMulticastGroup(group, port: nwPort, parameters: parameters)
+            isListening = true
+            return
+        }
+
         listener = try NWListener(using: parameters, on: nwPort)
 
         listener?.stateUpdateHandler = { [weak self] state in
@@ -190,12 +732,29 @@ final class NetworkReceiver {
         connection?.cancel()
         connection = nil
 
+        connectionGroup?.cancel()
+        connectionGroup = nil
+
         listener?.cancel()
         listener = nil
 
         isListening = false
 
         logger.success("Receiver stopped. Total received: \(formatBytes(totalBytesReceived)), Frames: \(framesReceived)", subsystem: .network)
+        if sources.count > 1 {
+            logger.info("Sources received: \(sources.count)", subsystem: .network)
+        }
+        let droppedFrames = sources.values.reduce(UInt64(0)) { $0 + $1.video.droppedFrames }
+        if droppedFrames > 0 {
+            logger.info("Incomplete video frames dropped: \(droppedFrames)", subsystem: .network)
+        }
+        let recoveredFragments = sources.values.reduce(UInt64(0)) { $0 + $1.video.recoveredFragments }
+        if recoveredFragments > 0 {
+            logger.info("FEC recovered \(recoveredFragments) fragment(s)", subsystem: .network)
+        }
+        if nacksSent > 0 {
+            logger.info("NACKs sent: \(nacksSent), retransmitted packets received: \(retransmitsReceived)", subsystem: .network)
+        }
     }
 
     private func handleListenerState(_ state: NWListener.State) {
@@ -221,6 +780,41 @@ final class NetworkReceiver {
         }
     }
 
+    /// Media packets come from the group; hellos, NACKs and reports go back in unicast to
+    /// the packets' source (the Host control port), over a connection opened on the first
+    /// packet that also brings back retransmissions and clock replies
+    private func joinMulticastGroup(_ address: String, port: NWEndpoint.Port, parameters: NWParameters) throws {
+        let descriptor = try NWMulticastGroup(for: [.hostPort(host: NWEndpoint.Host(address), port: port)])
+        let group = NWConnectionGroup(with: descriptor, using: parameters)
+
+        group.stateUpdateHandler = { state in
+            switch state {
+            case .ready:
+                logger.success("Joined multicast group \(address) on UDP port \(port)", subsystem: .network)
+            case .failed(let error):
+                logger.error("Multicast group failed: \(error.localizedDescription)", subsystem: .network)
+            case .waiting(let error):
+                logger.warning("Multicast group waiting: \(error.localizedDescription)", subsystem: .network)
+            default:
+                break
+            }
+        }
+
+        group.setReceiveHandler(maximumMessageSize: 65_535, rejectOversizedMessages: true) { [weak self] message, content, _ in
+            guard let self = self else { return }
+            if let source = message.remoteEndpoint, source != self.connection?.endpoint {
+                logger.info("Multicast stream from \(source)", subsystem: .network)
+                self.handleNewConnection(NWConnection(to: source, using: .udp))
+            }
+            if let data = content {
+                self.processPacket(data)
+            }
+        }
+
+        group.start(queue: queue)
+        connectionGroup = group
+    }
+
     private func handleNewConnection(_ newConnection: NWConnection) {
         logger.info("New connection from: \(newConnection.endpoint)", subsystem: .network)
 
@@ -232,6 +826,7 @@ final class NetworkReceiver {
             switch state {
             case .ready:
                 logger.success("Connection ready", subsystem: .network)
+                self?.sendHelloIfDue()
                 self?.receivePacket()
 
             case .failed(let error):
@@ -270,8 +865,8 @@ final class NetworkReceiver {
     }
 
     private func processPacket(_ data: Data) {
-        totalPacketsReceived += 1
-        totalBytesReceived += UInt64(data.count)
+        packetsReceived.add()
+        bytesReceived.add(UInt64(data.count))
 
         // Minimum header size for version detection
         guard data.count >= 6 else {
@@ -279,9 +874,17 @@ final class NetworkReceiver {
             return
         }
 
+        // Clock probe replies are the only control messages coming this way
+        if ControlMessage.isControlPacket(data) {
+            if case .clockReply(let origin, let received, let transmitted)? = ControlMessage(data: data) {
+                clock.add(origin: origin, received: received, transmitted: transmitted, arrival: StageClock.now())
+            }
+            return
+        }
+
         // Read magic and version
         var offset = 0
-        let magic = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+        let magic = data.readBigEndian(UInt32.self, at: offset)
         offset += 4
 
         guard magic == 0x4E444942 else {  // "NDIB"
@@ -309,32 +912,93 @@ final class NetworkReceiver {
             offset += 1
             header.flags = data[offset]
             offset += 1
-            header.sequenceNumber = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+            header.sequenceNumber = data.readBigEndian(UInt32.self, at: offset)
             offset += 4
-            header.timestamp = data.subdata(in: offset..<(offset + 8)).withUnsafeBytes { $0.load(as: UInt64.self).bigEndian }
+            header.timestamp = data.readBigEndian(UInt64.self, at: offset)
             offset += 8
-            header.totalSize = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+            header.totalSize = data.readBigEndian(UInt32.self, at: offset)
             offset += 4
-            header.fragmentIndex = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.fragmentIndex = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
-            header.fragmentCount = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.fragmentCount = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
-            header.payloadSize = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.payloadSize = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
-            header.sampleRate = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+            header.sampleRate = data.readBigEndian(UInt32.self, at: offset)
             offset += 4
             header.channels = data[offset]
             offset += 1
-            offset += 3  // Skip reserved bytes (offset now = 38)
+            header.fecGroupSize = data[offset]
+            offset += 1
+            header.codec = data[offset]
+            offset += 1
+            header.layer = data[offset]
+            offset += 1  // offset now = 38
+
+            let payload = data[offset..<data.count]  // Slice - copied once into the frame buffer
+
+            sendHelloIfDue()
+
+            // Another rendition: the Host has not seen our subscription yet, or a multicast
+            // group carries it. Its sequence numbers would corrupt our reassembly
+            if !header.isAudio && header.layer != layer {
+                let now = CACurrentMediaTime()
+                if foreignLayerSince == 0 {
+                    foreignLayerSince = now
+                } else if !warnedForeignLayer && now - foreignLayerSince > 3 {
+                    warnedForeignLayer = true
+                    logger.warning("Still receiving layer \(header.layer) instead of \(layer) - the Host may have no such rendition (multicast groups carry layer 0)", subsystem: .network)
+                }
+                return
+            }
 
-            let payload = data.subdata(in: offset..<data.count)
+            if header.isParameterSets {
+                if let parameterSets = VideoParameterSets.parse(payload),
+                   let codec = VideoCodec(rawValue: header.codec) {
+                    stream(for: header.sourceId).parameterSetSequence = header.sequenceNumber
+                    delegate?.networkReceiver(self, didReceiveParameterSets: parameterSets, codec: codec, sourceId: header.sourceId)
+                }
+                return
+            }
 
-            // Use appropriate reassembler based on media type
-            let reassembler = header.mediaType == 0 ? videoReassembler : audioReassembler
+            if header.isTiming {
+                if let timing = HostFrameTiming(payload: payload) {
+                    delegate?.networkReceiver(self, didReceiveTiming: timing, timestamp: header.timestamp, sourceId: header.sourceId)
+                }
+                return
+            }
+
+            if header.isRetransmit {
+                retransmitCounter.add()
+            }
+
+            // Use appropriate reassembler based on source and media type
+            let sourceStream = stream(for: header.sourceId)
+            let reassembler = header.mediaType == 0 ? sourceStream.video : sourceStream.audio
+            sourceStream.bytesReceived += UInt64(data.count)
+            if header.isVideo && header.isKeyframe && header.isAVCC && nackHoldTime > 0 {
+                requestParameterSetsIfMissing(sourceStream, header: header)
+            }
+            if header.isVideo && header.fragmentIndex == 0 && !header.isParity && !header.isRetransmit {
+                sourceStream.updateJitter(timestamp: header.timestamp, arrival: CACurrentMediaTime())
+            }
+            let droppedBefore = reassembler.droppedFrames
 
             // Try to reassemble frame
-            if let frame = reassembler.addFragment(header: header, payload: payload) {
-                framesReceived += 1
+            let frames = reassembler.addFragment(header: header, payload: payload)
+
+            if header.isVideo && reassembler.droppedFrames > droppedBefore {
+                sendKeyframeRequest(sourceId: header.sourceId)
+            }
+            if nackHoldTime > 0 {
+                sendNacks()
+            }
+            if reportInterval > 0 {
+                sendReportsIfDue()
+            }
+
+            for frame in frames {
+                framesReassembled.add()
 
                 // Log periodically
                 let now = CACurrentMediaTime()
@@ -346,21 +1010,9 @@ final class NetworkReceiver {
                 // Route to appropriate delegate method based on media type
                 if frame.mediaType == 0 {
                     // Video frame
-                    delegate?.networkReceiver(
-                        self,
-                        didReceiveVideoFrame: frame.data,
-                        isKeyframe: frame.isKeyframe,
-                        timestamp: frame.timestamp
-                    )
+                    delegate?.networkReceiver(self, didReceiveVideoFrame: frame)
                 } else {
-                    // Audio frame
-                    delegate?.networkReceiver(
-                        self,
-                        didReceiveAudioFrame: frame.data,
-                        timestamp: frame.timestamp,
-                        sampleRate: Int32(frame.sampleRate),
-                        channels: Int32(frame.channels)
-                    )
+                    deliverAudio(frame)
                 }
             }
         } else {
@@ -374,24 +1026,24 @@ final class NetworkReceiver {
             offset += 1
             header.mediaType = 0  // Video only in v1
             header.flags = packetType  // In v1, packetType 1 = keyframe
-            header.sequenceNumber = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+            header.sequenceNumber = data.readBigEndian(UInt32.self, at: offset)
             offset += 4
-            header.timestamp = data.subdata(in: offset..<(offset + 8)).withUnsafeBytes { $0.load(as: UInt64.self).bigEndian }
+            header.timestamp = data.readBigEndian(UInt64.self, at: offset)
             offset += 8
-            header.totalSize = data.subdata(in: offset..<(offset + 4)).withUnsafeBytes { $0.load(as: UInt32.self).bigEndian }
+            header.totalSize = data.readBigEndian(UInt32.self, at: offset)
             offset += 4
-            header.fragmentIndex = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.fragmentIndex = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
-            header.fragmentCount = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.fragmentCount = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
-            header.payloadSize = data.subdata(in: offset..<(offset + 2)).withUnsafeBytes { $0.load(as: UInt16.self).bigEndian }
+            header.payloadSize = data.readBigEndian(UInt16.self, at: offset)
             offset += 2
 
-            let payload = data.subdata(in: 28..<data.count)
+            let payload = data[28..<data.count]
 
             // Try to reassemble frame (v1 is video only)
-            if let frame = videoReassembler.addFragment(header: header, payload: payload) {
-                framesReceived += 1
+            for frame in stream(for: 0).video.addFragment(header: header, payload: payload) {
+                framesReassembled.add()
 
                 let now = CACurrentMediaTime()
                 if now - lastStatsTime >= 1.0 {
@@ -400,16 +1052,171 @@ final class NetworkReceiver {
                 }
 
                 // Video frame (v1 is video only)
-                delegate?.networkReceiver(
-                    self,
-                    didReceiveVideoFrame: frame.data,
-                    isKeyframe: frame.isKeyframe,
-                    timestamp: frame.timestamp
-                )
+                delegate?.networkReceiver(self, didReceiveVideoFrame: frame)
+            }
+        }
+    }
+
+    private func stream(for sourceId: UInt8) -> SourceStream {
+        if let existing = sources[sourceId] {
+            return existing
+        }
+        let created = SourceStream(maxHoldTime: max(nackHoldTime, FrameReassembler.reorderHoldTime))
+        sources[sourceId] = created
+        registerMetrics(of: created, sourceId: sourceId)
+        if sources.count > 1 {
+            logger.info("New source on this stream: \(sourceId) (\(sources.count) total)", subsystem: .network)
+        }
+        return created
+    }
+
+    /// Reassembly statistics of a source, read on the receiver queue at scrape time
+    private func registerMetrics(of stream: SourceStream, sourceId: UInt8) {
+        let labels = ["source": String(sourceId)]
+        let series: [(String, String, MetricsRegistry.Kind, (SourceStream) -> Double)] = [
+            ("ndibridge_join_packets_expected_total", "Packets the Host sent for the frames seen", .counter,
+             { Double($0.video.packetsExpected + $0.audio.packetsExpected) }),
+            ("ndibridge_join_packets_first_received_total", "First-transmission packets received (expected minus this = path loss)", .counter,
+             { Double($0.video.packetsReceived + $0.audio.packetsReceived) }),
+            ("ndibridge_join_frames_dropped_total", "Incomplete video frames abandoned", .counter,
+             { Double($0.video.droppedFrames) }),
+            ("ndibridge_join_fec_recovered_total", "Fragments rebuilt from FEC parity", .counter,
+             { Double($0.video.recoveredFragments) }),
+            ("ndibridge_join_jitter_seconds", "RFC 3550 inter-arrival jitter of video frames", .gauge,
+             { $0.jitter })
+        ]
+
+        for (name, help, kind, read) in series {
+            metrics.register(name, help: help, kind: kind, labels: labels) { [weak self, weak stream] in
+                guard let self = self, let stream = stream else { return nil }
+                return self.queue.sync { read(stream) }
+            }
+        }
+    }
+
+    /// Ask the Host to resend fragments still missing from held frames
+    private func sendNacks() {
+        let now = CACurrentMediaTime()
+        guard now - lastNackScan >= 0.005, let conn = connection else { return }
+        lastNackScan = now
+
+        for (sourceId, streams) in sources {
+            for (mediaType, reassembler) in [(MediaType.video, streams.video), (MediaType.audio, streams.audio)] {
+                let ranges = reassembler.collectNacks(now: now, interval: nackInterval, maxAttempts: nackMaxAttempts)
+                guard !ranges.isEmpty else { continue }
+
+                let message = ControlMessage.nack(mediaType: mediaType.rawValue, sourceId: sourceId, ranges: ranges)
+                conn.send(content: message.toData(), completion: .idempotent)
+                nackCounter.add()
             }
         }
     }
 
+    /// An AVCC keyframe arrived without the parameter sets the Host sends in front of it:
+    /// NACK them once, or a changed SPS/PPS would leave the decoder on the old format
+    private func requestParameterSetsIfMissing(_ stream: SourceStream, header: ParsedMediaHeader) {
+        let sequence = header.sequenceNumber
+        guard stream.parameterSetSequence != sequence, stream.parameterSetNack != sequence,
+              let conn = connection else { return }
+        stream.parameterSetNack = sequence
+
+        let range = NackRange(sequenceNumber: sequence, firstFragment: 0, fragmentCount: 1)
+        let message = ControlMessage.nack(mediaType: MediaType.parameterSets.rawValue, sourceId: header.sourceId, ranges: [range])
+        conn.send(content: message.toData(), completion: .idempotent)
+        nackCounter.add()
+    }
+
+    /// Send each source's loss and jitter statistics once per report interval
+    private func sendReportsIfDue() {
+        let now = CACurrentMediaTime()
+        guard now - lastReportScan >= 0.05, let conn = connection else { return }
+        lastReportScan = now
+
+        for (sourceId, stream) in sources {
+            if stream.lastReportTime == 0 {
+                stream.lastReportTime = now  // First report covers a full interval
+                continue
+            }
+            guard now - stream.lastReportTime >= reportInterval else { continue }
+
+            let report = stream.makeReport(sourceId: sourceId, now: now)
+            conn.send(content: ControlMessage.receiverReport(report).toData(), completion: .idempotent)
+        }
+    }
+
+    /// Ask the Host for a keyframe, e.g. when the decoder has no parameter sets yet
+    func requestKeyframe(sourceId: UInt8 = 0) {
+        queue.async { [weak self] in
+            self?.sendKeyframeRequest(sourceId: sourceId)
+        }
+    }
+
+    /// Hand an audio frame on as contiguous planar float, converting int16 wire audio.
+    /// Compressed frames go to the delegate as-is: decoding needs per-source state
+    private func deliverAudio(_ frame: ReassembledFrame) {
+        let channels = Int(frame.channels)
+        guard channels > 0 else { return }
+
+        guard let codec = frame.audioCodec else {
+            logger.debug("Audio frame with unknown codec dropped (source \(frame.sourceId))", subsystem: .network)
+            return
+        }
+        guard codec == .pcm else {
+            delegate?.networkReceiver(
+                self,
+                didReceiveEncodedAudio: frame.data,
+                codec: codec,
+                timestamp: frame.timestamp,
+                sampleRate: Int32(frame.sampleRate),
+                channels: Int32(channels),
+                sourceId: frame.sourceId
+            )
+            return
+        }
+
+        let format: AudioWireFormat = frame.isPCM16 ? .int16Interleaved : .float32Planar
+        let samples = frame.data.count / (channels * format.bytesPerSample)
+        let planar = frame.isPCM16
+            ? PCMConverter.planarFloat(fromInterleavedInt16: frame.data, channels: channels)
+            : frame.data
+        guard samples > 0 else { return }
+
+        delegate?.networkReceiver(
+            self,
+            didReceiveAudioFrame: planar,
+            timestamp: frame.timestamp,
+            sampleRate: Int32(frame.sampleRate),
+            channels: Int32(channels),
+            samplesPerChannel: Int32(samples),
+            sourceId: frame.sourceId
+        )
+    }
+
+    /// Advertise our capabilities; only receivers that do so get optional stream formats
+    private func sendHelloIfDue() {
+        let now = CACurrentMediaTime()
+        guard !capabilities.isEmpty, now - lastHelloTime >= helloInterval, let conn = connection else { return }
+        lastHelloTime = now
+
+        conn.send(content: ControlMessage.capabilities(capabilities).toData(), completion: .idempotent)
+        if layer > 0 {
+            conn.send(content: ControlMessage.subscribe(layer: layer).toData(), completion: .idempotent)
+        }
+        if capabilities.contains(.timing) {
+            conn.send(content: ControlMessage.clockProbe(origin: StageClock.now()).toData(), completion: .idempotent)
+        }
+    }
+
+    /// A video frame could not be completed - the decoder needs a fresh IDR
+    private func sendKeyframeRequest(sourceId: UInt8) {
+        let now = CACurrentMediaTime()
+        guard now - (lastKeyframeRequest[sourceId] ?? 0) >= keyframeRequestInterval, let conn = connection else { return }
+        lastKeyframeRequest[sourceId] = now
+
+        conn.send(content: ControlMessage.keyframeRequest(sourceId: sourceId).toData(), completion: .idempotent)
+        logger.debug("Keyframe requested from sender (source \(sourceId))", subsystem: .network)
+    }
+
     private func formatBytes(_ bytes: UInt64) -> String {
         if bytes < 1024 {
             return "\(bytes) B"
@@ -420,3 +1227,10 @@ final class NetworkReceiver {
         }
     }
 }
+
+private extension Data {
+    /// Read a big-endian integer at `offset` without an intermediate copy
+    func readBigEndian<T: FixedWidthInteger>(_ type: T.Type, at offset: Int) -> T {
+        return withUnsafeBytes { T(bigEndian: $0.loadUnaligned(fromByteOffset: offset, as: T.self)) }
+    }
+}
@@ -0,0 +1,281 @@
+//
+//  PixelConverter.swift
+//  NDI Bridge Mac
+//
+//  NV12 → UYVY conversion (and optional scaling) of decoded frames for NDI output
+//
+
+import Foundation
+import CoreVideo
+import Metal
+
+/// Converts decoder output (NV12 video range) to the UYVY frames NDI sends natively,
+/// optionally scaled to a fixed output size.
+/// The Metal path maps the IOSurface-backed decoder and output buffers as textures
+/// through a `CVMetalTextureCache` - no copy on either side - and runs one compute
+/// thread per output pixel pair with bilinear sampling. Without a Metal device, or if
+/// a GPU pass fails, the same conversion runs on the CPU (nearest-neighbour scaling)
+final class PixelConverter {
+    enum Backend: String {
+        case metal
+        case cpu
+    }
+
+    private(set) var backend: Backend
+    private let targetWidth: Int?   // nil = source size
+    private let targetHeight: Int?
+    private let minimumBufferCount: Int  // Output pool size and allocation cap (0 = unbounded)
+
+    // Metal
+    private var commandQueue: MTLCommandQueue?
+    private var pipelineState: MTLComputePipelineState?
+    private var textureCache: CVMetalTextureCache?
+    private var warnedGPUFailure = false
+
+    // Output buffers, recycled through NDI send (or held by the delay buffer)
+    private var pool: CVPixelBufferPool?
+    private var poolSize = (width: 0, height: 0)
+
+    /// Frames dropped because `minimumBufferCount` output buffers were all in use
+    private(set) var poolExhaustedDrops: UInt64 = 0
+
+    // CPU path: source column of each output column, for the current sizes
+    private var columnMap: [Int] = []
+    private var columnMapKey = (source: 0, output: 0)
+
+    /// - Parameter minimumBufferCount: output buffers allocated up front, and the most
+    ///   ever outstanding; the delay buffer sizes it to its depth plus the frames in flight
+    init(targetWidth: Int? = nil, targetHeight: Int? = nil, minimumBufferCount: Int = 0, preferMetal: Bool = true) {
+        self.targetWidth = targetWidth.map { max(2, $0 & ~1) }  // UYVY pairs: even width
+        self.targetHeight = targetHeight.map { max(1, $0) }
+        self.minimumBufferCount = max(0, minimumBufferCount)
+        self.backend = .cpu
+
+        if preferMetal {
+            setUpMetal()
+        }
+        let scaling = self.targetWidth.map { " scaled to \($0)x\(self.targetHeight ?? 0)" } ?? ""
+        logger.info("Pixel converter: NV12 → UYVY on \(backend.rawValue.uppercased())\(scaling)", subsystem: .video)
+    }
+
+    /// UYVY copy of an NV12 frame, or the frame itself when it is not NV12.
+    /// Nil only when no output buffer could be allocated
+    func convert(_ source: CVPixelBuffer) -> CVPixelBuffer? {
+        guard CVPixelBufferGetPixelFormatType(source) == kCVPixelFormatType_420YpCbCr8BiPlanarVideoRange else {
+            return source
+        }
+
+        let width = targetWidth ?? (CVPixelBufferGetWidth(source) & ~1)
+        let height = targetHeight ?? CVPixelBufferGetHeight(source)
+        guard let output = makeOutputBuffer(width: width, height: height) else { return nil }
+
+        if backend == .metal {
+            if convertOnGPU(source, into: output) {
+                return output
+            }
+            if !warnedGPUFailure {
+                warnedGPUFailure = true
+                logger.warning("Metal conversion failed - using the CPU for this frame", subsystem: .video)
+            }
+        }
+        convertOnCPU(source, into: output)
+        return output
+    }
+
+    // MARK: - Metal
+
+    /// One thread per output pixel pair: U Y0 V Y1 written as one RGBA8 texel.
+    /// Chroma is sampled at the centre of the pair (4:2:2 co-siting of the output)
+    private static let shaderSource = """
+    #include <metal_stdlib>
+    using namespace metal;
+
+    kernel void nv12ToUYVY(texture2d<float, access::sample> luma [[texture(0)]],
+                           texture2d<float, access::sample> chroma [[texture(1)]],
+                           texture2d<float, access::write> output [[texture(2)]],
+                           uint2 gid [[thread_position_in_grid]])
+    {
+        if (gid.x >= output.get_width() || gid.y >= output.get_height()) {
+            return;
+        }
+        constexpr sampler bilinear(coord::normalized, address::clamp_to_edge, filter::linear);
+        float width = float(output.get_width() * 2);
+        float y = (float(gid.y) + 0.5) / float(output.get_height());
+        float x0 = (float(gid.x * 2) + 0.5) / width;
+        float x1 = (float(gid.x * 2 + 1) + 0.5) / width;
+        float2 cbcr = chroma.sample(bilinear, float2(float(gid.x * 2 + 1) / width, y)).rg;
+        output.write(float4(cbcr.r, luma.sample(bilinear, float2(x0, y)).r,
+                            cbcr.g, luma.sample(bilinear, float2(x1, y)).r), gid);
+    }
+    """
+
+    private func setUpMetal() {
+        guard let device = MTLCreateSystemDefaultDevice() else {
+            logger.warning("No Metal device - pixel conversion on the CPU", subsystem: .video)
+            return
+        }
+        do {
+            let library = try device.makeLibrary(source: PixelConverter.shaderSource, options: nil)
+            guard let function = library.makeFunction(name: "nv12ToUYVY"),
+                  let queue = device.makeCommandQueue() else {
+                logger.warning("Metal kernel unavailable - pixel conversion on the CPU", subsystem: .video)
+                return
+            }
+            var cache: CVMetalTextureCache?
+            guard CVMetalTextureCacheCreate(kCFAllocatorDefault, nil, device, nil, &cache) == kCVReturnSuccess else {
+                logger.warning("CVMetalTextureCacheCreate failed - pixel conversion on the CPU", subsystem: .video)
+                return
+            }
+            pipelineState = try device.makeComputePipelineState(function: function)
+            commandQueue = queue
+            textureCache = cache
+            backend = .metal
+        } catch {
+            logger.warning("Metal kernel build failed (\(error.localizedDescription)) - pixel conversion on the CPU", subsystem: .video)
+        }
+    }
+
+    private func convertOnGPU(_ source: CVPixelBuffer, into output: CVPixelBuffer) -> Bool {
+        guard let cache = textureCache, let queue = commandQueue, let pipeline = pipelineState,
+              let luma = texture(from: source, plane: 0, format: .r8Unorm, cache: cache),
+              let chroma = texture(from: source, plane: 1, format: .rg8Unorm, cache: cache),
+              let target = texture(from: output, plane: 0, format: .rgba8Unorm, cache: cache,
+                                   width: CVPixelBufferGetWidth(output) / 2),
+              let lumaTexture = CVMetalTextureGetTexture(luma),
+              let chromaTexture = CVMetalTextureGetTexture(chroma),
+              let targetTexture = CVMetalTextureGetTexture(target),
+              let commandBuffer = queue.makeCommandBuffer(),
+              let encoder = commandBuffer.makeComputeCommandEncoder() else {
+            return false
+        }
+
+        encoder.setComputePipelineState(pipeline)
+        encoder.setTexture(lumaTexture, index: 0)
+        encoder.setTexture(chromaTexture, index: 1)
+        encoder.setTexture(targetTexture, index: 2)
+        let threads = MTLSize(width: pipeline.threadExecutionWidth,
+                              height: max(1, pipeline.maxTotalThreadsPerThreadgroup / pipeline.threadExecutionWidth), depth: 1)
+        let groups = MTLSize(width: (targetTexture.width + threads.width - 1) / threads.width,
+                             height: (targetTexture.height + threads.height - 1) / threads.height, depth: 1)
+        encoder.dispatchThreadgroups(groups, threadsPerThreadgroup: threads)
+        encoder.endEncoding()
+
+        // The CVMetalTextures keep both IOSurfaces mapped until the GPU is done
+        commandBuffer.commit()
+        commandBuffer.waitUntilCompleted()
+        withExtendedLifetime((luma, chroma, target)) {}
+        return commandBuffer.status == .completed
+    }
+
+    private func texture(from buffer: CVPixelBuffer, plane: Int, format: MTLPixelFormat,
+                         cache: CVMetalTextureCache, width: Int? = nil) -> CVMetalTexture? {
+        let planar = CVPixelBufferIsPlanar(buffer)
+        let planeWidth = width ?? (planar ? CVPixelBufferGetWidthOfPlane(buffer, plane) : CVPixelBufferGetWidth(buffer))
+        let planeHeight = planar ? CVPixelBufferGetHeightOfPlane(buffer, plane) : CVPixelBufferGetHeight(buffer)
+        let attributes: [CFString: Any] = [
+            kCVMetalTextureUsage: MTLTextureUsage([.shaderRead, .shaderWrite]).rawValue
+        ]
+
+        var texture: CVMetalTexture?
+        let status = CVMetalTextureCacheCreateTextureFromImage(
+            kCFAllocatorDefault, cache, buffer, attributes as CFDictionary,
+            format, planeWidth, planeHeight, plane, &texture
+        )
+        return status == kCVReturnSuccess ? texture : nil
+    }
+
+    // MARK: - CPU fallback
+
+    private func convertOnCPU(_ source: CVPixelBuffer, into output: CVPixelBuffer) {
+        CVPixelBufferLockBaseAddress(source, .readOnly)
+        CVPixelBufferLockBaseAddress(output, [])
+        defer {
+            CVPixelBufferUnlockBaseAddress(source, .readOnly)
+            CVPixelBufferUnlockBaseAddress(output, [])
+        }
+
+        guard let lumaBase = CVPixelBufferGetBaseAddressOfPlane(source, 0),
+              let chromaBase = CVPixelBufferGetBaseAddressOfPlane(source, 1),
+              let outputBase = CVPixelBufferGetBaseAddress(output) else {
+            return
+        }
+
+        let sourceWidth = CVPixelBufferGetWidth(source)
+        let sourceHeight = CVPixelBufferGetHeight(source)
+        let width = CVPixelBufferGetWidth(output)
+        let height = CVPixelBufferGetHeight(output)
+        let lumaStride = CVPixelBufferGetBytesPerRowOfPlane(source, 0)
+        let chromaStride = CVPixelBufferGetBytesPerRowOfPlane(source, 1)
+        let outputStride = CVPixelBufferGetBytesPerRow(output)
+
+        if columnMapKey.source != sourceWidth || columnMapKey.output != width {
+            columnMap = (0..<width).map { $0 * sourceWidth / width }
+            columnMapKey = (sourceWidth, width)
+        }
+
+        let luma = lumaBase.assumingMemoryBound(to: UInt8.self)
+        let chroma = chromaBase.assumingMemoryBound(to: UInt8.self)
+        let out = outputBase.assumingMemoryBound(to: UInt8.self)
+
+        columnMap.withUnsafeBufferPointer { columns in
+            for row in 0..<height {
+                let sourceRow = row * sourceHeight / height
+                let lumaRow = luma + sourceRow * lumaStride
+                let chromaRow = chroma + (sourceRow / 2) * chromaStride
+                let outRow = out + row * outputStride
+                for pair in 0..<(width / 2) {
+                    let x0 = columns[pair * 2], x1 = columns[pair * 2 + 1]
+                    let cx = x0 & ~1
+                    outRow[pair * 4] = chromaRow[cx]
+                    outRow[pair * 4 + 1] = lumaRow[x0]
+                    outRow[pair * 4 + 2] = chromaRow[cx + 1]
+                    outRow[pair * 4 + 3] = lumaRow[x1]
+                }
+            }
+        }
+    }
+
+    // MARK: - Private Helpers
+
+    /// IOSurface, Metal-compatible UYVY buffer from a pool recreated on size change.
+    /// With `minimumBufferCount` the pool is pre-sized and its allocation threshold caps
+    /// the memory: nil once that many buffers are outstanding
+    private func makeOutputBuffer(width: Int, height: Int) -> CVPixelBuffer? {
+        if pool == nil || poolSize.width != width || poolSize.height != height {
+            let attributes: [CFString: Any] = [
+                kCVPixelBufferWidthKey: width,
+                kCVPixelBufferHeightKey: height,
+                kCVPixelBufferPixelFormatTypeKey: kCVPixelFormatType_422YpCbCr8,
+                kCVPixelBufferIOSurfacePropertiesKey: [:] as CFDictionary,
+                kCVPixelBufferMetalCompatibilityKey: true
+            ]
+            let poolAttributes: [CFString: Any] = minimumBufferCount > 0
+                ? [kCVPixelBufferPoolMinimumBufferCountKey: minimumBufferCount]
+                : [:]
+            var newPool: CVPixelBufferPool?
+            guard CVPixelBufferPoolCreate(kCFAllocatorDefault, poolAttributes as CFDictionary, attributes as CFDictionary, &newPool) == kCVReturnSuccess else {
+                logger.error("UYVY output pool creation failed (\(width)x\(height))", subsystem: .video)
+                return nil
+            }
+            pool = newPool
+            poolSize = (width, height)
+            if minimumBufferCount > 0 {
+                logger.debug("UYVY output pool: \(minimumBufferCount) x \(width)x\(height)", subsystem: .video)
+            }
+        }
+
+        guard let pool = pool else { return nil }
+        var buffer: CVPixelBuffer?
+        let auxAttributes: [CFString: Any] = minimumBufferCount > 0
+            ? [kCVPixelBufferPoolAllocationThresholdKey: minimumBufferCount]
+            : [:]
+        let status = CVPixelBufferPoolCreatePixelBufferWithAuxAttributes(kCFAllocatorDefault, pool, auxAttributes as CFDictionary, &buffer)
+        guard status == kCVReturnSuccess else {
+            if status == kCVReturnWouldExceedAllocationThreshold {
+                poolExhaustedDrops += 1
+            }
+            return nil
+        }
+        return buffer
+    }
+}
@@ -2,7 +2,7 @@
 //  VideoDecoder.swift
 //  NDI Bridge Mac
 //
-//  Hardware H.264 decoding using VideoToolbox
+//  Hardware H.264/HEVC decoding using VideoToolbox
 //
 
 import Foundation
@@ -41,7 +41,7 @@ enum VideoDecoderError: Error, LocalizedError {
     }
 }
 
-/// Hardware H.264 decoder using VideoToolbox
+/// Hardware H.264/HEVC decoder using VideoToolbox
 final class VideoDecoder {
     weak var delegate: VideoDecoderDelegate?
 
@@ -49,7 +49,18 @@ final class VideoDecoder {
     private var formatDescription: CMVideoFormatDescription?
     private var isConfigured = false
 
-    // Parameter sets (SPS/PPS)
+    /// Minimum size of the output pixel buffer pool, so downstream code can hold on to
+    /// decoded frames without starving the decoder (0 = VideoToolbox default).
+    /// Applies to sessions created after it is set
+    var minimumBufferCount: Int = 0
+
+    /// Pixel format of decoded frames: BGRA, or NV12 (the decoder's native output) when a
+    /// `PixelConverter` follows. Applies to sessions created after it is set
+    var outputPixelFormat: OSType = kCVPixelFormatType_32BGRA
+
+    // Parameter sets (SPS/PPS, plus VPS for HEVC) of the current codec
+    private var codec: VideoCodec = .h264
+    private var vps: Data?
     private var sps: Data?
     private var pps: Data?
 
@@ -66,118 +77,132 @@ final class VideoDecoder {
         logger.info("VideoDecoder deinitialized", subsystem: .video)
     }
 
-    /// Decode H.264 Annex-B data
-    func decode(data: Data, timestamp: UInt64) throws {
-        // Parse NAL units from Annex-B format
-        let nalUnits = parseNALUnits(from: data)
+    /// Decode one Annex-B access unit
+    /// The VCL NAL units are repacked length-prefixed into a single sample
+    func decode(data: Data, timestamp: UInt64, codec: VideoCodec = .h264) throws {
+        select(codec: codec)
 
-        for nal in nalUnits {
-            let nalType = nal[0] & 0x1F
+        // NAL units are slices of `data` - no copy until the AVCC repacking
+        var slices: [Data] = []
+        var sampleSize = 0
 
-            switch nalType {
-            case 7:  // SPS
-                sps = nal
+        for range in AnnexB.nalUnitRanges(in: data) {
+            let nal = data[range]
+
+            switch codec.nalKind(nal[nal.startIndex]) {
+            case .vps:
+                vps = Data(nal)  // Own copy so the access unit is not kept alive
+                logger.debug("Received VPS (\(nal.count) bytes)", subsystem: .video)
+                try updateFormatDescription()
+
+            case .sps:
+                sps = Data(nal)
                 logger.debug("Received SPS (\(nal.count) bytes)", subsystem: .video)
                 try updateFormatDescription()
 
-            case 8:  // PPS
-                pps = nal
+            case .pps:
+                pps = Data(nal)
                 logger.debug("Received PPS (\(nal.count) bytes)", subsystem: .video)
                 try updateFormatDescription()
 
-            case 5:  // IDR (keyframe)
-                try decodeNALUnit(nal, timestamp: timestamp)
-
-            case 1:  // Non-IDR (P-frame)
-                try decodeNALUnit(nal, timestamp: timestamp)
+            case .slice:
+                slices.append(nal)
+                sampleSize += 4 + nal.count
 
-            default:
-                logger.debug("Skipping NAL type \(nalType)", subsystem: .video)
+            case .other:
+                logger.debug("Skipping NAL type \(codec.nalType(nal[nal.startIndex]))", subsystem: .video)
             }
         }
+
+        guard !slices.isEmpty else { return }
+
+        var avccData = Data(capacity: sampleSize)
+        for nal in slices {
+            withUnsafeBytes(of: UInt32(nal.count).bigEndian) { avccData.append(contentsOf: $0) }
+            avccData.append(nal)
+        }
+        try decodeSample(avccData, timestamp: timestamp)
     }
 
-    /// Parse Annex-B NAL units (separated by 0x00 0x00 0x00 0x01 or 0x00 0x00 0x01)
-    private func parseNALUnits(from data: Data) -> [Data] {
-        var nalUnits: [Data] = []
-        var startIndex = 0
-        let bytes = [UInt8](data)
-
-        var i = 0
-        while i < bytes.count - 3 {
-            // Check for start code (0x00 0x00 0x01 or 0x00 0x00 0x00 0x01)
-            if bytes[i] == 0x00 && bytes[i + 1] == 0x00 {
-                var startCodeLength = 0
-
-                if bytes[i + 2] == 0x01 {
-                    startCodeLength = 3
-                } else if i < bytes.count - 3 && bytes[i + 2] == 0x00 && bytes[i + 3] == 0x01 {
-                    startCodeLength = 4
-                }
-
-                if startCodeLength > 0 {
-                    // Save previous NAL unit (if any)
-                    if startIndex > 0 || i > 0 {
-                        if startIndex < i {
-                            let nalData = data.subdata(in: startIndex..<i)
-                            if !nalData.isEmpty {
-                                nalUnits.append(nalData)
-                            }
-                        }
-                    }
-
-                    // Move past start code
-                    i += startCodeLength
-                    startIndex = i
-                    continue
-                }
-            }
-            i += 1
+    /// Decode one access unit already in AVCC form (4-byte length-prefixed NAL units)
+    /// The bytes are wrapped into the sample buffer as-is, without scanning or copying
+    func decode(avcc data: Data, timestamp: UInt64, codec: VideoCodec = .h264) throws {
+        select(codec: codec)
+        guard isConfigured else {
+            throw VideoDecoderError.noParameterSets
         }
+        try decodeSample(data, timestamp: timestamp)
+    }
 
-        // Add last NAL unit
-        if startIndex < data.count {
-            let nalData = data.subdata(in: startIndex..<data.count)
-            if !nalData.isEmpty {
-                nalUnits.append(nalData)
+    /// Install parameter sets received out-of-band (AVCC streams)
+    func setParameterSets(_ parameterSets: [Data], codec: VideoCodec = .h264) throws {
+        select(codec: codec)
+        for set in parameterSets where !set.isEmpty {
+            switch codec.nalKind(set[set.startIndex]) {
+            case .vps: vps = set
+            case .sps: sps = set
+            case .pps: pps = set
+            default: break
             }
         }
+        try updateFormatDescription()
+    }
 
-        return nalUnits
+    /// Follow the codec signalled in the stream; a change drops the session and parameter sets
+    private func select(codec newCodec: VideoCodec) {
+        guard newCodec != codec else { return }
+        logger.info("Stream codec changed to \(newCodec.name)", subsystem: .video)
+        invalidate()
+        codec = newCodec
     }
 
-    /// Update format description when SPS/PPS are received
+    /// Update format description when the parameter sets are received
     private func updateFormatDescription() throws {
-        guard let sps = sps, let pps = pps else {
-            return  // Wait for both
+        let parameterSets: [Data]
+        switch codec {
+        case .h264:
+            guard let sps = sps, let pps = pps else { return }  // Wait for both
+            parameterSets = [sps, pps]
+        case .hevc:
+            guard let vps = vps, let sps = sps, let pps = pps else { return }  // Wait for all three
+            parameterSets = [vps, sps, pps]
         }
 
-        logger.info("Creating format description from SPS/PPS...", subsystem: .video)
+        logger.info("Creating \(codec.name) format description from parameter sets...", subsystem: .video)
 
-        // Create format description from parameter sets
-        let parameterSets: [Data] = [sps, pps]
-        let parameterSetPointers: [UnsafePointer<UInt8>] = parameterSets.map {
-            $0.withUnsafeBytes { $0.baseAddress!.assumingMemoryBound(to: UInt8.self) }
+        // One contiguous copy keeps every pointer valid for the duration of the call
+        var joined: [UInt8] = []
+        var offsets: [Int] = []
+        for set in parameterSets {
+            offsets.append(joined.count)
+            joined.append(contentsOf: set)
         }
-        let parameterSetSizes: [Int] = parameterSets.map { $0.count }
+        let sizes = parameterSets.map { $0.count }
 
         var newFormatDescription: CMVideoFormatDescription?
+        let codec = self.codec
 
-        // Need to keep data alive during call
-        let status = sps.withUnsafeBytes { spsPtr in
-            pps.withUnsafeBytes { ppsPtr in
-                let pointers: [UnsafePointer<UInt8>] = [
-                    spsPtr.baseAddress!.assumingMemoryBound(to: UInt8.self),
-                    ppsPtr.baseAddress!.assumingMemoryBound(to: UInt8.self)
-                ]
-                let sizes: [Int] = [sps.count, pps.count]
+        let status = joined.withUnsafeBufferPointer { (buffer: UnsafeBufferPointer<UInt8>) -> OSStatus in
+            let pointers = offsets.map { buffer.baseAddress! + $0 }
 
+            switch codec {
+            case .h264:
                 return CMVideoFormatDescriptionCreateFromH264ParameterSets(
                     allocator: kCFAllocatorDefault,
-                    parameterSetCount: 2,
+                    parameterSetCount: pointers.count,
+                    parameterSetPointers: pointers,
+                    parameterSetSizes: sizes,
+                    nalUnitHeaderLength: 4,
+                    formatDescriptionOut: &newFormatDescription
+                )
+            case .hevc:
+                return CMVideoFormatDescriptionCreateFromHEVCParameterSets(
+                    allocator: kCFAllocatorDefault,
+                    parameterSetCount: pointers.count,
                     parameterSetPointers: pointers,
                     parameterSetSizes: sizes,
                     nalUnitHeaderLength: 4,
+                    extensions: nil,
                     formatDescriptionOut: &newFormatDescription
                 )
             }
@@ -213,11 +238,14 @@ final class VideoDecoder {
         logger.info("Creating decompression session...", subsystem: .video)
 
         // Output pixel buffer attributes
-        let outputAttributes: [String: Any] = [
-            kCVPixelBufferPixelFormatTypeKey as String: kCVPixelFormatType_32BGRA,
+        var outputAttributes: [String: Any] = [
+            kCVPixelBufferPixelFormatTypeKey as String: outputPixelFormat,
             kCVPixelBufferIOSurfacePropertiesKey as String: [:],
             kCVPixelBufferMetalCompatibilityKey as String: true
         ]
+        if minimumBufferCount > 0 {
+            outputAttributes[kCVPixelBufferPoolMinimumBufferCountKey as String] = minimumBufferCount
+        }
 
         // Callback info
         var callbackRecord = VTDecompressionOutputCallbackRecord(
@@ -244,38 +272,47 @@ final class VideoDecoder {
         isConfigured = true
 
         logger.success("Decompression session created", subsystem: .video)
+        if minimumBufferCount > 0 {
+            logger.debug("Decoder pool: at least \(minimumBufferCount) buffers", subsystem: .video)
+        }
     }
 
-    /// Decode a single NAL unit
-    private func decodeNALUnit(_ nalUnit: Data, timestamp: UInt64) throws {
+    /// Decode one length-prefixed access unit
+    private func decodeSample(_ avccData: Data, timestamp: UInt64) throws {
         guard isConfigured, let session = decompressionSession else {
             logger.debug("Decoder not ready, skipping frame", subsystem: .video)
             return
         }
 
-        // Convert to AVCC format (prepend 4-byte length)
-        var avccData = Data(capacity: nalUnit.count + 4)
-        var length = UInt32(nalUnit.count).bigEndian
-        withUnsafeBytes(of: &length) { avccData.append(contentsOf: $0) }
-        avccData.append(nalUnit)
+        // Wrap the bytes in a CMBlockBuffer without copying; the block source keeps
+        // the storage alive until VideoToolbox releases the (asynchronous) sample
+        let storage = avccData as NSData
+        let refCon = Unmanaged.passRetained(storage).toOpaque()
+        var blockSource = CMBlockBufferCustomBlockSource(
+            version: kCMBlockBufferCustomBlockSourceVersion,
+            AllocateBlock: nil,
+            FreeBlock: { refCon, _, _ in
+                guard let refCon = refCon else { return }
+                Unmanaged<NSData>.fromOpaque(refCon).release()
+            },
+            refCon: refCon
+        )
 
-        // Create CMBlockBuffer
         var blockBuffer: CMBlockBuffer?
-        var status = avccData.withUnsafeBytes { (bytes: UnsafeRawBufferPointer) -> OSStatus in
-            CMBlockBufferCreateWithMemoryBlock(
-                allocator: kCFAllocatorDefault,
-                memoryBlock: UnsafeMutableRawPointer(mutating: bytes.baseAddress),
-                blockLength: avccData.count,
-                blockAllocator: kCFAllocatorNull,
-                customBlockSource: nil,
-                offsetToData: 0,
-                dataLength: avccData.count,
-                flags: 0,
-                blockBufferOut: &blockBuffer
-            )
-        }
+        var status = CMBlockBufferCreateWithMemoryBlock(
+            allocator: kCFAllocatorDefault,
+            memoryBlock: UnsafeMutableRawPointer(mutating: storage.bytes),
+            blockLength: storage.length,
+            blockAllocator: nil,
+            customBlockSource: &blockSource,
+            offsetToData: 0,
+            dataLength: storage.length,
+            flags: 0,
+            blockBufferOut: &blockBuffer
+        )
 
         guard status == kCMBlockBufferNoErr, let buffer = blockBuffer else {
+            Unmanaged<NSData>.fromOpaque(refCon).release()
             throw VideoDecoderError.decodingFailed(status)
         }
 
@@ -286,6 +323,7 @@ final class VideoDecoder {
             presentationTimeStamp: CMTime(value: CMTimeValue(timestamp), timescale: 10_000_000),
             decodeTimeStamp: .invalid
         )
+        var sampleSize = storage.length
 
         status = CMSampleBufferCreateReady(
             allocator: kCFAllocatorDefault,
@@ -294,8 +332,8 @@ final class VideoDecoder {
             sampleCount: 1,
             sampleTimingEntryCount: 1,
             sampleTimingArray: &timingInfo,
-            sampleSizeEntryCount: 0,
-            sampleSizeArray: nil,
+            sampleSizeEntryCount: 1,
+            sampleSizeArray: &sampleSize,
             sampleBufferOut: &sampleBuffer
         )
 
@@ -353,6 +391,7 @@ final class VideoDecoder {
         }
         formatDescription = nil
         isConfigured = false
+        vps = nil
         sps = nil
         pps = nil
         logger.debug("Decoder invalidated", subsystem: .video)
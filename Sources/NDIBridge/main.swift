@@ -29,6 +29,14 @@ struct NDIBridgeApp {
 
         let mode = arguments[1]
 
+        // Log levels apply to every mode
+        if let index = arguments.firstIndex(of: "--log-level"), index + 1 < arguments.count {
+            guard logger.configureLevels(arguments[index + 1]) else {
+                print("❌ Invalid log level: \(arguments[index + 1]) (use debug|info|success|warning|error|fatal, optionally per subsystem: network=warning,video=debug)")
+                exit(1)
+            }
+        }
+
         switch mode {
         case "host":
             startHostMode(arguments: arguments)
@@ -39,6 +47,9 @@ struct NDIBridgeApp {
         case "discover":
             discoverSources()
 
+        case "bench":
+            Benchmarks.run(arguments: arguments)
+
         case "--version", "-v":
             printVersion()
 
@@ -58,20 +69,40 @@ struct NDIBridgeApp {
 
         // Parse arguments
         var config = HostModeConfig()
+        var adaptive = false
+        var minBitrate: Int?
+        var maxBitrate: Int?
+        var hasTarget = false
 
         var i = 2
         while i < arguments.count {
             switch arguments[i] {
             case "--target", "-t":
-                if i + 1 < arguments.count {
-                    let parts = arguments[i + 1].split(separator: ":")
-                    config.targetHost = String(parts[0])
-                    if parts.count > 1, let port = UInt16(parts[1]) {
-                        config.targetPort = port
+                if i + 1 < arguments.count,
+                   let target = NetworkTarget(parsing: arguments[i + 1], defaultPort: config.targetPort) {
+                    // Repeated: fan-out, every target gets the same packets
+                    if hasTarget {
+                        config.extraTargets.append(target)
+                    } else {
+                        config.targetHost = target.host
+                        config.targetPort = target.port
+                        hasTarget = true
                     }
                     i += 1
                 }
 
+            case "--multicast-ttl":
+                if i + 1 < arguments.count, let ttl = Int(arguments[i + 1]), ttl > 0 {
+                    config.multicastTTL = ttl
+                    i += 1
+                }
+
+            case "--control-port":
+                if i + 1 < arguments.count, let port = UInt16(arguments[i + 1]) {
+                    config.controlPort = port
+                    i += 1
+                }
+
             case "--port", "-p":
                 if i + 1 < arguments.count, let port = UInt16(arguments[i + 1]) {
                     config.targetPort = port
@@ -84,12 +115,32 @@ struct NDIBridgeApp {
                     i += 1
                 }
 
+            case "--adaptive":
+                adaptive = true
+
+            case "--min-bitrate":
+                if i + 1 < arguments.count, let mbps = Double(arguments[i + 1]) {
+                    minBitrate = Int(mbps * 1_000_000)
+                    adaptive = true
+                    i += 1
+                }
+
+            case "--max-bitrate":
+                if i + 1 < arguments.count, let mbps = Double(arguments[i + 1]) {
+                    maxBitrate = Int(mbps * 1_000_000)
+                    adaptive = true
+                    i += 1
+                }
+
             case "--auto":
                 config.autoSelectFirstSource = true
 
+            case "--all":
+                config.bridgeAllSources = true
+
             case "--source", "-s":
                 if i + 1 < arguments.count {
-                    config.sourceName = arguments[i + 1]
+                    config.sourceNames.append(arguments[i + 1])
                     i += 1
                 }
 
@@ -99,12 +150,128 @@ struct NDIBridgeApp {
                     i += 1
                 }
 
+            case "--codec":
+                if i + 1 < arguments.count {
+                    guard let codec = VideoCodec(name: arguments[i + 1]) else {
+                        print("❌ Unknown codec: \(arguments[i + 1]) (use h264 or hevc)")
+                        exit(1)
+                    }
+                    config.encoder.codec = codec
+                    i += 1
+                }
+
+            case "--no-batch":
+                config.batchTransmit = false
+
+            case "--fec":
+                if i + 1 < arguments.count, let groupSize = Int(arguments[i + 1]) {
+                    config.fecGroupSize = min(max(0, groupSize), 255)
+                    i += 1
+                }
+
+            case "--retransmit-window":
+                if i + 1 < arguments.count, let ms = Int(arguments[i + 1]) {
+                    config.retransmitWindowMs = max(0, ms)
+                    i += 1
+                }
+
+            case "--pacing":
+                if i + 1 < arguments.count, let fraction = Double(arguments[i + 1]) {
+                    config.pacingFraction = min(max(0, fraction), 1)
+                    i += 1
+                }
+
+            case "--passthrough":
+                config.passthrough = true
+
+            case "--low-latency":
+                config.encoder.lowLatencyRateControl = true
+
+            case "--rendition":
+                if i + 1 < arguments.count {
+                    guard let rendition = VideoRenditionConfig(parsing: arguments[i + 1]) else {
+                        print("❌ Invalid rendition: \(arguments[i + 1]) (use WxH or WxH@mbps)")
+                        exit(1)
+                    }
+                    guard config.renditions.count + 1 < NetworkSender.maxLayers else {
+                        print("❌ At most \(NetworkSender.maxLayers - 1) renditions")
+                        exit(1)
+                    }
+                    config.renditions.append(rendition)
+                    i += 1
+                }
+
+            case "--slice-bytes":
+                if i + 1 < arguments.count, let bytes = Int(arguments[i + 1]) {
+                    config.encoder.maxSliceBytes = max(0, bytes)
+                    i += 1
+                }
+
+            case "--capture-queue":
+                if i + 1 < arguments.count, let depth = Int(arguments[i + 1]) {
+                    config.captureQueueDepth = min(max(1, depth), 64)
+                    i += 1
+                }
+
+            case "--drop-policy":
+                if i + 1 < arguments.count {
+                    guard let policy = RingDropPolicy(rawValue: arguments[i + 1]) else {
+                        print("❌ Unknown drop policy: \(arguments[i + 1]) (use oldest or newest)")
+                        exit(1)
+                    }
+                    config.captureDropPolicy = policy
+                    i += 1
+                }
+
+            case "--metrics-port":
+                if i + 1 < arguments.count, let port = UInt16(arguments[i + 1]) {
+                    config.metricsPort = port
+                    i += 1
+                }
+
+            case "--color":
+                if i + 1 < arguments.count {
+                    guard let format = NDIColorFormat(rawValue: arguments[i + 1].lowercased()) else {
+                        print("❌ Unknown color format: \(arguments[i + 1]) (use uyvy, bgra or fastest)")
+                        exit(1)
+                    }
+                    config.colorFormat = format
+                    i += 1
+                }
+
+            case "--audio-int16":
+                config.audioInt16 = true
+
+            case "--audio-codec":
+                if i + 1 < arguments.count {
+                    guard let codec = AudioCodec(name: arguments[i + 1]) else {
+                        print("❌ Unknown audio codec: \(arguments[i + 1]) (use pcm or aac-eld)")
+                        exit(1)
+                    }
+                    config.audioCodec = codec
+                    i += 1
+                }
+
+            case "--audio-bitrate":
+                if i + 1 < arguments.count, let kbps = Int(arguments[i + 1]) {
+                    config.audioBitratePerChannel = min(max(16, kbps), 256) * 1000
+                    i += 1
+                }
+
             default:
                 break
             }
             i += 1
         }
 
+        // Adaptive bitrate: --bitrate is the starting point, bounds default to [bitrate/4, bitrate]
+        if adaptive {
+            var bounds = BitrateControllerConfig()
+            bounds.maxBitrate = maxBitrate ?? config.encoder.bitrate
+            bounds.minBitrate = min(minBitrate ?? config.encoder.bitrate / 4, bounds.maxBitrate)
+            config.adaptiveBitrate = bounds
+        }
+
         // Create and start host mode
         hostMode = HostMode(config: config)
 
@@ -139,6 +306,22 @@ struct NDIBridgeApp {
                     i += 1
                 }
 
+            case "--layer":
+                if i + 1 < arguments.count, let layer = UInt8(arguments[i + 1]), Int(layer) < NetworkSender.maxLayers {
+                    config.layer = layer
+                    i += 1
+                }
+
+            case "--multicast":
+                if i + 1 < arguments.count {
+                    guard NetworkTarget(host: arguments[i + 1], port: 0).isMulticast else {
+                        print("❌ Not a multicast address: \(arguments[i + 1]) (use 224.0.0.0/4 or ff00::/8)")
+                        exit(1)
+                    }
+                    config.multicastGroup = arguments[i + 1]
+                    i += 1
+                }
+
             case "--name", "-n":
                 if i + 1 < arguments.count {
                     config.ndiOutputName = arguments[i + 1]
@@ -151,6 +334,54 @@ struct NDIBridgeApp {
                     i += 1
                 }
 
+            case "--buffer-max":
+                if i + 1 < arguments.count, let ms = Int(arguments[i + 1]) {
+                    config.bufferMaxMs = max(0, ms)
+                    i += 1
+                }
+
+            case "--nack":
+                if i + 1 < arguments.count, let ms = Int(arguments[i + 1]) {
+                    config.nackHoldMs = max(0, ms)
+                    i += 1
+                }
+
+            case "--latency":
+                config.measureLatency = true
+
+            case "--sync-send":
+                config.asyncSend = false
+
+            case "--output-format":
+                if i + 1 < arguments.count {
+                    guard let format = NDIOutputFormat(rawValue: arguments[i + 1].lowercased()) else {
+                        print("❌ Unknown output format: \(arguments[i + 1]) (use uyvy or bgra)")
+                        exit(1)
+                    }
+                    config.outputFormat = format
+                    i += 1
+                }
+
+            case "--scale":
+                // WxH, e.g. 1280x720
+                if i + 1 < arguments.count {
+                    let parts = arguments[i + 1].lowercased().split(separator: "x")
+                    guard parts.count == 2, let width = Int32(parts[0]), let height = Int32(parts[1]), width > 0, height > 0 else {
+                        print("❌ Invalid output size: \(arguments[i + 1]) (use WxH, e.g. 1280x720)")
+                        exit(1)
+                    }
+                    config.outputWidth = width
+                    config.outputHeight = height
+                    config.scaleOutput = true
+                    i += 1
+                }
+
+            case "--metrics-port":
+                if i + 1 < arguments.count, let port = UInt16(arguments[i + 1]) {
+                    config.metricsPort = port
+                    i += 1
+                }
+
             default:
                 break
             }
@@ -214,21 +445,54 @@ struct NDIBridgeApp {
         print("  ndi-bridge host [options]        Start in Host mode (sender)")
         print("  ndi-bridge join [options]        Start in Join mode (receiver)")
         print("  ndi-bridge discover              Discover NDI sources on network")
+        print("  ndi-bridge bench [name...]       Run microbenchmarks (--list to show them)")
+        print("  ndi-bridge bench loopback [opts] Soak run: synthetic source → encode → lossy UDP → decode, on 127.0.0.1")
         print("")
         print("Host Mode Options:")
-        print("  --target, -t <ip:port>           Target endpoint (default: 127.0.0.1:5990)")
+        print("  --target, -t <ip:port>           Target endpoint (default: 127.0.0.1:5990); repeat to fan out, may be a multicast group")
+        print("  --multicast-ttl <hops>           Hop limit of multicast targets (default: 8)")
+        print("  --control-port <port>            Port multicast Joins send NACKs/reports to (default: 5991)")
         print("  --port, -p <port>                Target port (default: 5990)")
         print("  --bitrate, -b <mbps>             Encoding bitrate in Mbps (default: 8)")
-        print("  --source, -s <name>              Select NDI source by name (partial match)")
+        print("  --source, -s <name>              Select NDI source by name (partial match, repeatable)")
         print("  --exclude, -x <pattern>          Exclude sources matching pattern (repeatable)")
         print("  --auto                           Auto-select first available source")
+        print("  --all                            Bridge every available source over the same port")
+        print("  --codec <h264|hevc>              Video codec (default: h264; hevc ~halves bandwidth on Apple Silicon)")
+        print("  --no-batch                       Send fragments one by one instead of batched per frame")
+        print("  --fec <n>                        Video FEC: 1 XOR parity packet per n fragments (overhead 1/n, 0 = off)")
+        print("  --retransmit-window <ms>         Keep sent frames for Join NACKs (default: 200, 0 = off)")
+        print("  --pacing <fraction>              Spread each frame over this part of the frame interval (default: 0.5, 0 = off)")
+        print("  --passthrough                    Forward NDI|HX H.264/HEVC without re-encoding (NDI Advanced SDK)")
+        print("  --low-latency                    VideoToolbox low-latency rate control: steady frame sizes, no encoder frame delay")
+        print("  --slice-bytes <n>                H.264: cap slices at n bytes, several slices per frame (default: 0 = off)")
+        print("  --rendition <WxH[@mbps]>         Simulcast: also encode a scaled layer (repeatable: layers 1, 2, 3)")
+        print("  --capture-queue <frames>         Captured frames buffered ahead of the encoder (default: 4)")
+        print("  --drop-policy <oldest|newest>    Frame dropped when the encoder falls behind (default: oldest)")
+        print("  --color <uyvy|bgra|fastest>      NDI receive pixel format (default: uyvy, half the bandwidth of bgra)")
+        print("  --audio-int16                    Send audio as 16-bit PCM instead of 32-bit float (half the audio bandwidth)")
+        print("  --audio-codec <pcm|aac-eld>      Compress audio with low-delay AAC-ELD for WAN links (default: pcm)")
+        print("  --audio-bitrate <kbps>           AAC-ELD bitrate per channel (default: 64)")
+        print("  --adaptive                       Adapt bitrate to Join loss/jitter reports, starting at --bitrate")
+        print("  --min-bitrate <mbps>             Adaptive lower bound (default: bitrate/4, implies --adaptive)")
+        print("  --max-bitrate <mbps>             Adaptive upper bound (default: bitrate, implies --adaptive)")
         print("")
         print("Join Mode Options:")
         print("  --port, -p <port>                Listen port (default: 5990)")
-        print("  --name, -n <name>                NDI output name (default: 'NDI Bridge Output')")
-        print("  --buffer, -b <ms>                Buffer delay in milliseconds (default: 0 = real-time)")
+        print("  --multicast <group>              Receive from a multicast group instead of a unicast stream")
+        print("  --layer <n>                      Simulcast rendition to receive (default: 0 = source resolution)")
+        print("  --name, -n <name>                NDI output name (default: 'NDI Bridge Output', '<name> 2'... per extra source)")
+        print("  --buffer, -b <ms>                Jitter buffer depth in milliseconds, from sender timestamps (default: 0 = real-time)")
+        print("  --buffer-max <ms>                Adapt the depth to measured jitter between --buffer and <ms>")
+        print("  --nack <ms>                      Re-request lost fragments, holding frames up to <ms> (default: 0 = off)")
+        print("  --latency                        Log per-stage latency p50/p95/p99 every 5s (Host capture → NDI output)")
+        print("  --output-format <uyvy|bgra>      NDI output pixel format (default: uyvy, converted on the GPU)")
+        print("  --scale <WxH>                    Scale the output to WxH (uyvy output only)")
+        print("  --sync-send                      Block in the NDI SDK until each video frame is sent (default: async)")
         print("")
         print("General Options:")
+        print("  --metrics-port <port>            Serve Prometheus /metrics and /metrics.json on this port (default: off)")
+        print("  --log-level <spec>               Minimum level, global or per subsystem (e.g. info, network=warning,video=debug)")
         print("  --help, -h                       Show this help")
         print("  --version, -v                    Show version")
         print("")
@@ -245,12 +509,49 @@ struct NDIBridgeApp {
         print("  # Host mode - stream to remote machine")
         print("  ndi-bridge host --source \"Camera\" --target 192.168.1.100:5990 --bitrate 15")
         print("")
+        print("  # Host mode - several sources in one process, one port")
+        print("  ndi-bridge host --source \"Cam A\" --source \"Cam B\" --target 192.168.1.100:5990")
+        print("")
+        print("  # Host mode - HEVC over a WAN link")
+        print("  ndi-bridge host --source \"Camera\" --target 203.0.113.7:5990 --codec hevc --bitrate 6")
+        print("")
+        print("  # Host mode - NDI|HX camera, no decode/re-encode")
+        print("  ndi-bridge host --source \"PTZ\" --target 203.0.113.7:5990 --passthrough")
+        print("")
+        print("  # Host mode - shared link, bitrate follows congestion between 3 and 12 Mbps")
+        print("  ndi-bridge host --source \"Camera\" --target 203.0.113.7:5990 --bitrate 8 --min-bitrate 3 --max-bitrate 12")
+        print("")
+        print("  # Host mode - lowest encode latency, 4 KB slices")
+        print("  ndi-bridge host --source \"Camera\" --target 192.168.1.100:5990 --low-latency --slice-bytes 4096")
+        print("")
+        print("  # Host mode - lossy WAN link, 10% FEC overhead")
+        print("  ndi-bridge host --source \"Camera\" --target 203.0.113.7:5990 --fec 10")
+        print("")
+        print("  # Host mode - one encode, two remote Joins and a LAN multicast group")
+        print("  ndi-bridge host --source \"Camera\" --target 192.168.1.100 --target 192.168.1.101 --target 239.1.1.1:5990")
+        print("")
         print("  # Join mode - receive and output as NDI")
         print("  ndi-bridge join --name \"Remote Camera\"")
         print("")
         print("  # Join mode - with 500ms buffer for stable playback")
         print("  ndi-bridge join --name \"Buffered Output\" --buffer 500")
         print("")
+        print("  # Host mode - 4K for the wall, 720p for a confidence monitor")
+        print("  ndi-bridge host --source \"Camera\" --target 192.168.1.100 --target 192.168.1.101 --rendition 1280x720@3")
+        print("  ndi-bridge join --layer 1 --name \"Confidence\"   # on 192.168.1.101")
+        print("")
+        print("  # Join mode - receive the multicast group")
+        print("  ndi-bridge join --multicast 239.1.1.1 --name \"Camera\"")
+        print("")
+        print("  # Join mode - lowest latency the link allows, up to 300ms")
+        print("  ndi-bridge join --buffer 20 --buffer-max 300")
+        print("")
+        print("  # Join mode - recover losses by retransmission (RTT well under 80ms)")
+        print("  ndi-bridge join --name \"Remote Camera\" --nack 80")
+        print("")
+        print("  # Soak run before a release - 60s of 1080p60 with 2% loss, recovered by NACK")
+        print("  ndi-bridge bench loopback --seconds 60 --loss 0.02 --jitter 5 --nack 80")
+        print("")
         print("  # Discover NDI sources")
         print("  ndi-bridge discover")
     }
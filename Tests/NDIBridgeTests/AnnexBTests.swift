@@ -0,0 +1,86 @@
+//
+//  AnnexBTests.swift
+//  NDI Bridge Mac
+//
+//  Start code scanning, AVCC → Annex-B conversion and decoder configuration records
+//
+
+import XCTest
+@testable import NDIBridge
+
+final class AnnexBTests: XCTestCase {
+    func testScannerFindsThreeAndFourByteStartCodes() {
+        let sps: [UInt8] = [0x67, 0x42, 0x00, 0x1F]
+        let pps: [UInt8] = [0x68, 0xCE, 0x3C, 0x80]
+        // Slice long enough for the 16-byte vector loop, zero runs without a start code
+        let slice: [UInt8] = [0x65] + (0..<100).map { $0 % 7 == 0 ? 0 : UInt8(truncatingIfNeeded: $0) } + [0x80]
+
+        let stream = Data([0, 0, 0, 1] + sps + [0, 0, 1] + pps + [0, 0, 0, 1] + slice)
+        let units = AnnexB.nalUnitRanges(in: stream).map { [UInt8](stream[$0]) }
+
+        XCTAssertEqual(units, [sps, pps, slice])
+    }
+
+    func testScannerKeepsSliceIndices() {
+        let stream = Data([0xAA, 0xBB, 0, 0, 0, 1, 0x41, 0x9A, 0, 0, 1, 0x41, 0x9B])
+        let slice = stream[2...]  // Non-zero startIndex
+        let ranges = AnnexB.nalUnitRanges(in: slice)
+
+        XCTAssertEqual(ranges.map { [UInt8](slice[$0]) }, [[0x41, 0x9A], [0x41, 0x9B]])
+    }
+
+    func testEncodedFrameAnnexBMatchesItsNALUnits() {
+        let sps = Data([0x67, 0x64, 0x00, 0x28, 0xAC])
+        let pps = Data([0x68, 0xEE, 0x3C, 0xB0])
+        let slices = [Data([0x65, 0x88, 0x84, 0x00, 0x33]), Data([0x65, 0x01, 0x02] + [UInt8](repeating: 0x55, count: 300))]
+
+        var avcc = Data()
+        for slice in slices {
+            withUnsafeBytes(of: UInt32(slice.count).bigEndian) { avcc.append(contentsOf: $0) }
+            avcc.append(slice)
+        }
+        let frame = EncodedVideoFrame(avcc: avcc, parameterSets: [sps, pps], codec: .h264,
+                                      isKeyframe: true, timestamp: 0, duration: 0)
+
+        let annexB = frame.annexB()
+        let units = AnnexB.nalUnitRanges(in: annexB).map { Data(annexB[$0]) }
+        XCTAssertEqual(units, [sps, pps] + slices)
+    }
+
+    func testAVCConfigurationRecord() {
+        let sps: [UInt8] = [0x67, 0x64, 0x00, 0x28]
+        let pps: [UInt8] = [0x68, 0xEE, 0x3C]
+        let record: [UInt8] = [1, 0x64, 0x00, 0x28, 0xFF, 0xE1, 0, 4] + sps + [1, 0, 3] + pps
+
+        let sets = record.withUnsafeBytes { bytes in
+            AnnexB.parameterSets(fromConfigurationRecord: bytes, codec: .h264)?.map { Array(bytes[$0]) }
+        }
+        XCTAssertEqual(sets, [sps, pps])
+    }
+
+    func testHEVCConfigurationRecord() {
+        let vps: [UInt8] = [0x40, 0x01, 0x0C]
+        let sps: [UInt8] = [0x42, 0x01, 0x01, 0x01]
+        let pps: [UInt8] = [0x44, 0x01, 0xC1]
+        var record: [UInt8] = [1] + [UInt8](repeating: 0, count: 21) + [3]
+        for (type, nal) in [(UInt8(32), vps), (33, sps), (34, pps)] {
+            record += [0x80 | type, 0, 1, 0, UInt8(nal.count)] + nal
+        }
+
+        let sets = record.withUnsafeBytes { bytes in
+            AnnexB.parameterSets(fromConfigurationRecord: bytes, codec: .hevc)?.map { Array(bytes[$0]) }
+        }
+        XCTAssertEqual(sets, [vps, sps, pps])
+    }
+
+    func testConfigurationRecordRejectsAnnexBAndTruncation() {
+        let annexB: [UInt8] = [0, 0, 0, 1, 0x67, 0x42, 0x00, 0x1F]
+        let truncated: [UInt8] = [1, 0x64, 0x00, 0x28, 0xFF, 0xE1, 0, 40, 0x67]
+
+        for input in [annexB, truncated] {
+            input.withUnsafeBytes { bytes in
+                XCTAssertNil(AnnexB.parameterSets(fromConfigurationRecord: bytes, codec: .h264))
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+//
+//  BitrateControllerTests.swift
+//  NDI Bridge Mac
+//
+//  Receiver report rounds across several Joins
+//
+
+import XCTest
+@testable import NDIBridge
+
+final class BitrateControllerTests: XCTestCase {
+    private let joinA = NSObject()
+    private let joinB = NSObject()
+
+    private func report(expected: UInt32, lost: UInt32) -> ReceiverReport {
+        return ReceiverReport(intervalMs: 500, packetsExpected: expected, packetsLost: lost)
+    }
+
+    func testSingleJoinUpdatesOnEveryReport() {
+        let controller = BitrateController(initialBitrate: 4_000_000, config: BitrateControllerConfig())
+        let peer = ObjectIdentifier(joinA)
+
+        XCTAssertEqual(controller.add(report(expected: 1000, lost: 0), from: peer, now: 10), 4_200_000)
+        XCTAssertEqual(controller.add(report(expected: 1000, lost: 0), from: peer, now: 10.5), 4_410_000)
+    }
+
+    func testRoundWaitsForEveryJoinAndMergesTheirLoss() {
+        let controller = BitrateController(initialBitrate: 4_000_000, config: BitrateControllerConfig())
+        let a = ObjectIdentifier(joinA)
+        let b = ObjectIdentifier(joinB)
+        _ = controller.add(report(expected: 1000, lost: 0), from: a, now: 10)
+
+        // B's lossy report opens a round that A's clean one closes: one cut, not probe then cut
+        XCTAssertNil(controller.add(report(expected: 1000, lost: 200), from: b, now: 10.4))
+        let bitrate = controller.add(report(expected: 1000, lost: 0), from: a, now: 10.5)
+        XCTAssertEqual(bitrate, Int(4_200_000 * 0.9))
+    }
+
+    func testSilentJoinDoesNotHoldTheRoundOpen() {
+        let controller = BitrateController(initialBitrate: 4_000_000, config: BitrateControllerConfig())
+        let a = ObjectIdentifier(joinA)
+        let b = ObjectIdentifier(joinB)
+        _ = controller.add(report(expected: 1000, lost: 0), from: b, now: 10)
+        XCTAssertNil(controller.add(report(expected: 1000, lost: 0), from: a, now: 10))
+
+        // B went away: the round closes a report interval after it opened
+        XCTAssertEqual(controller.add(report(expected: 1000, lost: 0), from: a, now: 10.5), 4_410_000)
+    }
+}
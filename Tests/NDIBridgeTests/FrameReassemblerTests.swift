@@ -0,0 +1,156 @@
+//
+//  FrameReassemblerTests.swift
+//  NDI Bridge Mac
+//
+//  Reassembly round trips, reordering, FEC recovery and header validation
+//
+
+import XCTest
+@testable import NDIBridge
+
+final class FrameReassemblerTests: XCTestCase {
+    private let payloadSize = 1400 - MediaPacketHeader.size  // Default sender MTU
+
+    /// Fragments of `frame` as the sender cuts them, followed by one parity packet per
+    /// `fecGroupSize` fragments when FEC is on
+    private func packets(of frame: Data, sequence: UInt32, fecGroupSize: Int = 0) -> [(ParsedMediaHeader, Data)] {
+        let fragments = stride(from: 0, to: frame.count, by: payloadSize).map {
+            frame[$0..<min($0 + payloadSize, frame.count)]
+        }
+
+        var header = ParsedMediaHeader()
+        header.version = 2
+        header.sequenceNumber = sequence
+        header.timestamp = UInt64(sequence) * 166_666
+        header.totalSize = UInt32(frame.count)
+        header.fragmentCount = UInt16(fragments.count)
+        header.fecGroupSize = UInt8(fecGroupSize)
+
+        var result: [(ParsedMediaHeader, Data)] = []
+        for (index, payload) in fragments.enumerated() {
+            header.fragmentIndex = UInt16(index)
+            header.payloadSize = UInt16(payload.count)
+            result.append((header, payload))
+        }
+
+        header.flags |= XORParity.parityFlag
+        for group in 0..<XORParity.groupCount(fragmentCount: fragments.count, groupSize: fecGroupSize) {
+            let members = XORParity.members(ofGroup: group, fragmentCount: fragments.count, groupSize: fecGroupSize)
+            var parity = Data(count: fragments[members.lowerBound].count)
+            parity.withUnsafeMutableBytes { (acc: UnsafeMutableRawBufferPointer) in
+                for member in members {
+                    fragments[member].withUnsafeBytes { XORParity.accumulate(acc.baseAddress!, $0.baseAddress!, count: $0.count) }
+                }
+            }
+            header.fragmentIndex = UInt16(group)
+            header.payloadSize = UInt16(parity.count)
+            result.append((header, parity))
+        }
+        return result
+    }
+
+    private func frame(size: Int, seed: Int) -> Data {
+        return Data((0..<size).map { UInt8(truncatingIfNeeded: $0 &* 31 &+ seed) })
+    }
+
+    func testInOrderRoundTrip() {
+        let reassembler = FrameReassembler()
+        let sent = frame(size: 1_000_000, seed: 1)
+
+        var received: [ReassembledFrame] = []
+        for (header, payload) in packets(of: sent, sequence: 1) {
+            received += reassembler.addFragment(header: header, payload: payload, now: 0)
+        }
+
+        XCTAssertEqual(received.count, 1)
+        XCTAssertEqual(received.first?.data, sent)
+        XCTAssertEqual(reassembler.droppedFrames, 0)
+    }
+
+    func testOvertakingFrameDoesNotCostTheOlderOne() {
+        let reassembler = FrameReassembler()
+        let large = frame(size: 20_000, seed: 2)
+        let small = frame(size: 900, seed: 3)
+        var first = packets(of: large, sequence: 1)
+        let tail = first.removeLast()
+
+        var received: [ReassembledFrame] = []
+        for (header, payload) in first {
+            received += reassembler.addFragment(header: header, payload: payload, now: 0)
+        }
+        for (header, payload) in packets(of: small, sequence: 2) {
+            received += reassembler.addFragment(header: header, payload: payload, now: 0.001)
+        }
+        XCTAssertTrue(received.isEmpty, "the complete newer frame waits for the older one")
+
+        received += reassembler.addFragment(header: tail.0, payload: tail.1, now: 0.002)
+        XCTAssertEqual(received.map { $0.sequenceNumber }, [1, 2])
+        XCTAssertEqual(received.first?.data, large)
+        XCTAssertEqual(reassembler.droppedFrames, 0)
+    }
+
+    func testIncompleteFrameAbandonedAfterHold() {
+        let reassembler = FrameReassembler()
+        var first = packets(of: frame(size: 20_000, seed: 4), sequence: 1)
+        first.removeLast()
+        for (header, payload) in first {
+            _ = reassembler.addFragment(header: header, payload: payload, now: 0)
+        }
+
+        let second = packets(of: frame(size: 900, seed: 5), sequence: 2)
+        XCTAssertTrue(reassembler.addFragment(header: second[0].0, payload: second[0].1, now: 0.001).isEmpty)
+
+        // Any later packet past the hold releases the newer frame and abandons the older one
+        let third = packets(of: frame(size: 20_000, seed: 6), sequence: 3)
+        let released = reassembler.addFragment(header: third[0].0, payload: third[0].1,
+                                               now: 0.001 + 2 * FrameReassembler.reorderHoldTime)
+        XCTAssertEqual(released.map { $0.sequenceNumber }, [2])
+        XCTAssertEqual(reassembler.droppedFrames, 1)
+    }
+
+    func testParityRecoversOneLostFragmentPerGroup() {
+        let reassembler = FrameReassembler()
+        let sent = frame(size: 100_000, seed: 7)
+        let all = packets(of: sent, sequence: 1, fecGroupSize: 10)
+
+        // Lose fragment 3 (group 0) and the last data fragment (last group)
+        let fragmentCount = Int(all[0].0.fragmentCount)
+        let lost: Set<Int> = [3, fragmentCount - 1]
+
+        var received: [ReassembledFrame] = []
+        for (index, packet) in all.enumerated() where !lost.contains(index) {
+            received += reassembler.addFragment(header: packet.0, payload: packet.1, now: 0)
+        }
+
+        XCTAssertEqual(received.count, 1)
+        XCTAssertEqual(received.first?.data, sent)
+        XCTAssertEqual(reassembler.recoveredFragments, 2)
+    }
+
+    func testImpossibleHeadersAreRejected() {
+        var header = ParsedMediaHeader()
+        header.version = 2
+        header.totalSize = 1000
+        header.fragmentCount = 1
+        XCTAssertTrue(FrameReassembler.isPlausible(header))
+
+        var noFragments = header
+        noFragments.fragmentCount = 0
+        var empty = header
+        empty.totalSize = 0
+        var oversized = header
+        oversized.totalSize = 0xFFFF_FFFF
+        oversized.fragmentCount = 0xFFFF
+        var indexOutOfRange = header
+        indexOutOfRange.fragmentIndex = 1
+        var tooBigForFragments = header
+        tooBigForFragments.totalSize = UInt32(FrameReassembler.maxFragmentPayload + 1)
+
+        let reassembler = FrameReassembler()
+        for bad in [noFragments, empty, oversized, indexOutOfRange, tooBigForFragments] {
+            XCTAssertFalse(FrameReassembler.isPlausible(bad))
+            XCTAssertTrue(reassembler.addFragment(header: bad, payload: Data(count: 10), now: 0).isEmpty)
+        }
+        XCTAssertEqual(reassembler.malformedPackets, 5)
+    }
+}
@@ -5,7 +5,7 @@
 
 const dgram = require('dgram');
 const EventEmitter = require('events');
-const { parseHeader, extractPayload, MediaType, timestampToMs } = require('./protocol');
+const { parseHeader, extractPayload, MediaType, VideoCodec, timestampToMs } = require('./protocol');
 
 /**
  * Frame reassembler - collects fragments and emits complete frames
@@ -151,6 +151,29 @@ class NetworkReceiver extends EventEmitter {
         this.stats.packetsReceived++;
         this.stats.bytesReceived += buffer.length;
 
+        // FEC parity packets (host --fec) are not used by this client
+        if (header.isParity) {
+            return;
+        }
+
+        // Single output: only the first source of a multi-source Host is played
+        if (header.sourceId !== 0) {
+            if (!this.warnedSource) {
+                console.warn(`[NetworkReceiver] Multi-source stream, ignoring source ${header.sourceId} (Swift Join outputs every source)`);
+                this.warnedSource = true;
+            }
+            return;
+        }
+
+        // The FFmpeg decoder here is fed H.264 only (host --codec hevc needs the Swift Join)
+        if (header.mediaType === MediaType.VIDEO && header.codec !== VideoCodec.H264) {
+            if (!this.warnedCodec) {
+                console.warn(`[NetworkReceiver] Unsupported video codec ${header.codec}, dropping video`);
+                this.warnedCodec = true;
+            }
+            return;
+        }
+
         // Extract payload
         const payload = extractPayload(buffer, header);
 
@@ -11,7 +11,24 @@ const VERSION = 2;
 // Media types
 const MediaType = {
     VIDEO: 0,
-    AUDIO: 1
+    AUDIO: 1,
+    PARAMETER_SETS: 2  // AVCC streams only - never sent to this client
+};
+
+// Header flag bits
+// AVCC is only used for receivers that advertise it in a capabilities hello;
+// this client never does, so the Host keeps sending it Annex-B
+const Flags = {
+    KEYFRAME: 0x01,
+    FEC_PARITY: 0x02,
+    AVCC: 0x04,
+    RETRANSMIT: 0x08
+};
+
+// Video codecs (header byte 36)
+const VideoCodec = {
+    H264: 0,
+    HEVC: 1
 };
 
 // Timestamp scale (10 million ticks per second)
@@ -56,9 +73,11 @@ function parseHeader(buffer) {
         // Audio-specific fields (v2 only)
         sampleRate: version >= 2 ? buffer.readUInt32BE(30) : 0,
         channels: version >= 2 ? buffer.readUInt8(34) : 0,
+        codec: version >= 2 ? buffer.readUInt8(36) : VideoCodec.H264,
         // Computed
         headerSize,
-        isKeyframe: (buffer.readUInt8(7) & 0x01) === 1
+        isKeyframe: (buffer.readUInt8(7) & Flags.KEYFRAME) !== 0,
+        isParity: (buffer.readUInt8(7) & Flags.FEC_PARITY) !== 0
     };
 }
 
@@ -95,6 +114,8 @@ module.exports = {
     HEADER_SIZE,
     VERSION,
     MediaType,
+    Flags,
+    VideoCodec,
     TIMESTAMP_SCALE,
     parseHeader,
     extractPayload,